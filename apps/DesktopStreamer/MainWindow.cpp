@@ -104,6 +104,8 @@ MainWindow::MainWindow()
     connect(_streamButton, &QPushButton::clicked, this, &MainWindow::_update);
     connect(_streamButton, &QPushButton::clicked, _actionMultiWindowMode,
             &QAction::setDisabled);
+    connect(_streamButton, &QPushButton::clicked, _actionAllScreensMode,
+            &QAction::setDisabled);
 
     connect(_remoteControlCheckBox, &QCheckBox::clicked, this,
             &MainWindow::_onStreamEventsBoxClicked);
@@ -271,9 +273,10 @@ void MainWindow::_updateMultipleStreams()
     StreamMap streams;
     for (const auto& index : windowIndices)
     {
-        if (_streams.count(index))
+        const auto stream = _streams.find(index);
+        if (stream != _streams.end())
         {
-            streams[index] = _streams[index];
+            streams.emplace(index, stream->second);
             continue;
         }
 
@@ -319,11 +322,22 @@ void MainWindow::_updateSingleStream()
 
     try
     {
-        _streams.emplace(index, _makeStream(index, streamId, host, pid));
+        if (_actionAllScreensMode->isChecked())
+        {
+            // Each screen is captured in parallel as a source of the stream
+            for (auto screen : QApplication::screens())
+            {
+                _streams.emplace(index, _makeStream(index, streamId, host, pid,
+                                                    screen));
+            }
+        }
+        else
+            _streams.emplace(index, _makeStream(index, streamId, host, pid));
         _startStreaming();
     }
     catch (const std::runtime_error& e)
     {
+        _streams.clear();
         _showConnectionErrorStatus(e.what());
     }
 }
@@ -331,11 +345,14 @@ void MainWindow::_updateSingleStream()
 MainWindow::StreamPtr MainWindow::_makeStream(const QPersistentModelIndex index,
                                               const std::string& id,
                                               const std::string& host,
-                                              const int pid) const
+                                              const int pid,
+                                              QScreen* screen) const
 {
-    auto stream = std::make_shared<Stream>(*this, index, id, host, pid);
+    auto stream = std::make_shared<Stream>(*this, index, id, host, pid, screen);
 
-    if (_remoteControlCheckBox->isChecked())
+    // Only one source of a stream can receive its events
+    const bool primary = !screen || screen == QApplication::primaryScreen();
+    if (_remoteControlCheckBox->isChecked() && primary)
         stream->registerForEvents();
 
     return stream;
@@ -55,6 +55,7 @@
 #include <map>
 #include <memory>
 
+class QScreen;
 class Stream;
 
 class MainWindow : public QMainWindow, public Ui::MainWindow
@@ -81,7 +82,8 @@ private slots:
 private:
     typedef std::shared_ptr<Stream> StreamPtr;
     typedef std::shared_ptr<const Stream> ConstStreamPtr;
-    typedef std::map<QPersistentModelIndex, StreamPtr> StreamMap;
+    // The desktop has one stream per screen in all-screens mode
+    typedef std::multimap<QPersistentModelIndex, StreamPtr> StreamMap;
     StreamMap _streams;
     uint32_t _streamID;
 
@@ -106,7 +108,8 @@ private:
     void _updateSingleStream();
     void _showConnectionErrorStatus(const QString& message);
     StreamPtr _makeStream(QPersistentModelIndex index, const std::string& id,
-                          const std::string& host, int pid) const;
+                          const std::string& host, int pid,
+                          QScreen* screen = nullptr) const;
 
     void _deselect(ConstStreamPtr stream);
     void _processStreamEvents();
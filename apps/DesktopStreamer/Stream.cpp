@@ -50,8 +50,13 @@
 #include <ApplicationServices/ApplicationServices.h>
 #endif
 #endif
-#include <QPainter>
+#ifdef DESKTOPSTREAMER_USE_X11CAPTURE
+#include "X11Capture.h"
+#include <iostream>
+#endif
+#include <QFutureWatcher>
 #include <QScreen>
+#include <QtConcurrentRun>
 #include <queue>
 
 namespace
@@ -59,27 +64,74 @@ namespace
 const char* CURSOR_IMAGE_FILE = ":/cursor.png";
 const int CURSOR_IMAGE_SIZE = 20;
 const int CURSOR_TIMEOUT_MS = 1000;
+#ifdef DESKTOPSTREAMER_USE_X11CAPTURE
+const int TILE_SIZE = 512; // aligned with the segments of the Stream
+#endif
 }
 
 class Stream::Impl
 {
 public:
     Impl(Stream& stream, const MainWindow& parent,
-         const QPersistentModelIndex window, const int pid)
+         const QPersistentModelIndex window, const int pid, QScreen* screen)
         : _stream(stream)
         , _parent(parent)
         , _window(window)
+        , _screen(screen)
         , _cursor(QImage(CURSOR_IMAGE_FILE)
                       .scaled(CURSOR_IMAGE_SIZE, CURSOR_IMAGE_SIZE,
-                              Qt::KeepAspectRatio))
+                              Qt::KeepAspectRatio)
+                      .convertToFormat(QImage::Format_RGBA8888))
         , _pid(pid)
     {
         _mouseActiveTimer.setSingleShot(true);
         _mouseActiveTimer.setInterval(CURSOR_TIMEOUT_MS);
+
+        // Send the screen as soon as the worker has compared it
+        QObject::connect(&_pendingCapture, &QFutureWatcherBase::finished,
+                         [this] { _sendPendingCapture(); });
+
+        // The cursor is drawn by the server, only its position is updated
+        if (_hasCursor())
+        {
+            deflect::ImageWrapper cursor(_cursor.constBits(), _cursor.width(),
+                                         _cursor.height(), deflect::RGBA);
+            cursor.compressionPolicy = deflect::COMPRESSION_OFF;
+            _stream.sendCursorShape(cursor, _cursor.width() / 2,
+                                    _cursor.height() / 2);
+        }
+
+        // The sources of the screens are placed in the whole virtual desktop
+        QRect captureArea;
+        if (_screen)
+        {
+            const auto ratio = _screen->devicePixelRatio();
+            const auto geometry = _screen->geometry();
+            _windowRect = _screen->virtualGeometry();
+            _offset = (geometry.topLeft() - _windowRect.topLeft()) * ratio;
+            captureArea = QRect(geometry.topLeft() * ratio,
+                                geometry.size() * ratio);
+        }
+
+#ifdef DESKTOPSTREAMER_USE_X11CAPTURE
+        if (!_window.isValid() || _window.row() == 0)
+        {
+            try
+            {
+                _capture.reset(new X11Capture(captureArea));
+            }
+            catch (const std::runtime_error& e)
+            {
+                std::cerr << "Falling back to Qt desktop capture: " << e.what()
+                          << std::endl;
+            }
+        }
+#endif
     }
 
     ~Impl()
     {
+        _pendingCapture.waitForFinished();
         if (_lastSend.valid())
             _lastSend.get();
     }
@@ -135,6 +187,19 @@ public:
     std::string update(const int quality,
                        const deflect::ChromaSubsampling subsamp)
     {
+        if (_screen)
+            return _updateScreen(quality, subsamp);
+#ifdef DESKTOPSTREAMER_USE_X11CAPTURE
+        if (_capture)
+        {
+            const auto error = _updateFromCapture(quality, subsamp);
+            _windowRect =
+                QRect(0, 0, _image.width() / _parent.devicePixelRatio(),
+                      _image.height() / _parent.devicePixelRatio());
+            _sendCursor(true);
+            return error;
+        }
+#endif
         QPixmap pixmap;
 
         if (!_window.isValid() || _window.row() == 0)
@@ -158,34 +223,16 @@ public:
         if (pixmap.isNull())
             return "Got no pixmap for desktop or window";
 
-        QImage image = pixmap.toImage();
+        bool showCursor = true;
 #ifdef DEFLECT_USE_QT5MACEXTRAS
         const QAbstractItemModel* model = _parent.getItemModel();
-        // render mouse cursor only on active window and full desktop streams
-        if (DesktopWindowsModel::isActive(_pid) ||
-            model->data(_window, Qt::DisplayRole) == "Desktop")
+        // show mouse cursor only on active window and full desktop streams
+        showCursor = DesktopWindowsModel::isActive(_pid) ||
+                     model->data(_window, Qt::DisplayRole) == "Desktop";
 #endif
-        {
-            const QPoint mousePos =
-                (QCursor::pos() - _windowRect.topLeft()) *
-                    _parent.devicePixelRatio() -
-                QPoint(_cursor.width() / 2, _cursor.height() / 2);
-            if (mousePos != _mousePos || _mouseActiveTimer.isActive())
-            {
-                QPainter painter(&image);
-                painter.drawImage(mousePos, _cursor);
-                painter.end(); // Make sure to release the QImage before using
-                               // it
-
-                if (mousePos != _mousePos)
-                {
-                    _mousePos = mousePos;
-                    _mouseActiveTimer.stop();
-                    _mouseActiveTimer.start();
-                }
-            }
-        }
+        _sendCursor(showCursor);
 
+        const QImage image = pixmap.toImage();
         if (image == _image)
             return std::string(); // OPT: Image is unchanged
 
@@ -206,6 +253,215 @@ public:
         return std::string();
     }
 
+    /**
+     * Only one source of the stream sends the cursor, if the server can draw
+     * it.
+     */
+    bool _hasCursor() const
+    {
+        return (!_screen || _screen == QApplication::primaryScreen()) &&
+               _stream.supportsFrameUpdates();
+    }
+
+    /** The changes of the image of a source since its previous frame. */
+    struct ScreenCapture
+    {
+        std::string error;
+        QRegion changed;
+        bool keyframe = false;
+    };
+
+    /**
+     * Capture the screen of this source and compare it with the previous
+     * frame in a worker thread, so that the sources of all the screens are
+     * processed in parallel. The frame is sent from the GUI thread once done.
+     * @return the result of the previous update.
+     */
+    std::string _updateScreen(const int quality,
+                              const deflect::ChromaSubsampling subsamp)
+    {
+        _sendPendingCapture();
+        if (!_captureError.empty())
+            return _captureError;
+
+        _sendCursor(true);
+
+        // QPixmap can only be used in the GUI thread
+        QImage grabbed;
+#ifdef DESKTOPSTREAMER_USE_X11CAPTURE
+        if (!_capture)
+#endif
+            grabbed = _screen->grabWindow(0).toImage();
+
+        _quality = quality;
+        _subsamp = subsamp;
+        _captureSent = false;
+        _pendingCapture.setFuture(QtConcurrent::run(
+            [this, grabbed] { return _captureScreen(grabbed); }));
+        return std::string();
+    }
+
+    /** Compare the grabbed screen with the previous frame, in the worker. */
+    ScreenCapture _captureScreen(const QImage& grabbed)
+    {
+        ScreenCapture capture;
+        if (!_waitForLastSend())
+        {
+            capture.error = "Streaming failure, connection closed";
+            return capture;
+        }
+#ifdef DESKTOPSTREAMER_USE_X11CAPTURE
+        if (_capture)
+            return _captureFromX11();
+#endif
+        if (grabbed.isNull())
+            capture.error = "Got no pixmap for screen";
+        else if (grabbed != _image)
+        {
+            _image = grabbed;
+            capture.changed = _image.rect();
+            capture.keyframe = true;
+        }
+        return capture;
+    }
+
+    /** Send the frame of the last capture of the screen, in the GUI thread. */
+    void _sendPendingCapture()
+    {
+        if (_captureSent)
+            return;
+        _captureSent = true;
+        _captureError =
+            _sendCapture(_pendingCapture.future().result(), _quality, _subsamp);
+    }
+
+    /** The pixels of the previous frame can be updated once it is sent. */
+    bool _waitForLastSend()
+    {
+        return !_lastSend.valid() || _lastSend.get();
+    }
+
+    std::string _sendCapture(const ScreenCapture& capture, const int quality,
+                             const deflect::ChromaSubsampling subsamp)
+    {
+        if (!capture.error.empty())
+            return capture.error;
+
+        const bool updates = _stream.supportsFrameUpdates();
+        if (capture.changed.isEmpty())
+        {
+            // The other sources of a screen wait for this one to finish frames
+            if (_screen && updates)
+                _lastSend = _stream.finishFrame(deflect::FrameUpdate::partial);
+            else if (_screen)
+                _lastSend = _sendKeyframe(quality, subsamp);
+            return std::string(); // OPT: Screen is unchanged
+        }
+
+#ifdef DESKTOPSTREAMER_USE_X11CAPTURE
+        if (!capture.keyframe && updates)
+        {
+            _lastSend = _sendChangedTiles(capture.changed, quality, subsamp);
+            return std::string();
+        }
+#endif
+        _lastSend = _sendKeyframe(quality, subsamp);
+        return std::string();
+    }
+
+    /** Send the cursor position, hiding it after a while without moving. */
+    void _sendCursor(const bool show)
+    {
+        if (!_hasCursor())
+            return;
+
+        const QPoint mousePos = (QCursor::pos() - _windowRect.topLeft()) *
+                                _parent.devicePixelRatio();
+        const bool moved = mousePos != _mousePos;
+        if (moved)
+        {
+            _mousePos = mousePos;
+            _mouseActiveTimer.stop();
+            _mouseActiveTimer.start();
+        }
+
+        const bool visible = show && _mouseActiveTimer.isActive();
+        if (visible == _cursorVisible && (!moved || !visible))
+            return; // OPT: Cursor is unchanged
+
+        _cursorVisible = visible;
+        _stream.sendCursorPosition(mousePos.x(), mousePos.y(), visible);
+    }
+
+    deflect::Stream::Future _sendKeyframe(
+        const int quality, const deflect::ChromaSubsampling subsamp)
+    {
+        deflect::ImageWrapper deflectImage(_image.constBits(), _image.width(),
+                                           _image.height(), deflect::BGRA,
+                                           _offset.x(), _offset.y());
+        _setCompression(deflectImage, quality, subsamp);
+        _stream.send(deflectImage);
+        return _stream.finishFrame(deflect::FrameUpdate::keyframe);
+    }
+
+    static void _setCompression(deflect::ImageWrapper& image,
+                                const int quality,
+                                const deflect::ChromaSubsampling subsamp)
+    {
+        image.compressionPolicy = deflect::COMPRESSION_ON;
+        image.compressionQuality = std::max(1, std::min(quality, 100));
+        image.subsampling = subsamp;
+    }
+
+#ifdef DESKTOPSTREAMER_USE_X11CAPTURE
+    std::string _updateFromCapture(const int quality,
+                                   const deflect::ChromaSubsampling subsamp)
+    {
+        // The pixels of the previous frame are about to be updated
+        if (!_waitForLastSend())
+            return "Streaming failure, connection closed";
+
+        return _sendCapture(_captureFromX11(), quality, subsamp);
+    }
+
+    ScreenCapture _captureFromX11()
+    {
+        ScreenCapture capture;
+        const QSize previousSize = _image.size();
+        capture.changed = _capture->update(_image);
+        capture.keyframe = _image.size() != previousSize;
+        return capture;
+    }
+
+    deflect::Stream::Future _sendChangedTiles(
+        const QRegion& changed, const int quality,
+        const deflect::ChromaSubsampling subsamp)
+    {
+        _tiles.clear();
+        for (int y = 0; y < _image.height(); y += TILE_SIZE)
+        {
+            for (int x = 0; x < _image.width(); x += TILE_SIZE)
+            {
+                const QRect tile =
+                    QRect(x, y, TILE_SIZE, TILE_SIZE) & _image.rect();
+                if (!changed.intersects(tile))
+                    continue;
+
+                _tiles.push_back(_image.copy(tile));
+                deflect::ImageWrapper deflectImage(_tiles.back().constBits(),
+                                                   tile.width(), tile.height(),
+                                                   deflect::BGRA,
+                                                   _offset.x() + tile.x(),
+                                                   _offset.y() + tile.y());
+                _setCompression(deflectImage, quality, subsamp);
+                _stream.send(deflectImage);
+            }
+        }
+        // The server keeps the segments of the tiles that did not change
+        return _stream.finishFrame(deflect::FrameUpdate::partial);
+    }
+#endif
+
 #ifdef __APPLE__
     void _sendMouseEvent(const CGEventType type, const CGMouseButton button,
                          const CGPoint point)
@@ -292,6 +548,8 @@ public:
     Stream& _stream;
     const MainWindow& _parent;
     const QPersistentModelIndex _window;
+    QScreen* const _screen; // source of a single screen, nullptr otherwise
+    QPoint _offset;         // position of the screen in the stream in pixels
     QRect _windowRect; // position on host in non-retina coordinates
     const QImage _cursor;
     QImage _image;
@@ -302,15 +560,27 @@ public:
 #endif
 
     deflect::Stream::Future _lastSend;
+    QFutureWatcher<ScreenCapture> _pendingCapture;
+    bool _captureSent = true;
+    std::string _captureError;
+    int _quality = 0;
+    deflect::ChromaSubsampling _subsamp = deflect::ChromaSubsampling::YUV444;
 
     QTimer _mouseActiveTimer;
     QPoint _mousePos;
+    bool _cursorVisible = false;
+
+#ifdef DESKTOPSTREAMER_USE_X11CAPTURE
+    std::unique_ptr<X11Capture> _capture;
+    std::vector<QImage> _tiles;
+#endif
 };
 
 Stream::Stream(const MainWindow& parent, const QPersistentModelIndex window,
-               const std::string& name, const std::string& host, const int pid)
+               const std::string& name, const std::string& host, const int pid,
+               QScreen* screen)
     : deflect::Stream(name, host)
-    , _impl(new Impl(*this, parent, window, pid))
+    , _impl(new Impl(*this, parent, window, pid, screen))
 {
 }
 
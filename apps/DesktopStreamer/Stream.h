@@ -46,13 +46,21 @@
 #include <deflect/Stream.h>      // base class
 
 class MainWindow;
+class QScreen;
 
 class Stream : public deflect::Stream
 {
 public:
-    /** Construct a new stream for the given desktop window. */
+    /**
+     * Construct a new stream for the given desktop window.
+     *
+     * @param screen if not null, capture only this screen of the desktop. The
+     *        streams of all the screens use the same id, each being one source
+     *        placed at the position of its screen in the virtual desktop.
+     */
     Stream(const MainWindow& parent, const QPersistentModelIndex window,
-           const std::string& id, const std::string& host, int pid = 0);
+           const std::string& id, const std::string& host, int pid = 0,
+           QScreen* screen = nullptr);
     ~Stream();
 
     /**
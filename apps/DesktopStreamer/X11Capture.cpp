@@ -0,0 +1,266 @@
+/*********************************************************************/
+/* Copyright (c) 2017, EPFL/Blue Brain Project                       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "X11Capture.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include <poll.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+// X11 headers define macros (None, Bool, Status...) which conflict with Qt,
+// include them last.
+#include <X11/Xlib.h>
+#include <X11/extensions/XShm.h>
+#include <X11/extensions/Xdamage.h>
+
+namespace
+{
+const int POLL_TIMEOUT_MS = 5;
+const int BYTES_PER_PIXEL = 4;
+
+void _copy(const char* src, const int srcPitch, QImage& dst, const QRect& rect)
+{
+    const int lineSize = rect.width() * BYTES_PER_PIXEL;
+    for (int y = rect.top(); y <= rect.bottom(); ++y)
+    {
+        std::memcpy(dst.scanLine(y) + rect.x() * BYTES_PER_PIXEL,
+                    src + y * srcPitch + rect.x() * BYTES_PER_PIXEL, lineSize);
+    }
+}
+}
+
+struct X11Capture::XResources
+{
+    Display* display = nullptr;
+    Window root = 0;
+    QRect area;
+    XShmSegmentInfo shmInfo;
+    XImage* image = nullptr;
+    Damage damage = 0;
+    int damageEventBase = 0;
+
+    explicit XResources(const QRect& area_)
+        : area(area_)
+    {
+        shmInfo.shmid = -1;
+        shmInfo.shmaddr = nullptr;
+
+        display = XOpenDisplay(nullptr);
+        if (!display)
+            throw std::runtime_error("Could not open the X display");
+
+        try
+        {
+            _init();
+        }
+        catch (...)
+        {
+            _release();
+            throw;
+        }
+    }
+
+    ~XResources() { _release(); }
+
+    void _init()
+    {
+        int errorBase = 0;
+        if (!XShmQueryExtension(display))
+            throw std::runtime_error("X server does not support MIT-SHM");
+        if (!XDamageQueryExtension(display, &damageEventBase, &errorBase))
+            throw std::runtime_error("X server does not support XDamage");
+
+        const int screen = DefaultScreen(display);
+        root = RootWindow(display, screen);
+
+        const QRect screenRect(0, 0, DisplayWidth(display, screen),
+                               DisplayHeight(display, screen));
+        area = area.isEmpty() ? screenRect : area & screenRect;
+        if (area.isEmpty())
+            throw std::runtime_error("Capture area is outside of the screen");
+
+        image = XShmCreateImage(display, DefaultVisual(display, screen),
+                                DefaultDepth(display, screen), ZPixmap,
+                                nullptr, &shmInfo, area.width(),
+                                area.height());
+        if (!image)
+            throw std::runtime_error("Could not create the shared image");
+        if (image->bits_per_pixel != BYTES_PER_PIXEL * 8)
+            throw std::runtime_error("Unsupported X display depth");
+
+        const auto size = image->bytes_per_line * image->height;
+        shmInfo.shmid = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+        if (shmInfo.shmid < 0)
+            throw std::runtime_error("Could not allocate shared memory");
+
+        shmInfo.shmaddr = image->data = (char*)shmat(shmInfo.shmid, 0, 0);
+        if (shmInfo.shmaddr == (char*)-1)
+        {
+            shmInfo.shmaddr = image->data = nullptr;
+            throw std::runtime_error("Could not attach shared memory");
+        }
+        shmInfo.readOnly = False;
+        if (!XShmAttach(display, &shmInfo))
+            throw std::runtime_error("Could not attach shared memory to X");
+        XSync(display, False);
+
+        damage = XDamageCreate(display, root, XDamageReportRawRectangles);
+    }
+
+    void _release()
+    {
+        if (damage)
+            XDamageDestroy(display, damage);
+        if (shmInfo.shmaddr)
+        {
+            XShmDetach(display, &shmInfo);
+            XSync(display, False);
+            shmdt(shmInfo.shmaddr);
+        }
+        if (shmInfo.shmid >= 0)
+            shmctl(shmInfo.shmid, IPC_RMID, 0);
+        if (image)
+        {
+            image->data = nullptr; // owned by the shared memory segment
+            XDestroyImage(image);
+        }
+        XCloseDisplay(display);
+    }
+};
+
+X11Capture::X11Capture(const QRect& area)
+    : _x(new XResources(area))
+    , _frame(_x->image->width, _x->image->height, QImage::Format_RGB32)
+{
+    _capture(QRegion(_frame.rect()));
+
+    _running = true;
+    start();
+}
+
+X11Capture::~X11Capture()
+{
+    _running = false;
+    wait();
+}
+
+QRegion X11Capture::update(QImage& image)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (image.size() != _frame.size() || image.format() != _frame.format())
+    {
+        image = _frame.copy();
+        _changed = QRegion();
+        return QRegion(image.rect());
+    }
+
+    for (const auto& rect : _changed.rects())
+    {
+        _copy(reinterpret_cast<const char*>(_frame.constBits()),
+              _frame.bytesPerLine(), image, rect);
+    }
+    QRegion changed;
+    std::swap(changed, _changed);
+    return changed;
+}
+
+void X11Capture::run()
+{
+    QRegion damage;
+    while (_running)
+    {
+        damage += _waitForDamage();
+
+        // Capture at most once per update(), merging damage in the meantime
+        if (!damage.isEmpty() && _isConsumed())
+        {
+            _capture(damage);
+            damage = QRegion();
+        }
+    }
+}
+
+QRegion X11Capture::_waitForDamage()
+{
+    auto display = _x->display;
+
+    if (!XPending(display))
+    {
+        pollfd fd;
+        fd.fd = ConnectionNumber(display);
+        fd.events = POLLIN;
+        fd.revents = 0;
+        poll(&fd, 1, POLL_TIMEOUT_MS);
+    }
+
+    QRegion damage;
+    while (XPending(display))
+    {
+        XEvent event;
+        XNextEvent(display, &event);
+        if (event.type != _x->damageEventBase + XDamageNotify)
+            continue;
+
+        const auto& area = reinterpret_cast<XDamageNotifyEvent&>(event).area;
+        damage += QRect(area.x, area.y, area.width, area.height);
+    }
+    return damage.translated(-_x->area.topLeft());
+}
+
+void X11Capture::_capture(const QRegion& damage)
+{
+    if (!XShmGetImage(_x->display, _x->root, _x->image, _x->area.x(),
+                      _x->area.y(), AllPlanes))
+        return;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto region = damage & _frame.rect();
+    for (const auto& rect : region.rects())
+        _copy(_x->image->data, _x->image->bytes_per_line, _frame, rect);
+    _changed += region;
+}
+
+bool X11Capture::_isConsumed()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _changed.isEmpty();
+}
@@ -0,0 +1,101 @@
+/*********************************************************************/
+/* Copyright (c) 2017, EPFL/Blue Brain Project                       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef DESKTOPSTREAMER_X11CAPTURE_H
+#define DESKTOPSTREAMER_X11CAPTURE_H
+
+#include <QImage>
+#include <QRect>
+#include <QRegion>
+#include <QThread>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+/**
+ * Capture the X11 desktop in a dedicated thread.
+ *
+ * The screen is read through a shared memory segment (MIT-SHM) only when the
+ * XDamage extension reports that some of its content has changed, and at most
+ * once between two consecutive calls to update(). Only the damaged regions are
+ * copied to the image of the caller.
+ */
+class X11Capture : public QThread
+{
+public:
+    /**
+     * Connect to the X server and start capturing.
+     * @param area the area of the X screen to capture, in pixels, for instance
+     *        one of its monitors. An empty area captures the whole screen.
+     * @throw std::runtime_error if the display can not be opened or does not
+     *        support the MIT-SHM and XDamage extensions.
+     */
+    explicit X11Capture(const QRect& area = QRect());
+
+    /** Stop capturing and disconnect from the X server. */
+    ~X11Capture();
+
+    /**
+     * Copy the regions of the screen which changed since the previous call.
+     *
+     * @param image the destination, reallocated if it does not have the size
+     *        of the screen, in which case it is entirely copied.
+     * @return the regions of the image which were copied.
+     */
+    QRegion update(QImage& image);
+
+private:
+    struct XResources;
+    std::unique_ptr<XResources> _x;
+
+    std::atomic<bool> _running{false};
+
+    std::mutex _mutex;
+    QImage _frame;
+    QRegion _changed;
+
+    /** Main QThread loop waiting for damage and capturing the screen. */
+    void run() final;
+
+    QRegion _waitForDamage();
+    void _capture(const QRegion& damage);
+    bool _isConsumed();
+};
+
+#endif
@@ -0,0 +1,285 @@
+/*********************************************************************/
+/* Copyright (c) 2017, EPFL/Blue Brain Project                       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "Relay.h"
+
+#include <deflect/Frame.h>
+
+#include <QFutureWatcher>
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
+
+#include <functional>
+#include <iostream>
+
+namespace
+{
+const qint64 REOPEN_INTERVAL_MS = 5000;
+
+deflect::Segments _filterSegments(deflect::Frame& frame, const QRect& region)
+{
+    if (region.isEmpty())
+        return frame.segments;
+
+    deflect::Segments segments;
+    for (auto segment : frame.segmentsIntersecting(region))
+        segments.push_back(*segment);
+    return segments;
+}
+
+void _waitFor(const std::vector<std::shared_future<bool>>& futures)
+{
+    for (const auto& future : futures)
+    {
+        try
+        {
+            if (!future.get())
+                std::cerr << "Relay: sending to a downstream server failed"
+                          << std::endl;
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Relay: sending to a downstream server failed: "
+                      << e.what() << std::endl;
+        }
+    }
+}
+}
+
+Relay::Relay(const int port, const std::vector<Downstream>& downstreams)
+    : _server(port)
+    , _downstreams(downstreams)
+{
+    connect(&_server, &deflect::Server::pixelStreamOpened, this,
+            &Relay::_openStream);
+    connect(&_server, &deflect::Server::pixelStreamClosed, this,
+            &Relay::_closeStream);
+    connect(&_server, &deflect::Server::receivedFrame, this, &Relay::_relay);
+    connect(&_server, &deflect::Server::receivedCursor, this,
+            &Relay::_relayCursor);
+}
+
+Relay::~Relay()
+{
+}
+
+Relay::Output Relay::_openOutput(const QString uri,
+                                 const Downstream& downstream)
+{
+    Output output;
+    output.region = downstream.region;
+    output.lastOpening.start();
+    try
+    {
+        output.stream.reset(new deflect::Stream(uri.toStdString(),
+                                                downstream.host,
+                                                downstream.port));
+    }
+    catch (const std::runtime_error& e)
+    {
+        std::cerr << "Relay: could not open stream '" << uri.toStdString()
+                  << "' to " << downstream.host << ": " << e.what()
+                  << std::endl;
+    }
+    return output;
+}
+
+void Relay::_openStream(const QString uri)
+{
+    // Connecting to the downstream servers blocks, open the streams in the
+    // thread pool and request the first frame once they are all open
+    auto watcher = new QFutureWatcher<Output>(this);
+    _openings[uri] = watcher;
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, uri] {
+        watcher->deleteLater();
+
+        // the stream was closed, or closed and opened again, in the meantime
+        const auto it = _openings.find(uri);
+        if (it == _openings.end() || it->second != watcher)
+            return;
+        _openings.erase(it);
+
+        // outputs which could not be opened are retried by _reopenOutputs()
+        const auto results = watcher->future().results();
+        _outputs[uri].assign(results.begin(), results.end());
+        _server.requestFrame(uri);
+    });
+
+    const std::function<Output(const Downstream&)> open =
+        [uri](const Downstream& downstream) {
+            return _openOutput(uri, downstream);
+        };
+    watcher->setFuture(QtConcurrent::mapped(_downstreams, open));
+}
+
+void Relay::_closeStream(const QString uri)
+{
+    _openings.erase(uri);
+    _outputs.erase(uri);
+    _reopenings.erase(_reopenings.lower_bound({uri, 0}),
+                      _reopenings.upper_bound({uri, _downstreams.size()}));
+}
+
+void Relay::_reopenOutputs(const QString uri)
+{
+    auto& outputs = _outputs[uri];
+    for (size_t i = 0; i < outputs.size(); ++i)
+    {
+        auto& output = outputs[i];
+        if (output.stream && !output.stream->isConnected())
+        {
+            std::cerr << "Relay: lost stream '" << uri.toStdString()
+                      << "' to " << _downstreams[i].host << std::endl;
+            output.stream.reset();
+        }
+
+        const OutputId id{uri, i};
+        if (output.stream || _reopenings.count(id) ||
+            output.lastOpening.elapsed() < REOPEN_INTERVAL_MS)
+        {
+            continue;
+        }
+
+        auto watcher = new QFutureWatcher<Output>(this);
+        _reopenings[id] = watcher;
+        connect(watcher, &QFutureWatcherBase::finished, this,
+                [this, watcher, id] {
+                    watcher->deleteLater();
+
+                    // the stream was closed in the meantime
+                    const auto it = _reopenings.find(id);
+                    if (it == _reopenings.end() || it->second != watcher)
+                        return;
+                    _reopenings.erase(it);
+
+                    _outputs[id.first][id.second] = watcher->result();
+                });
+        watcher->setFuture(
+            QtConcurrent::run(_openOutput, uri, _downstreams[i]));
+    }
+}
+
+deflect::FrameUpdate Relay::_keepChangedSegments(deflect::Segments& segments,
+                                                 SentSegments& sent)
+{
+    // The upstream server completes partial updates with the segments it
+    // retained, which share their image data with the previous frames, so
+    // that unchanged segments are recognized without comparing their pixels
+    SentSegments current;
+    deflect::Segments changed;
+    bool sameLayout = segments.size() == sent.size();
+    for (const auto& segment : segments)
+    {
+        const auto& params = segment.parameters;
+        const SegmentKey key{int(segment.view), params.x, params.y,
+                             params.width, params.height};
+        const auto previous = sent.find(key);
+        if (previous == sent.end())
+            sameLayout = false;
+        else if (previous->second.constData() != segment.imageData.constData())
+            changed.push_back(segment);
+        current.emplace(key, segment.imageData);
+    }
+    sameLayout = sameLayout && current.size() == segments.size();
+    sent = std::move(current);
+
+    // Regions which are not covered by the same segments as before would
+    // keep stale content downstream
+    if (!sameLayout)
+        return deflect::FrameUpdate::keyframe;
+
+    segments = std::move(changed);
+    return deflect::FrameUpdate::partial;
+}
+
+void Relay::_relay(deflect::FramePtr frame)
+{
+    const QString uri = frame->uri;
+    std::vector<std::shared_future<bool>> futures;
+
+    _reopenOutputs(uri);
+
+    for (auto& output : _outputs[uri])
+    {
+        if (!output.stream)
+            continue;
+
+        auto segments = _filterSegments(*frame, output.region);
+        auto update = deflect::FrameUpdate::full;
+        if (output.stream->supportsFrameUpdates())
+            update = _keepChangedSegments(segments, output.sentSegments);
+
+        // A downstream server closes streams which finish empty frames
+        if (segments.empty())
+            continue;
+
+        futures.push_back(output.stream->send(std::move(segments)).share());
+        futures.push_back(output.stream->finishFrame(update).share());
+    }
+
+    // Request the next frame once all downstream servers received this one
+    auto watcher = new QFutureWatcher<void>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, uri] {
+        watcher->deleteLater();
+        _server.requestFrame(uri);
+    });
+    watcher->setFuture(QtConcurrent::run(_waitFor, futures));
+}
+
+void Relay::_relayCursor(const QString uri, const deflect::Cursor cursor)
+{
+    for (auto& output : _outputs[uri])
+    {
+        if (!output.stream || !output.stream->isConnected())
+            continue;
+
+        // The shape is only sent when it changes, unlike the position
+        if (cursor.image != output.cursorImage)
+        {
+            output.cursorImage = cursor.image;
+            deflect::ImageWrapper image(cursor.image.constData(),
+                                        cursor.size.width(),
+                                        cursor.size.height(), deflect::RGBA);
+            image.compressionPolicy = deflect::COMPRESSION_OFF;
+            output.stream->sendCursorShape(image, cursor.hotspot.x(),
+                                           cursor.hotspot.y());
+        }
+        output.stream->sendCursorPosition(cursor.position.x(),
+                                          cursor.position.y(), cursor.visible);
+    }
+}
@@ -0,0 +1,131 @@
+/*********************************************************************/
+/* Copyright (c) 2017, EPFL/Blue Brain Project                       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef STREAMRELAY_RELAY_H
+#define STREAMRELAY_RELAY_H
+
+#include <deflect/Server.h> // member
+#include <deflect/Stream.h> // member
+
+#include <QObject>
+#include <QRect>
+
+#include <QElapsedTimer>
+
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+class QFutureWatcherBase;
+
+/**
+ * Forward the streams received by a Server to downstream Servers.
+ *
+ * The segments of each frame are sent unchanged to the downstream servers,
+ * without decoding or compressing them again. Each downstream server can be
+ * restricted to a region of the frames, in which case it only receives the
+ * segments intersecting this region, with their original coordinates.
+ *
+ * The next frame of a stream is requested once all downstream servers have
+ * received the current one, so that the slowest downstream server determines
+ * the relayed frame rate.
+ *
+ * Downstream servers which support frame updates only receive the segments
+ * which changed since the previous frame sent to them, as a partial update.
+ * Downstream servers which disconnect are reopened periodically.
+ */
+class Relay : public QObject
+{
+    Q_OBJECT
+
+public:
+    /** A downstream server. */
+    struct Downstream
+    {
+        std::string host;
+        unsigned short port;
+        QRect region; //!< Region to forward, empty for the whole frame
+    };
+
+    /**
+     * Start relaying.
+     *
+     * @param port the port on which to accept streams.
+     * @param downstreams the servers to forward the streams to.
+     * @throw std::runtime_error if the server could not be started.
+     */
+    Relay(int port, const std::vector<Downstream>& downstreams);
+
+    ~Relay();
+
+private:
+    /** View and geometry of a segment. */
+    using SegmentKey = std::tuple<int, uint32_t, uint32_t, uint32_t, uint32_t>;
+
+    /** The image data of the last segments sent downstream. */
+    using SentSegments = std::map<SegmentKey, QByteArray>;
+
+    struct Output
+    {
+        std::shared_ptr<deflect::Stream> stream; //!< null if not connected
+        QRect region;
+        QByteArray cursorImage; //!< Last cursor shape sent downstream
+        SentSegments sentSegments;
+        QElapsedTimer lastOpening;
+    };
+    using Outputs = std::vector<Output>;
+    using OutputId = std::pair<QString, size_t>;
+
+    deflect::Server _server;
+    const std::vector<Downstream> _downstreams;
+    std::map<QString, Outputs> _outputs;
+    std::map<QString, QFutureWatcherBase*> _openings;
+    std::map<OutputId, QFutureWatcherBase*> _reopenings;
+
+    static Output _openOutput(QString uri, const Downstream& downstream);
+    static deflect::FrameUpdate _keepChangedSegments(
+        deflect::Segments& segments, SentSegments& sent);
+    void _openStream(QString uri);
+    void _closeStream(QString uri);
+    void _reopenOutputs(QString uri);
+    void _relay(deflect::FramePtr frame);
+    void _relayCursor(QString uri, deflect::Cursor cursor);
+};
+
+#endif
@@ -0,0 +1,134 @@
+/*********************************************************************/
+/* Copyright (c) 2017, EPFL/Blue Brain Project                       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "Relay.h"
+
+#include <deflect/version.h>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QStringList>
+
+#include <iostream>
+
+namespace
+{
+// Parse a downstream server of the form "host[:port][@x,y,width,height]"
+Relay::Downstream _parseDownstream(const QString& value)
+{
+    Relay::Downstream downstream;
+    downstream.port = deflect::Server::defaultPortNumber;
+
+    const auto parts = value.split('@');
+    const auto address = parts[0].split(':');
+    downstream.host = address[0].toStdString();
+    if (address.size() > 1)
+    {
+        bool ok = false;
+        downstream.port = address[1].toUShort(&ok);
+        if (!ok)
+            throw std::invalid_argument("invalid port: " +
+                                        address[1].toStdString());
+    }
+
+    if (parts.size() > 1)
+    {
+        const auto coords = parts[1].split(',');
+        if (coords.size() != 4)
+            throw std::invalid_argument("invalid region: " +
+                                        parts[1].toStdString());
+        downstream.region = QRect(coords[0].toInt(), coords[1].toInt(),
+                                  coords[2].toInt(), coords[3].toInt());
+    }
+
+    if (downstream.host.empty())
+        throw std::invalid_argument("missing host: " + value.toStdString());
+
+    return downstream;
+}
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationVersion(
+        QString::fromStdString(deflect::Version::getString()));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Forward the streams received on a port to downstream Deflect servers "
+        "without compressing them again");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption portOption("port",
+                                  "Port on which to accept streams "
+                                  "(default: 1701)",
+                                  "port",
+                                  QString::number(
+                                      deflect::Server::defaultPortNumber));
+    parser.addOption(portOption);
+
+    QCommandLineOption downstreamOption(
+        "downstream",
+        "Downstream server to forward the streams to, as "
+        "host[:port][@x,y,width,height]. The optional region restricts the "
+        "forwarded segments to those it intersects. Can be repeated.",
+        "server");
+    parser.addOption(downstreamOption);
+
+    parser.process(app);
+
+    try
+    {
+        std::vector<Relay::Downstream> downstreams;
+        for (const auto& value : parser.values(downstreamOption))
+            downstreams.push_back(_parseDownstream(value));
+
+        if (downstreams.empty())
+            throw std::invalid_argument("no downstream server given");
+
+        Relay relay(parser.value(portOption).toInt(), downstreams);
+        return app.exec();
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "StreamRelay: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
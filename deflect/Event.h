@@ -73,6 +73,9 @@ namespace deflect
  * Stream events
  * - EVT_VIEW_SIZE_CHANGED   < remote stream window resized by user
  * - EVT_CLOSE               < remote stream window closed by user
+ * - EVT_VIEW_HIDDEN         < remote stream window hidden, or its frames are
+ *                             no longer requested; streaming can be suspended
+ * - EVT_VIEW_SHOWN          < remote stream window visible again
  *
  * Basic interaction
  * - EVT_PRESS               < touch/mouse button press (single touch point)
@@ -140,7 +143,9 @@ struct Event
         EVT_PINCH,
         EVT_TOUCH_ADD,
         EVT_TOUCH_UPDATE,
-        EVT_TOUCH_REMOVE
+        EVT_TOUCH_REMOVE,
+        EVT_VIEW_HIDDEN, /**< @version 1.8 */
+        EVT_VIEW_SHOWN   /**< @version 1.8 */
     };
 
     /** The type of event */
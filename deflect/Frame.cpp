@@ -39,8 +39,118 @@
 
 #include "Frame.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
 namespace deflect
 {
+int64_t currentTimestamp()
+{
+    using namespace std::chrono;
+    const auto now = steady_clock::now().time_since_epoch();
+    return duration_cast<microseconds>(now).count();
+}
+
+namespace
+{
+QRect _toRect(const SegmentParameters& params)
+{
+    return QRect(params.x, params.y, params.width, params.height);
+}
+}
+
+/**
+ * Uniform grid of the frame's segments, with cells of the largest segment size.
+ */
+class Frame::Index
+{
+public:
+    explicit Index(const Segments& segments)
+        : _data(segments.data())
+        , _count(segments.size())
+    {
+        QRect bounds;
+        for (const auto& segment : segments)
+        {
+            const auto& params = segment.parameters;
+            _cellWidth = std::max(_cellWidth, int(params.width));
+            _cellHeight = std::max(_cellHeight, int(params.height));
+            bounds |= _toRect(params);
+        }
+        if (bounds.isEmpty())
+            return;
+
+        _columns = (bounds.right() + 1 + _cellWidth - 1) / _cellWidth;
+        _rows = (bounds.bottom() + 1 + _cellHeight - 1) / _cellHeight;
+        _cells.resize(_columns * _rows);
+
+        for (size_t i = 0; i < segments.size(); ++i)
+        {
+            const auto rect = _toRect(segments[i].parameters);
+            if (rect.isEmpty())
+                continue;
+            for (int row = rect.top() / _cellHeight;
+                 row <= rect.bottom() / _cellHeight; ++row)
+            {
+                for (int col = rect.left() / _cellWidth;
+                     col <= rect.right() / _cellWidth; ++col)
+                {
+                    _cells[row * _columns + col].push_back(i);
+                }
+            }
+        }
+    }
+
+    /**
+     * Detect reallocations and size changes only; other modifications of the
+     * segments require Frame::invalidateIndex().
+     */
+    bool isValidFor(const Segments& segments) const
+    {
+        return segments.data() == _data && segments.size() == _count;
+    }
+
+    std::vector<size_t> query(const QRect& region,
+                              const Segments& segments) const
+    {
+        std::vector<size_t> result;
+
+        const QRect grid(0, 0, _columns * _cellWidth, _rows * _cellHeight);
+        const auto area = region.intersected(grid);
+        if (area.isEmpty())
+            return result;
+
+        for (int row = area.top() / _cellHeight;
+             row <= area.bottom() / _cellHeight; ++row)
+        {
+            for (int col = area.left() / _cellWidth;
+                 col <= area.right() / _cellWidth; ++col)
+            {
+                for (const auto i : _cells[row * _columns + col])
+                {
+                    if (_toRect(segments[i].parameters).intersects(region))
+                        result.push_back(i);
+                }
+            }
+        }
+        // Segments spanning multiple cells are found more than once
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+        return result;
+    }
+
+private:
+    const Segment* _data;
+    size_t _count;
+
+    int _cellWidth = 1;
+    int _cellHeight = 1;
+    int _columns = 0;
+    int _rows = 0;
+    std::vector<std::vector<size_t>> _cells;
+};
+
 QSize Frame::computeDimensions() const
 {
     QSize size(0, 0);
@@ -55,4 +165,45 @@ QSize Frame::computeDimensions() const
 
     return size;
 }
+
+std::vector<Segment*> Frame::segmentsIntersecting(const QRect& region)
+{
+    std::vector<Segment*> result;
+    for (const auto i : _getIndex()->query(region, segments))
+        result.push_back(&segments[i]);
+    return result;
+}
+
+std::vector<const Segment*> Frame::segmentsIntersecting(
+    const QRect& region) const
+{
+    std::vector<const Segment*> result;
+    for (const auto i : _getIndex()->query(region, segments))
+        result.push_back(&segments[i]);
+    return result;
+}
+
+void Frame::invalidateIndex()
+{
+    std::atomic_store(&_index, std::shared_ptr<const Index>());
+}
+
+std::shared_ptr<const Frame::Index> Frame::_getIndex() const
+{
+    auto index = std::atomic_load(&_index);
+    if (!index || !index->isValidFor(segments))
+    {
+        index = std::make_shared<Index>(segments);
+        std::atomic_store(&_index, index);
+    }
+    return index;
+}
+
+SubFrame::SubFrame(FramePtr frame_, const QRect& region_)
+    : frame(std::move(frame_))
+    , region(region_)
+{
+    if (frame)
+        segments = frame->segmentsIntersecting(region);
+}
 }
@@ -44,11 +44,78 @@
 #include <deflect/api.h>
 #include <deflect/types.h>
 
+#include <QByteArray>
+#include <QPoint>
+#include <QRect>
 #include <QSize>
 #include <QString>
 
+#include <cstdint>
+#include <memory>
+
 namespace deflect
 {
+/**
+ * @return the current time in microseconds of the monotonic clock used for
+ *         FrameTimestamps.
+ * @version 1.8
+ */
+DEFLECT_API int64_t currentTimestamp();
+
+/**
+ * The times at which a frame went through each stage of the stream.
+ *
+ * All timestamps are in microseconds of the server's monotonic clock, see
+ * currentTimestamp(). The sender's timestamps are converted using the clock
+ * offset estimated when the stream was opened. A value of 0 means unknown,
+ * for instance for streams using an older version of Deflect.
+ *
+ * @version 1.8
+ */
+struct FrameTimestamps
+{
+    /** The image was handed over to the Stream by the sending application. */
+    int64_t captured = 0;
+
+    /** The first segment of the frame was sent. */
+    int64_t sent = 0;
+
+    /** The first segment of the frame was received by the server. */
+    int64_t received = 0;
+
+    /** The frame was finished by all the sources. */
+    int64_t completed = 0;
+
+    /** The frame was dispatched to the application. */
+    int64_t dispatched = 0;
+};
+
+/**
+ * The mouse cursor of a stream, to be drawn over its frames by the renderer.
+ *
+ * The cursor is sent separately from the images, so that moving it only costs
+ * a few bytes instead of a new frame.
+ *
+ * @version 1.8
+ */
+struct Cursor
+{
+    /** The RGBA pixels of the cursor image, empty if no shape was sent. */
+    QByteArray image;
+
+    /** The dimensions of the cursor image. */
+    QSize size;
+
+    /** The position of the pointer in the cursor image. */
+    QPoint hotspot;
+
+    /** The position of the pointer in the frame. */
+    QPoint position;
+
+    /** Whether the cursor should be drawn. */
+    bool visible = false;
+};
+
 /**
  * A frame for a PixelStream.
  */
@@ -61,8 +128,85 @@ public:
     /** The PixelStream uri to which this frame is associated. */
     QString uri;
 
+    /**
+     * Identifier given to the frame by the sender, increasing from 1; 0 if
+     * unknown.
+     * @version 1.8
+     */
+    uint64_t id = 0;
+
+    /**
+     * The times at which the frame went through the stream.
+     * @version 1.8
+     */
+    FrameTimestamps timestamps;
+
+    /**
+     * The latest cursor of the stream when the frame was dispatched.
+     * @version 1.8
+     */
+    Cursor cursor;
+
     /** Get the total dimensions of this frame. */
     DEFLECT_API QSize computeDimensions() const;
+
+    /**
+     * Get the segments which intersect a region of the frame.
+     *
+     * The query is backed by a spatial index which is built on first use and
+     * reused by subsequent queries. invalidateIndex() must be called after
+     * any modification of the segments: a change in their number or a
+     * reallocation of the vector is detected, but clearing and refilling it
+     * with as many segments, or moving existing segments, is not.
+     *
+     * @param region The region of interest, in frame coordinates.
+     * @return the intersecting segments, in the order of the segments vector.
+     * @threadsafe for concurrent queries.
+     */
+    DEFLECT_API std::vector<Segment*> segmentsIntersecting(const QRect& region);
+
+    /** @copydoc segmentsIntersecting(const QRect&) */
+    DEFLECT_API std::vector<const Segment*> segmentsIntersecting(
+        const QRect& region) const;
+
+    /**
+     * Invalidate the spatial index used by segmentsIntersecting().
+     *
+     * Must be called after modifying the segments of a frame which was
+     * already queried.
+     */
+    DEFLECT_API void invalidateIndex();
+
+private:
+    class Index;
+    mutable std::shared_ptr<const Index> _index;
+
+    std::shared_ptr<const Index> _getIndex() const;
+};
+
+/**
+ * A view on the part of a Frame which is visible in a region.
+ *
+ * The view references the segments of the frame without copying them.
+ */
+struct SubFrame
+{
+    /**
+     * Create a view on the segments of a frame intersecting a region.
+     *
+     * @param frame The frame, kept alive by the view.
+     * @param region The region of interest, in frame coordinates.
+     */
+    DEFLECT_API SubFrame(FramePtr frame, const QRect& region);
+
+    /** The frame which owns the segments. */
+    FramePtr frame;
+
+    /** The region of interest, in frame coordinates. */
+    QRect region;
+
+    /** The segments of the frame which intersect the region. */
+    std::vector<Segment*> segments;
 };
 }
 
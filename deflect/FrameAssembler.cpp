@@ -0,0 +1,209 @@
+/*********************************************************************/
+/* Copyright (c) 2017, EPFL/Blue Brain Project                       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "FrameAssembler.h"
+
+#include "Frame.h"
+#include "SegmentDecoder.h"
+
+#include <QThreadStorage>
+#include <QtConcurrentMap>
+
+#include <cstring>
+#include <stdexcept>
+
+namespace deflect
+{
+namespace
+{
+struct Tile
+{
+    const Segment* segment;
+    char* destination;
+    std::exception_ptr exception;
+};
+
+bool _isPartOfView(const Segment& segment, const View view)
+{
+    if (view == View::side_by_side)
+        return segment.view == View::left_eye ||
+               segment.view == View::right_eye;
+    return segment.view == view;
+}
+
+QSize _computeDimensions(const Frame& frame, const View view)
+{
+    QSize size(0, 0);
+    for (const auto& segment : frame.segments)
+    {
+        if (segment.view != view)
+            continue;
+        const auto& params = segment.parameters;
+        size.setWidth(std::max(size.width(), int(params.x + params.width)));
+        size.setHeight(std::max(size.height(), int(params.y + params.height)));
+    }
+    return size;
+}
+
+void _copyRgba(const Segment& segment, char* destination, const size_t pitch)
+{
+    const auto& params = segment.parameters;
+    const size_t lineSize = params.width * 4;
+    if (size_t(segment.imageData.size()) < lineSize * params.height)
+        throw std::runtime_error("segment image data is too small");
+
+    const char* source = segment.imageData.constData();
+    for (uint i = 0; i < params.height; ++i)
+    {
+        std::memcpy(destination, source, lineSize);
+        destination += pitch;
+        source += lineSize;
+    }
+}
+
+void _assembleTile(Tile& tile, const size_t pitch, const PixelFormat format)
+{
+    // turbojpeg handles need to be per thread, and this function is called from
+    // multiple threads by QtConcurrent::blockingMap
+    static QThreadStorage<SegmentDecoder> decoder;
+    try
+    {
+        if (tile.segment->parameters.dataType == DataType::jpeg)
+            decoder.localData().decode(*tile.segment, tile.destination, pitch,
+                                       format);
+        else
+            _copyRgba(*tile.segment, tile.destination, pitch);
+    }
+    catch (...)
+    {
+        tile.exception = std::current_exception();
+    }
+}
+}
+
+class FrameAssembler::Impl
+{
+public:
+    std::vector<Tile> tiles;
+    QByteArray image;
+};
+
+FrameAssembler::FrameAssembler()
+    : _impl(new Impl)
+{
+}
+
+FrameAssembler::~FrameAssembler()
+{
+}
+
+QSize FrameAssembler::getDimensions(const Frame& frame, const View view)
+{
+    if (view != View::side_by_side)
+        return _computeDimensions(frame, view);
+
+    const auto left = _computeDimensions(frame, View::left_eye);
+    const auto right = _computeDimensions(frame, View::right_eye);
+    const auto width = std::max(left.width(), right.width());
+    return QSize(2 * width, std::max(left.height(), right.height()));
+}
+
+void FrameAssembler::assemble(const Frame& frame, void* buffer, size_t pitch,
+                              const View view, const PixelFormat format)
+{
+    if (format < RGB || format > ABGR)
+        throw std::invalid_argument("unknown pixel format");
+
+    const auto size = getDimensions(frame, view);
+    const ImageWrapper line(nullptr, size.width(), 1, format);
+    if (pitch == 0)
+        pitch = line.getBufferSize();
+    else if (pitch < line.getBufferSize())
+        throw std::invalid_argument("pitch is smaller than the image width");
+
+    const auto bytesPerPixel = line.getBytesPerPixel();
+    const auto rightEyeOffset = size.width() / 2;
+
+    auto& tiles = _impl->tiles;
+    tiles.clear();
+    for (const auto& segment : frame.segments)
+    {
+        if (!_isPartOfView(segment, view))
+            continue;
+
+        const auto dataType = segment.parameters.dataType;
+        if (dataType != DataType::jpeg && dataType != DataType::rgba)
+            throw std::invalid_argument("cannot assemble YUV segments");
+        if (dataType == DataType::rgba && format != RGBA)
+            throw std::invalid_argument(
+                "uncompressed segments can only be assembled in RGBA format");
+
+        auto x = segment.parameters.x;
+        if (view == View::side_by_side && segment.view == View::right_eye)
+            x += rightEyeOffset;
+
+        char* destination = static_cast<char*>(buffer) +
+                            segment.parameters.y * pitch + x * bytesPerPixel;
+        tiles.push_back({&segment, destination, nullptr});
+    }
+
+    QtConcurrent::blockingMap(tiles, std::bind(&_assembleTile,
+                                               std::placeholders::_1, pitch,
+                                               format));
+
+    for (const auto& tile : tiles)
+    {
+        if (tile.exception)
+            std::rethrow_exception(tile.exception);
+    }
+}
+
+ImageWrapper FrameAssembler::assemble(const Frame& frame, const View view,
+                                      const PixelFormat format)
+{
+    const auto size = getDimensions(frame, view);
+    const ImageWrapper image(nullptr, size.width(), size.height(), format);
+
+    // QByteArray keeps its allocation when shrinking
+    _impl->image.resize(int(image.getBufferSize()));
+    assemble(frame, _impl->image.data(), 0, view, format);
+
+    return ImageWrapper(_impl->image.constData(), size.width(), size.height(),
+                        format);
+}
+}
@@ -0,0 +1,126 @@
+/*********************************************************************/
+/* Copyright (c) 2017, EPFL/Blue Brain Project                       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef DEFLECT_FRAMEASSEMBLER_H
+#define DEFLECT_FRAMEASSEMBLER_H
+
+#include <deflect/ImageWrapper.h>
+#include <deflect/api.h>
+#include <deflect/types.h>
+
+#include <QSize>
+
+namespace deflect
+{
+/**
+ * Assemble the segments of a Frame into a single contiguous image.
+ *
+ * The segments are decoded in parallel directly at their place in the output
+ * image, without intermediate per-segment buffers.
+ */
+class FrameAssembler
+{
+public:
+    /** Construct an assembler. */
+    DEFLECT_API FrameAssembler();
+
+    /** Destruct the assembler. */
+    DEFLECT_API ~FrameAssembler();
+
+    /**
+     * Compute the dimensions of the image assembled for a view of a frame.
+     *
+     * @param frame The frame to assemble.
+     * @param view The view to assemble; View::side_by_side places the left and
+     *        right eye images next to each other.
+     * @return the dimensions of the assembled image, empty if the frame has
+     *         no segments for the view.
+     */
+    DEFLECT_API static QSize getDimensions(const Frame& frame,
+                                           View view = View::mono);
+
+    /**
+     * Assemble a frame into a caller-provided buffer.
+     *
+     * Segments in JPEG format are decompressed, segments in RGBA format are
+     * copied. The regions of the image not covered by segments are left
+     * untouched.
+     *
+     * @param frame The frame to assemble, which is not modified.
+     * @param buffer The output buffer, of at least pitch * height bytes for
+     *        the dimensions given by getDimensions().
+     * @param pitch The number of bytes per line in the output buffer, or 0
+     *        for a tightly packed image.
+     * @param view The view to assemble.
+     * @param format The pixel format of the output. Uncompressed segments
+     *        can only be assembled in RGBA format.
+     * @throw std::invalid_argument if the pitch or format is invalid, or if
+     *        the frame contains segments in YUV format
+     * @throw std::runtime_error if a decompression error occured for any of
+     *        the segments; the other segments are still assembled.
+     */
+    DEFLECT_API void assemble(const Frame& frame, void* buffer, size_t pitch,
+                              View view = View::mono,
+                              PixelFormat format = RGBA);
+
+    /**
+     * Assemble a frame into an image buffer owned by the assembler.
+     *
+     * The buffer is reused for subsequent frames, which avoids reallocating it
+     * when the frame dimensions do not grow.
+     *
+     * @param frame The frame to assemble, which is not modified.
+     * @param view The view to assemble.
+     * @param format The pixel format of the output.
+     * @return the tightly packed image, valid until the next call.
+     * @throw std::invalid_argument if the format is invalid, or if the frame
+     *        contains segments in YUV format
+     * @throw std::runtime_error if a decompression error occured
+     * @see assemble(const Frame&, void*, size_t, View, PixelFormat)
+     */
+    DEFLECT_API ImageWrapper assemble(const Frame& frame,
+                                      View view = View::mono,
+                                      PixelFormat format = RGBA);
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> _impl;
+};
+}
+
+#endif
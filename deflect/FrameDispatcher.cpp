@@ -40,53 +40,224 @@
 #include "FrameDispatcher.h"
 
 #include "Frame.h"
+#include "FramePool.h"
 #include "ReceiveBuffer.h"
 
+#include <QTimer>
+
+#include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <set>
+
+namespace
+{
+const size_t DEFAULT_MAX_STREAM_BUFFER_SIZE = 1024 * 1024 * 1024; // 1 GiB
+const int DEFAULT_SYNCHRONIZATION_DEADLINE_MS = 100;
+const int DEADLINE_CHECKS = 4; // resolution of the deadline
+const int DEFAULT_VIEW_HIDDEN_TIMEOUT_MS = 1000;
+const int VIEW_HIDDEN_CHECKS = 4; // resolution of the view hidden timeout
+}
 
 namespace deflect
 {
 class FrameDispatcher::Impl
 {
 public:
-    Impl() {}
+    Impl()
+        : framePool(FramePool::create())
+    {
+    }
+
     FramePtr consumeLatestFrame(const QString& uri)
     {
-        FramePtr frame(new Frame);
+        FramePtr frame = framePool->makeFrame();
         frame->uri = uri;
 
         ReceiveBuffer& buffer = streamBuffers[uri];
 
         while (buffer.hasCompleteFrame())
-            frame->segments = buffer.popFrame();
+        {
+            framePool->recycle(frame->segments);
+            buffer.popFrame(*frame);
+        }
 
         assert(!frame->segments.empty());
+        frame->timestamps.dispatched = currentTimestamp();
+
+        const auto cursor = cursors.find(uri);
+        frame->cursor = cursor != cursors.end() ? cursor->second : Cursor();
 
         // receiver will request a new frame once this frame was consumed
         buffer.setAllowedToSend(false);
+        dispatchTimes[uri] = frame->timestamps.dispatched;
 
         return frame;
     }
 
+    size_t getBufferedBytes() const
+    {
+        size_t bytes = 0;
+        for (const auto& kv : streamBuffers)
+            bytes += kv.second.getBufferedBytes();
+        return bytes;
+    }
+
+    bool isBufferSizeExceeded(const ReceiveBuffer& buffer) const
+    {
+        return (maxStreamBufferSize > 0 &&
+                buffer.getBufferedBytes() > maxStreamBufferSize) ||
+               (maxBufferSize > 0 && getBufferedBytes() > maxBufferSize);
+    }
+
+    std::shared_ptr<FramePool> framePool;
+
     typedef std::map<QString, ReceiveBuffer> StreamBuffers;
     StreamBuffers streamBuffers;
     std::map<QString, size_t> observers;
+    std::map<QString, size_t> frameSubscribers;
+    std::map<QString, Cursor> cursors;
+
+    size_t maxStreamBufferSize = DEFAULT_MAX_STREAM_BUFFER_SIZE;
+    size_t maxBufferSize = 0;
+
+    SourceSynchronization synchronization = SourceSynchronization::strict;
+    int deadline = DEFAULT_SYNCHRONIZATION_DEADLINE_MS;
+    QTimer deadlineTimer;
+
+    void updateDeadlineTimer()
+    {
+        if (synchronization == SourceSynchronization::deadline)
+            deadlineTimer.start(std::max(1, deadline / DEADLINE_CHECKS));
+        else
+            deadlineTimer.stop();
+    }
+
+    int viewHiddenTimeout = DEFAULT_VIEW_HIDDEN_TIMEOUT_MS;
+    QTimer visibilityTimer;
+    std::map<QString, int64_t> dispatchTimes;
+    std::set<QString> hiddenViews;
+
+    void updateVisibilityTimer()
+    {
+        if (viewHiddenTimeout > 0 && !streamBuffers.empty())
+        {
+            const auto interval =
+                std::max(1, viewHiddenTimeout / VIEW_HIDDEN_CHECKS);
+            if (!visibilityTimer.isActive() ||
+                visibilityTimer.interval() != interval)
+            {
+                visibilityTimer.start(interval);
+            }
+        }
+        else
+            visibilityTimer.stop();
+    }
 };
 
 FrameDispatcher::FrameDispatcher(QObject* parent_)
     : QObject(parent_)
     , _impl(new Impl)
 {
+    // Frames completed by the deadline are not notified by any source
+    connect(&_impl->deadlineTimer, &QTimer::timeout, this,
+            &FrameDispatcher::_sendExpiredFrames);
+
+    // Frames which are no longer requested belong to a view that was hidden
+    connect(&_impl->visibilityTimer, &QTimer::timeout, this,
+            &FrameDispatcher::_hideUnrequestedViews);
 }
 
 FrameDispatcher::~FrameDispatcher()
 {
 }
 
+void FrameDispatcher::setMaxStreamBufferSize(const size_t bytes)
+{
+    _impl->maxStreamBufferSize = bytes;
+    for (auto& kv : _impl->streamBuffers)
+        kv.second.setMaxBufferedBytes(bytes);
+}
+
+size_t FrameDispatcher::getMaxStreamBufferSize() const
+{
+    return _impl->maxStreamBufferSize;
+}
+
+void FrameDispatcher::setMaxBufferSize(const size_t bytes)
+{
+    _impl->maxBufferSize = bytes;
+}
+
+size_t FrameDispatcher::getMaxBufferSize() const
+{
+    return _impl->maxBufferSize;
+}
+
+void FrameDispatcher::setSourceSynchronization(const SourceSynchronization sync)
+{
+    _impl->synchronization = sync;
+    _impl->updateDeadlineTimer();
+}
+
+SourceSynchronization FrameDispatcher::getSourceSynchronization() const
+{
+    return _impl->synchronization;
+}
+
+void FrameDispatcher::setSynchronizationDeadline(const int ms)
+{
+    _impl->deadline = ms;
+    for (auto& kv : _impl->streamBuffers)
+        kv.second.setDeadline(ms);
+    _impl->updateDeadlineTimer();
+}
+
+int FrameDispatcher::getSynchronizationDeadline() const
+{
+    return _impl->deadline;
+}
+
+void FrameDispatcher::setViewHiddenTimeout(const int ms)
+{
+    _impl->viewHiddenTimeout = ms;
+}
+
+int FrameDispatcher::getViewHiddenTimeout() const
+{
+    return _impl->viewHiddenTimeout;
+}
+
+std::shared_ptr<FramePool> FrameDispatcher::getFramePool() const
+{
+    return _impl->framePool;
+}
+
+ServerMetrics FrameDispatcher::getMetrics() const
+{
+    ServerMetrics metrics;
+    for (const auto& kv : _impl->streamBuffers)
+    {
+        metrics.streams.push_back(kv.second.getMetrics());
+        metrics.streams.back().uri = kv.first;
+    }
+    metrics.bufferedBytes = _impl->getBufferedBytes();
+    metrics.pooledBuffers = _impl->framePool->getBufferCount();
+    return metrics;
+}
+
 void FrameDispatcher::addSource(const QString uri, const size_t sourceIndex)
 {
+    if (!_impl->streamBuffers.count(uri))
+    {
+        ReceiveBuffer& buffer = _impl->streamBuffers[uri];
+        buffer.setSynchronization(_impl->synchronization);
+        buffer.setDeadline(_impl->deadline);
+    }
     _impl->streamBuffers[uri].addSource(sourceIndex);
+    _impl->streamBuffers[uri].setMaxBufferedBytes(_impl->maxStreamBufferSize);
+    _impl->streamBuffers[uri].setFramePool(_impl->framePool);
+    _impl->updateVisibilityTimer();
 
     if (_impl->streamBuffers[uri].getSourceCount() == 1 &&
         _impl->observers[uri] == 0)
@@ -125,16 +296,45 @@ void FrameDispatcher::removeObserver(QString uri)
     deleteStream(uri);
 }
 
-void FrameDispatcher::processSegment(const QString uri,
-                                     const size_t sourceIndex,
-                                     deflect::Segment segment)
+void FrameDispatcher::addFrameSubscriber(const QString uri)
+{
+    ++_impl->frameSubscribers[uri];
+}
+
+void FrameDispatcher::removeFrameSubscriber(const QString uri)
 {
-    if (_impl->streamBuffers.count(uri))
-        _impl->streamBuffers[uri].insert(segment, sourceIndex);
+    auto it = _impl->frameSubscribers.find(uri);
+    if (it != _impl->frameSubscribers.end() && --it->second == 0)
+        _impl->frameSubscribers.erase(it);
+}
+
+void FrameDispatcher::processSegments(const QString uri,
+                                      const size_t sourceIndex,
+                                      deflect::SegmentsPtr segments)
+{
+    if (!_impl->streamBuffers.count(uri))
+        return;
+
+    ReceiveBuffer& buffer = _impl->streamBuffers[uri];
+    for (auto& segment : *segments)
+        buffer.insert(std::move(segment), sourceIndex);
+    segments->clear();
+
+    // Large frames are received in parts, check the limits before they are
+    // finished so that a client can not grow the buffers without bounds
+    if (_impl->isBufferSizeExceeded(buffer))
+    {
+        std::cerr << "processSegments exceeded maximum buffer size, closing "
+                     "stream: "
+                  << uri.toStdString() << std::endl;
+        emit bufferSizeExceeded(uri);
+    }
 }
 
 void FrameDispatcher::processFrameFinished(const QString uri,
-                                           const size_t sourceIndex)
+                                           const size_t sourceIndex,
+                                           const quint64 frameId,
+                                           const FrameTimestamps timestamps)
 {
     if (!_impl->streamBuffers.count(uri))
         return;
@@ -142,7 +342,7 @@ void FrameDispatcher::processFrameFinished(const QString uri,
     ReceiveBuffer& buffer = _impl->streamBuffers[uri];
     try
     {
-        buffer.finishFrameForSource(sourceIndex);
+        buffer.finishFrameForSource(sourceIndex, frameId, timestamps);
     }
     catch (const std::runtime_error& e)
     {
@@ -152,8 +352,28 @@ void FrameDispatcher::processFrameFinished(const QString uri,
         return;
     }
 
+    if (_impl->maxBufferSize > 0 &&
+        _impl->getBufferedBytes() > _impl->maxBufferSize)
+    {
+        std::cerr << "processFrameFinished exceeded maximum server buffer "
+                     "size, closing stream: "
+                  << uri.toStdString() << std::endl;
+        emit bufferSizeExceeded(uri);
+        return;
+    }
+
     if (buffer.isAllowedToSend() && buffer.hasCompleteFrame())
-        emit sendFrame(_impl->consumeLatestFrame(uri));
+        _sendLatestFrame(uri);
+}
+
+void FrameDispatcher::processCursor(const QString uri,
+                                    const deflect::Cursor cursor)
+{
+    if (!_impl->streamBuffers.count(uri))
+        return;
+
+    _impl->cursors[uri] = cursor;
+    emit cursorChanged(uri, cursor);
 }
 
 void FrameDispatcher::requestFrame(const QString uri)
@@ -161,10 +381,13 @@ void FrameDispatcher::requestFrame(const QString uri)
     if (!_impl->streamBuffers.count(uri))
         return;
 
+    if (_impl->hiddenViews.erase(uri))
+        emit viewVisibilityChanged(uri, true);
+
     ReceiveBuffer& buffer = _impl->streamBuffers[uri];
     buffer.setAllowedToSend(true);
     if (buffer.hasCompleteFrame())
-        emit sendFrame(_impl->consumeLatestFrame(uri));
+        _sendLatestFrame(uri);
 }
 
 void FrameDispatcher::deleteStream(const QString uri)
@@ -173,9 +396,71 @@ void FrameDispatcher::deleteStream(const QString uri)
         _impl->streamBuffers.count(uri))
     {
         _impl->streamBuffers.erase(uri);
+        _impl->cursors.erase(uri);
+        _impl->dispatchTimes.erase(uri);
+        _impl->hiddenViews.erase(uri);
+        _impl->updateVisibilityTimer();
 
         if (_impl->observers[uri] == 0)
             emit pixelStreamClosed(uri);
     }
 }
+
+void FrameDispatcher::_sendExpiredFrames()
+{
+    // Sending a frame may close streams, do not iterate on the buffers
+    std::vector<QString> uris;
+    for (const auto& kv : _impl->streamBuffers)
+    {
+        if (kv.second.isAllowedToSend() && kv.second.hasCompleteFrame())
+            uris.push_back(kv.first);
+    }
+    for (const auto& uri : uris)
+    {
+        const auto it = _impl->streamBuffers.find(uri);
+        if (it != _impl->streamBuffers.end() && it->second.isAllowedToSend() &&
+            it->second.hasCompleteFrame())
+        {
+            _sendLatestFrame(uri);
+        }
+    }
+}
+
+void FrameDispatcher::_hideUnrequestedViews()
+{
+    if (_impl->viewHiddenTimeout <= 0)
+        return;
+
+    const auto now = currentTimestamp();
+    const auto timeout = int64_t(_impl->viewHiddenTimeout) * 1000;
+
+    std::vector<QString> uris;
+    for (const auto& kv : _impl->dispatchTimes)
+    {
+        const auto buffer = _impl->streamBuffers.find(kv.first);
+        if (buffer != _impl->streamBuffers.end() &&
+            !buffer->second.isAllowedToSend() &&
+            !_impl->hiddenViews.count(kv.first) && now - kv.second >= timeout)
+        {
+            uris.push_back(kv.first);
+        }
+    }
+    for (const auto& uri : uris)
+    {
+        _impl->hiddenViews.insert(uri);
+        emit viewVisibilityChanged(uri, false);
+    }
+}
+
+void FrameDispatcher::_sendLatestFrame(const QString& uri)
+{
+    const auto frame = _impl->consumeLatestFrame(uri);
+
+    // Subscribers get their own copy of the segments, which the application
+    // may decode in place while they are being forwarded
+    if (_impl->frameSubscribers.count(uri))
+        emit forwardFrame(std::make_shared<Frame>(*frame));
+
+    emit sendFrame(frame);
+}
 }
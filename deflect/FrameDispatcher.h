@@ -40,6 +40,8 @@
 #ifndef DEFLECT_FRAMEDISPATCHER_H
 #define DEFLECT_FRAMEDISPATCHER_H
 
+#include <deflect/Frame.h>
+#include <deflect/Metrics.h>
 #include <deflect/Segment.h>
 #include <deflect/api.h>
 #include <deflect/types.h>
@@ -63,6 +65,61 @@ public:
     /** Destructor. */
     ~FrameDispatcher();
 
+    /**
+     * Set the maximum number of bytes buffered for each stream.
+     * @param bytes the maximum size, 0 for unlimited
+     */
+    void setMaxStreamBufferSize(size_t bytes);
+
+    /** @return the maximum number of bytes buffered for each stream. */
+    size_t getMaxStreamBufferSize() const;
+
+    /**
+     * Set the maximum number of bytes buffered for all streams together.
+     * @param bytes the maximum size, 0 for unlimited
+     */
+    void setMaxBufferSize(size_t bytes);
+
+    /** @return the maximum number of bytes buffered for all streams. */
+    size_t getMaxBufferSize() const;
+
+    /**
+     * Set how the frames of the multiple sources of a stream are synchronized.
+     * Only applies to streams opened after this call.
+     * @param sync the synchronization policy
+     */
+    void setSourceSynchronization(SourceSynchronization sync);
+
+    /** @return how the frames of the sources of a stream are synchronized. */
+    SourceSynchronization getSourceSynchronization() const;
+
+    /**
+     * Set the time to wait for late sources with
+     * SourceSynchronization::deadline.
+     * @param ms the deadline in milliseconds
+     */
+    void setSynchronizationDeadline(int ms);
+
+    /** @return the time to wait for late sources. */
+    int getSynchronizationDeadline() const;
+
+    /**
+     * Set the time after which the view of a stream is considered hidden when
+     * its last dispatched frame has not been followed by a new request.
+     * The check interval is updated when the next stream is opened.
+     * @param ms the timeout in milliseconds, 0 to disable
+     */
+    void setViewHiddenTimeout(int ms);
+
+    /** @return the time after which an unrequested view is hidden. */
+    int getViewHiddenTimeout() const;
+
+    /** @return the pool in which the memory of dispatched frames is reused. */
+    std::shared_ptr<FramePool> getFramePool() const;
+
+    /** @return a snapshot of the metrics of all the streams. */
+    ServerMetrics getMetrics() const;
+
 public slots:
     /**
      * Add a source of Segments for a Stream.
@@ -97,26 +154,60 @@ public slots:
     void removeObserver(QString uri);
 
     /**
-     * Process a new Segment.
+     * Add a subscriber to the frames of a stream, emits forwardFrame() for
+     * each frame dispatched while at least one subscriber is present.
+     *
+     * @param uri Identifier for the stream
+     */
+    void addFrameSubscriber(QString uri);
+
+    /**
+     * Remove a subscriber to the frames of a stream.
+     *
+     * @param uri Identifier for the stream
+     */
+    void removeFrameSubscriber(QString uri);
+
+    /**
+     * Process the new Segments of a source for its current frame.
      *
      * @param uri Identifier for the stream
      * @param sourceIndex Identifier for the source in the stream
-     * @param segment to process
+     * @param segments to process, moved into the stream buffer
      */
-    void processSegment(QString uri, size_t sourceIndex,
-                        deflect::Segment segment);
+    void processSegments(QString uri, size_t sourceIndex,
+                         deflect::SegmentsPtr segments);
 
     /**
      * The given source has finished sending segments for the current frame.
      *
      * @param uri Identifier for the stream
      * @param sourceIndex Identifier for the source in the stream
+     * @param frameId Identifier of the frame given by the source, 0 if unknown
+     * @param timestamps Times of capture and sending of the frame and of
+     *        reception of its first segment
+     */
+    void processFrameFinished(QString uri, size_t sourceIndex,
+                              quint64 frameId = 0,
+                              deflect::FrameTimestamps timestamps =
+                                  deflect::FrameTimestamps());
+
+    /**
+     * Process a new cursor of a stream.
+     *
+     * The cursor is attached to the next frames of the stream and notified
+     * with cursorChanged().
+     *
+     * @param uri Identifier for the stream
+     * @param cursor The latest cursor of the stream
      */
-    void processFrameFinished(QString uri, size_t sourceIndex);
+    void processCursor(QString uri, deflect::Cursor cursor);
 
     /**
      * Request the dispatching of a new frame for any stream (mono/stereo).
      *
+     * Emits viewVisibilityChanged() if the view of the stream was hidden.
+     *
      * A sendFrame() signal will be emitted for each of the view for which a
      * frame becomes available.
      *
@@ -157,13 +248,46 @@ signals:
     void sendFrame(deflect::FramePtr frame);
 
     /**
-     * Notify that a pixel stream has exceeded its maximum allowed size.
+     * Forward a frame to the subscribers of its stream.
+     *
+     * @param frame A copy of the frame dispatched with sendFrame(), which
+     *        shares the image data but not the segments with it. Its
+     *        segments are already decoded if the server decodes them.
+     */
+    void forwardFrame(deflect::FramePtr frame);
+
+    /**
+     * Notify that a pixel stream has exceeded its maximum allowed size, or
+     * that it caused all streams to exceed their maximum total size.
      *
      * @param uri Identifier for the stream
      */
     void bufferSizeExceeded(QString uri);
 
+    /**
+     * Notify that the cursor of a stream has changed.
+     *
+     * @param uri Identifier for the stream
+     * @param cursor The new cursor
+     */
+    void cursorChanged(QString uri, deflect::Cursor cursor);
+
+    /**
+     * Notify that the view of a stream was hidden or shown again.
+     *
+     * A view is hidden when no frame was requested for the view hidden timeout
+     * after the last dispatched frame, and shown again by the next request.
+     *
+     * @param uri Identifier for the stream
+     * @param visible true if the view is visible again, false if it is hidden
+     */
+    void viewVisibilityChanged(QString uri, bool visible);
+
 private:
+    void _sendLatestFrame(const QString& uri);
+    void _sendExpiredFrames();
+    void _hideUnrequestedViews();
+
     class Impl;
     std::unique_ptr<Impl> _impl;
 };
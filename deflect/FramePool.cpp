@@ -0,0 +1,167 @@
+/*********************************************************************/
+/* Copyright (c) 2017, EPFL/Blue Brain Project                       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "FramePool.h"
+
+#include "Frame.h"
+
+#include <iterator>
+
+namespace
+{
+// Bound the memory held by an idle pool
+const size_t DEFAULT_MAX_BUFFERED_BYTES = 64 * 1024 * 1024;
+const size_t MAX_FRAMES = 8;
+}
+
+namespace deflect
+{
+std::shared_ptr<FramePool> FramePool::create()
+{
+    return std::shared_ptr<FramePool>(new FramePool);
+}
+
+FramePool::FramePool()
+    : _maxBufferedBytes{DEFAULT_MAX_BUFFERED_BYTES}
+{
+}
+
+QByteArray FramePool::takeBuffer(const int size)
+{
+    QByteArray buffer;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        // Larger buffers are left for the larger segments
+        const auto it = _buffers.lower_bound(size);
+        if (it != _buffers.end())
+        {
+            buffer = std::move(it->second);
+            _bufferedBytes -= it->first;
+            _buffers.erase(it);
+        }
+    }
+    if (buffer.capacity() < size)
+        buffer.reserve(size);
+    buffer.resize(size);
+    return buffer;
+}
+
+FramePtr FramePool::makeFrame()
+{
+    std::unique_ptr<Frame> frame;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_frames.empty())
+        {
+            frame = std::move(_frames.back());
+            _frames.pop_back();
+        }
+    }
+    if (!frame)
+        frame.reset(new Frame);
+
+    std::weak_ptr<FramePool> pool = shared_from_this();
+    return FramePtr(frame.release(), [pool](Frame* released) {
+        if (auto self = pool.lock())
+            self->_recycle(released);
+        else
+            delete released;
+    });
+}
+
+void FramePool::recycle(Segments& segments)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto& segment : segments)
+    {
+        // Buffers still referenced by the application can not be reused
+        auto& data = segment.imageData;
+        const int capacity = data.capacity();
+        if (data.isDetached() && capacity > 0 &&
+            _bufferedBytes + capacity <= _maxBufferedBytes)
+        {
+            data.reserve(capacity); // keep memory on resize(0)
+            data.resize(0);
+            _bufferedBytes += capacity;
+            _buffers.emplace(capacity, std::move(data));
+        }
+    }
+    segments.clear(); // keeps the capacity of the container
+}
+
+size_t FramePool::getBufferCount() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _buffers.size();
+}
+
+size_t FramePool::getBufferedBytes() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _bufferedBytes;
+}
+
+void FramePool::setMaxBufferedBytes(const size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _maxBufferedBytes = bytes;
+    while (_bufferedBytes > _maxBufferedBytes)
+    {
+        // Release the largest buffers first
+        const auto it = std::prev(_buffers.end());
+        _bufferedBytes -= it->first;
+        _buffers.erase(it);
+    }
+}
+
+void FramePool::_recycle(Frame* frame)
+{
+    recycle(frame->segments);
+    frame->uri.clear();
+    frame->id = 0;
+    frame->timestamps = FrameTimestamps();
+    frame->cursor = Cursor();
+    frame->invalidateIndex();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_frames.size() < MAX_FRAMES)
+        _frames.emplace_back(frame);
+    else
+        delete frame;
+}
+}
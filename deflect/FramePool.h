@@ -0,0 +1,117 @@
+/*********************************************************************/
+/* Copyright (c) 2017, EPFL/Blue Brain Project                       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef DEFLECT_FRAMEPOOL_H
+#define DEFLECT_FRAMEPOOL_H
+
+#include <deflect/Segment.h>
+#include <deflect/api.h>
+#include <deflect/types.h>
+
+#include <QByteArray>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace deflect
+{
+/**
+ * Recycle the memory of received frames on the server.
+ *
+ * Frames, their segment containers and the segments' image data buffers are
+ * returned to the pool when the last reference to a FramePtr is released, so
+ * that streaming at a steady state reuses the same memory blocks. The memory
+ * of the buffers kept for reuse is bounded.
+ *
+ * @threadsafe
+ */
+class FramePool : public std::enable_shared_from_this<FramePool>
+{
+public:
+    /** Create a new pool. Must be owned by a std::shared_ptr. */
+    DEFLECT_API static std::shared_ptr<FramePool> create();
+
+    /**
+     * Get a buffer for receiving image data.
+     * @param size the size of the buffer
+     * @return the smallest recycled buffer large enough for the given size if
+     *         available, resized to it
+     */
+    DEFLECT_API QByteArray takeBuffer(int size);
+
+    /**
+     * Get an empty frame, which returns to the pool when released.
+     * @return a recycled frame with an empty segments container
+     */
+    DEFLECT_API FramePtr makeFrame();
+
+    /**
+     * Give back the image data buffers of segments to the pool.
+     * @param segments the segments to recycle, cleared by this function
+     */
+    DEFLECT_API void recycle(Segments& segments);
+
+    /** @return the number of buffers available for reuse. */
+    DEFLECT_API size_t getBufferCount() const;
+
+    /** @return the total capacity of the buffers available for reuse. */
+    DEFLECT_API size_t getBufferedBytes() const;
+
+    /**
+     * Set the maximum total capacity of the buffers kept for reuse, the
+     * buffers recycled beyond it are released.
+     * @param bytes the maximum size, 64 MiB by default
+     */
+    DEFLECT_API void setMaxBufferedBytes(size_t bytes);
+
+private:
+    FramePool();
+
+    mutable std::mutex _mutex;
+    std::multimap<int, QByteArray> _buffers; // by capacity
+    size_t _bufferedBytes = 0;
+    size_t _maxBufferedBytes;
+    std::vector<std::unique_ptr<Frame>> _frames;
+
+    void _recycle(Frame* frame);
+};
+}
+
+#endif
@@ -107,8 +107,13 @@ QByteArray ImageJpegCompressor::computeJpeg(const ImageWrapper& sourceImage,
         throw std::invalid_argument(
             "libjpeg-turbo image conversion failure: source image is NULL");
 
+    // the region rows of a bottom-up image are stored in reverse order
+    const bool bottomUp = sourceImage.rowOrder == RowOrder::bottom_up;
+    const int firstRow =
+        bottomUp ? sourceImage.height - imageRegion.y() - imageRegion.height()
+                 : imageRegion.y();
     tjSrcBuffer +=
-        imageRegion.y() * sourceImage.width * sourceImage.getBytesPerPixel();
+        firstRow * sourceImage.width * sourceImage.getBytesPerPixel();
     tjSrcBuffer += imageRegion.x() * sourceImage.getBytesPerPixel();
 
     const int tjWidth = imageRegion.width();
@@ -123,7 +128,7 @@ QByteArray ImageJpegCompressor::computeJpeg(const ImageWrapper& sourceImage,
     _tjJpegBuf.resize(tjJpegSize);
 
     const int tjJpegQual = sourceImage.compressionQuality;
-    const int tjFlags = TJFLAG_NOREALLOC; // or: TJFLAG_BOTTOMUP
+    const int tjFlags = TJFLAG_NOREALLOC | (bottomUp ? TJFLAG_BOTTOMUP : 0);
 
     auto ptr = _tjJpegBuf.data();
     int err = tjCompress2(_tjHandle, tjSrcBuffer, tjWidth, tjPitch, tjHeight,
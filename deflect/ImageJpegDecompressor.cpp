@@ -41,6 +41,7 @@
 
 #include <iostream>
 #include <stdexcept>
+#include <string>
 
 namespace
 {
@@ -58,6 +59,37 @@ deflect::ChromaSubsampling _getSubsamp(const int tjJpegSubsamp)
         throw std::runtime_error("unsupported subsampling format");
     }
 }
+
+int _getScaledSize(const int size, const unsigned int scale)
+{
+    if (scale != 1 && scale != 2 && scale != 4 && scale != 8)
+        throw std::invalid_argument("unsupported scale factor " +
+                                    std::to_string(scale));
+    const tjscalingfactor factor = {1, int(scale)};
+    return TJSCALED(size, factor);
+}
+
+int _getTjPixelFormat(const deflect::PixelFormat pixelFormat)
+{
+    switch (pixelFormat)
+    {
+    case deflect::RGB:
+        return TJPF_RGB;
+    case deflect::RGBA:
+        return TJPF_RGBX;
+    case deflect::ARGB:
+        return TJPF_XRGB;
+    case deflect::BGR:
+        return TJPF_BGR;
+    case deflect::BGRA:
+        return TJPF_BGRX;
+    case deflect::ABGR:
+        return TJPF_XBGR;
+    default:
+        throw std::invalid_argument("unknown pixel format " +
+                                    std::to_string((int)pixelFormat));
+    }
+}
 }
 
 namespace deflect
@@ -96,48 +128,90 @@ JpegHeader ImageJpegDecompressor::decompressHeader(const QByteArray& jpegData)
     return header;
 }
 
-QByteArray ImageJpegDecompressor::decompress(const QByteArray& jpegData)
+QByteArray ImageJpegDecompressor::decompress(const QByteArray& jpegData,
+                                             const unsigned int scale)
 {
     const auto header = decompressHeader(jpegData);
     const int pixelFormat = TJPF_RGBX; // Format for OpenGL texture (GL_RGBA)
-    const int pitch = header.width * tjPixelSize[pixelFormat];
+    const int width = _getScaledSize(header.width, scale);
+    const int height = _getScaledSize(header.height, scale);
+    const int pitch = width * tjPixelSize[pixelFormat];
     const int flags = TJ_FASTUPSAMPLE;
 
-    QByteArray decodedData(header.height * pitch, Qt::Uninitialized);
+    QByteArray decodedData(height * pitch, Qt::Uninitialized);
 
     int err = tjDecompress2(_tjHandle, (unsigned char*)jpegData.data(),
                             (unsigned long)jpegData.size(),
-                            (unsigned char*)decodedData.data(), header.width,
-                            pitch, header.height, pixelFormat, flags);
+                            (unsigned char*)decodedData.data(), width, pitch,
+                            height, pixelFormat, flags);
     if (err != 0)
         throw std::runtime_error("libjpeg-turbo image decompression failed");
 
     return decodedData;
 }
 
+void ImageJpegDecompressor::decompress(const QByteArray& jpegData,
+                                       const JpegHeader& header, void* buffer,
+                                       const int pitch,
+                                       const PixelFormat format,
+                                       const unsigned int scale)
+{
+    const int pixelFormat = _getTjPixelFormat(format);
+    const int width = _getScaledSize(header.width, scale);
+    const int height = _getScaledSize(header.height, scale);
+    const int flags = TJ_FASTUPSAMPLE;
+
+    int err = tjDecompress2(_tjHandle, (unsigned char*)jpegData.data(),
+                            (unsigned long)jpegData.size(),
+                            (unsigned char*)buffer, width, pitch, height,
+                            pixelFormat, flags);
+    if (err != 0)
+        throw std::runtime_error("libjpeg-turbo image decompression failed");
+}
+
 #ifndef DEFLECT_USE_LEGACY_LIBJPEGTURBO
 
 ImageJpegDecompressor::YUVData ImageJpegDecompressor::decompressToYUV(
-    const QByteArray& jpegData)
+    const QByteArray& jpegData, const unsigned int scale)
 {
     const auto header = decompressHeader(jpegData);
+    const int width = _getScaledSize(header.width, scale);
+    const int height = _getScaledSize(header.height, scale);
     const int pad = 1; // no padding
     const int flags = 0;
     const int jpegSubsamp = int(header.subsampling);
-    const auto decodedSize =
-        tjBufSizeYUV2(header.width, pad, header.height, jpegSubsamp);
+    const auto decodedSize = tjBufSizeYUV2(width, pad, height, jpegSubsamp);
 
     auto decodedData = QByteArray(decodedSize, Qt::Uninitialized);
 
     int err = tjDecompressToYUV2(_tjHandle, (unsigned char*)jpegData.data(),
                                  (unsigned long)jpegData.size(),
-                                 (unsigned char*)decodedData.data(),
-                                 header.width, pad, header.height, flags);
+                                 (unsigned char*)decodedData.data(), width, pad,
+                                 height, flags);
     if (err != 0)
         throw std::runtime_error("libjpeg-turbo image decompression failed");
 
     return std::make_pair(std::move(decodedData), header.subsampling);
 }
 
+void ImageJpegDecompressor::decompressToYUV(const QByteArray& jpegData,
+                                            const JpegHeader& header,
+                                            unsigned char* planes[3],
+                                            const int strides[3],
+                                            const unsigned int scale)
+{
+    const int width = _getScaledSize(header.width, scale);
+    const int height = _getScaledSize(header.height, scale);
+    const int flags = 0;
+    int tjStrides[3] = {strides[0], strides[1], strides[2]};
+
+    int err = tjDecompressToYUVPlanes(_tjHandle,
+                                      (unsigned char*)jpegData.data(),
+                                      (unsigned long)jpegData.size(), planes,
+                                      width, tjStrides, height, flags);
+    if (err != 0)
+        throw std::runtime_error("libjpeg-turbo image decompression failed");
+}
+
 #endif
 }
@@ -40,6 +40,7 @@
 #ifndef DEFLECT_IMAGEJPEGDECOMPRESSOR_H
 #define DEFLECT_IMAGEJPEGDECOMPRESSOR_H
 
+#include <deflect/ImageWrapper.h>
 #include <deflect/api.h>
 #include <deflect/defines.h>
 #include <deflect/types.h>
@@ -82,10 +83,31 @@ public:
      * Decompress a Jpeg image.
      *
      * @param jpegData The compressed Jpeg data
+     * @param scale The downscaling factor of the output: 1, 2, 4 or 8
      * @return The decompressed image data in (GL_)RGBA format
+     * @throw std::invalid_argument if the scale factor is not supported
      * @throw std::runtime_error if a decompression error occured
      */
-    DEFLECT_API QByteArray decompress(const QByteArray& jpegData);
+    DEFLECT_API QByteArray decompress(const QByteArray& jpegData,
+                                      unsigned int scale = 1);
+
+    /**
+     * Decompress a Jpeg image into a caller-provided buffer.
+     *
+     * @param jpegData The compressed Jpeg data
+     * @param header The header of the image, obtained with decompressHeader()
+     * @param buffer The output buffer, of at least pitch * scaled height bytes
+     * @param pitch The number of bytes per line in the output buffer, or 0 for
+     *        scaled width * bytes per pixel of the format
+     * @param format The pixel format of the output
+     * @param scale The downscaling factor of the output: 1, 2, 4 or 8
+     * @throw std::invalid_argument if the pixel format or scale is invalid
+     * @throw std::runtime_error if a decompression error occured
+     */
+    DEFLECT_API void decompress(const QByteArray& jpegData,
+                                const JpegHeader& header, void* buffer,
+                                int pitch, PixelFormat format,
+                                unsigned int scale = 1);
 
 #ifndef DEFLECT_USE_LEGACY_LIBJPEGTURBO
 
@@ -95,10 +117,34 @@ public:
      * Decompress a Jpeg image to YUV, skipping the YUV -> RGBA conversion step.
      *
      * @param jpegData The compressed Jpeg data
+     * @param scale The downscaling factor of the output: 1, 2, 4 or 8
      * @return The decompressed image data in YUV format
+     * @throw std::invalid_argument if the scale factor is not supported
+     * @throw std::runtime_error if a decompression error occured
+     */
+    DEFLECT_API YUVData decompressToYUV(const QByteArray& jpegData,
+                                       unsigned int scale = 1);
+
+    /**
+     * Decompress a Jpeg image to separate, caller-provided YUV planes.
+     *
+     * The U and V planes have the dimensions of the Y plane divided according
+     * to the header's subsampling (rounded up).
+     *
+     * @param jpegData The compressed Jpeg data
+     * @param header The header of the image, obtained with decompressHeader()
+     * @param planes The output Y, U and V planes
+     * @param strides The number of bytes per line of each plane, or 0 for
+     *        the width of the plane
+     * @param scale The downscaling factor of the output: 1, 2, 4 or 8
+     * @throw std::invalid_argument if the scale factor is not supported
      * @throw std::runtime_error if a decompression error occured
      */
-    DEFLECT_API YUVData decompressToYUV(const QByteArray& jpegData);
+    DEFLECT_API void decompressToYUV(const QByteArray& jpegData,
+                                     const JpegHeader& header,
+                                     unsigned char* planes[3],
+                                     const int strides[3],
+                                     unsigned int scale = 1);
 
 #endif
 
@@ -45,6 +45,7 @@
 #include "ImageJpegCompressor.h"
 #endif
 
+#include <QRect>
 #include <QThreadStorage>
 #include <QtConcurrentMap>
 
@@ -60,6 +61,46 @@ bool _isOnRightSideOfSideBySideImage(const Segment& segment)
     return segment.sourceImage->view == View::side_by_side &&
            segment.view == View::right_eye;
 }
+
+QRect _getImageRegion(const Segment& segment)
+{
+    QRect imageRegion(segment.parameters.x - segment.sourceImage->x,
+                      segment.parameters.y - segment.sourceImage->y,
+                      segment.parameters.width, segment.parameters.height);
+
+    if (_isOnRightSideOfSideBySideImage(segment))
+        imageRegion.translate(segment.sourceImage->width / 2, 0);
+
+    return imageRegion;
+}
+
+/** Append the rows of an image region in top-down order. */
+void _appendRegion(const ImageWrapper& image, const QRect& region,
+                   QByteArray& imageData)
+{
+    // assume imageBuffer isn't padded
+    const auto bytesPerPixel = image.getBytesPerPixel();
+    const size_t imagePitch = image.width * bytesPerPixel;
+    const int lineSize = region.width() * bytesPerPixel;
+    const bool bottomUp = image.rowOrder == RowOrder::bottom_up;
+
+    for (int i = 0; i < region.height(); ++i)
+    {
+        const size_t row = bottomUp ? image.height - 1 - (region.y() + i)
+                                    : region.y() + i;
+        const char* lineData = (const char*)image.data + row * imagePitch +
+                               region.x() * bytesPerPixel;
+        imageData.append(lineData, lineSize);
+    }
+}
+
+void _appendImage(const ImageWrapper& image, QByteArray& imageData)
+{
+    if (image.rowOrder == RowOrder::top_down)
+        imageData.append((const char*)image.data, int(image.getBufferSize()));
+    else
+        _appendRegion(image, QRect(0, 0, image.width, image.height), imageData);
+}
 }
 
 bool ImageSegmenter::generate(const ImageWrapper& image, const Handler& handler)
@@ -84,8 +125,7 @@ Segment ImageSegmenter::createSingleSegment(const ImageWrapper& image)
                                   segment.parameters.height *
                                   image.getBytesPerPixel());
         segment.parameters.dataType = DataType::rgba;
-        segment.imageData.append((const char*)image.data,
-                                 int(image.getBufferSize()));
+        _appendImage(image, segment.imageData);
     }
     else
     {
@@ -158,12 +198,7 @@ bool ImageSegmenter::_generateJpeg(const ImageWrapper& image,
 void ImageSegmenter::_computeJpeg(Segment& segment, const bool sendSegment)
 {
 #ifdef DEFLECT_USE_LIBJPEGTURBO
-    QRect imageRegion(segment.parameters.x - segment.sourceImage->x,
-                      segment.parameters.y - segment.sourceImage->y,
-                      segment.parameters.width, segment.parameters.height);
-
-    if (_isOnRightSideOfSideBySideImage(segment))
-        imageRegion.translate(segment.sourceImage->width / 2, 0);
+    const auto imageRegion = _getImageRegion(segment);
 
     // turbojpeg handles need to be per thread, and this function is called from
     // multiple threads by QtConcurrent::map
@@ -181,7 +216,7 @@ void ImageSegmenter::_computeJpeg(Segment& segment, const bool sendSegment)
 
     segment.parameters.dataType = DataType::jpeg;
     if (sendSegment)
-        _sendQueue.enqueue(segment);
+        _sendQueue.enqueue(std::move(segment));
 #endif
 }
 
@@ -199,29 +234,10 @@ bool ImageSegmenter::_generateRaw(const ImageWrapper& image,
         if (segments.size() == 1)
         {
             // If we are not segmenting the image, just append the image data
-            segment.imageData.append((const char*)image.data,
-                                     int(image.getBufferSize()));
+            _appendImage(image, segment.imageData);
         }
         else // Copy the image subregion
-        {
-            // assume imageBuffer isn't padded
-            const auto bytesPerPixel = image.getBytesPerPixel();
-            const size_t imagePitch = image.width * bytesPerPixel;
-            size_t offset = segment.parameters.y * imagePitch +
-                            segment.parameters.x * bytesPerPixel;
-
-            if (_isOnRightSideOfSideBySideImage(segment))
-                offset += segment.sourceImage->width / 2 * bytesPerPixel;
-
-            const char* lineData = (const char*)image.data + offset;
-
-            for (uint i = 0; i < segment.parameters.height; ++i)
-            {
-                segment.imageData.append(lineData, segment.parameters.width *
-                                                       bytesPerPixel);
-                lineData += imagePitch;
-            }
-        }
+            _appendRegion(image, _getImageRegion(segment), segment.imageData);
 
         if (!handler(segment))
             return false;
@@ -240,7 +256,7 @@ Segments ImageSegmenter::_generateSegments(const ImageWrapper& image) const
         segment.view =
             image.view == View::side_by_side ? View::left_eye : image.view;
         segment.sourceImage = &image;
-        segments.push_back(segment);
+        segments.push_back(std::move(segment));
     }
 
     if (image.view == View::side_by_side)
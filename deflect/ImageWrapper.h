@@ -69,6 +69,16 @@ enum CompressionPolicy
     COMPRESSION_OFF   /**< Force disable */
 };
 
+/**
+ * The order of the rows in the image buffer.
+ * @version 1.8
+ */
+enum class RowOrder
+{
+    top_down, /**< First row is the top of the image */
+    bottom_up /**< First row is the bottom of the image (GL convention) */
+};
+
 /**
  * A simple wrapper around an image data buffer.
  *
@@ -84,8 +94,8 @@ struct ImageWrapper
      *
      * The first pixel is the top-left corner of the image, going to the
      * bottom-right corner. Data arrays which follow the GL convention (as
-     * obtained by glReadPixels()) should be reordered using swapYAxis() prior
-     * to constructing the image wrapper.
+     * obtained by glReadPixels()) should either be reordered using swapYAxis()
+     * or flagged with RowOrder::bottom_up after constructing the wrapper.
      *
      * @param data The source image buffer, containing getBufferSize() bytes
      * @param width The width of the image
@@ -137,6 +147,12 @@ struct ImageWrapper
      */
     View view = View::mono;
 
+    /**
+     * The order of the rows in the data buffer.
+     * @version 1.8
+     */
+    RowOrder rowOrder = RowOrder::top_down;
+
     /**
      * Get the number of bytes per pixel based on the pixelFormat.
      * @version 1.0
@@ -69,13 +69,25 @@ public:
         _empty.notify_one();
     }
 
+    /**
+     * Move a new value to the end of the queue. Blocks if maxSize is reached.
+     */
+    void enqueue(T&& value)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (_queue.size() >= _maxSize)
+            _full.wait(lock);
+        _queue.push(std::move(value));
+        _empty.notify_one();
+    }
+
     /** Pop a value from the front of the queue. Blocks if queue is empty. */
     T dequeue()
     {
         std::unique_lock<std::mutex> lock(_mutex);
         while (_queue.empty())
             _empty.wait(lock);
-        T value = _queue.front();
+        T value = std::move(_queue.front());
         _queue.pop();
         _full.notify_one();
         return value;
@@ -43,6 +43,8 @@
 
 #ifdef _WIN32
 typedef unsigned __int32 uint32_t;
+typedef __int64 int64_t;
+typedef unsigned __int64 uint64_t;
 #else
 #include <stdint.h>
 #endif
@@ -68,7 +70,50 @@ enum MessageType
     MESSAGE_TYPE_SIZE_HINTS = 13,
     MESSAGE_TYPE_DATA = 14,
     MESSAGE_TYPE_IMAGE_VIEW = 15,
-    MESSAGE_TYPE_OBSERVER_OPEN = 16
+    MESSAGE_TYPE_OBSERVER_OPEN = 16,
+    MESSAGE_TYPE_SUBSCRIBE_FRAMES = 17,
+    MESSAGE_TYPE_CLOCK_SYNC = 18,
+    MESSAGE_TYPE_CURSOR_SHAPE = 19,
+    MESSAGE_TYPE_CURSOR_POSITION = 20
+};
+
+/** Payload of MESSAGE_TYPE_PIXELSTREAM_FINISH_FRAME, optional. */
+struct FinishFrameMessage
+{
+    uint64_t frameId;
+    int64_t captured; /**< in server clock, 0 if unknown */
+    int64_t sent;     /**< in server clock, 0 if unknown */
+    uint64_t update;  /**< FrameUpdate, since protocol version 9 */
+};
+
+/**
+ * Payload of MESSAGE_TYPE_CLOCK_SYNC, sent by the client with its current time
+ * and returned by the server with its own time added.
+ */
+struct ClockSyncMessage
+{
+    int64_t clientTime;
+    int64_t serverTime;
+};
+
+/**
+ * Payload of MESSAGE_TYPE_CURSOR_SHAPE, followed by the RGBA pixels of the
+ * cursor image.
+ */
+struct CursorShapeMessage
+{
+    uint32_t width;
+    uint32_t height;
+    int32_t hotspotX;
+    int32_t hotspotY;
+};
+
+/** Payload of MESSAGE_TYPE_CURSOR_POSITION. */
+struct CursorPositionMessage
+{
+    int32_t x;
+    int32_t y;
+    uint32_t visible;
 };
 
 #define MESSAGE_HEADER_URI_LENGTH 64
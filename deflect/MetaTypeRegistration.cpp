@@ -39,6 +39,9 @@
 /*********************************************************************/
 
 #include "Event.h"
+#include "Frame.h"
+#include "ImageWrapper.h"
+#include "Metrics.h"
 #include "Segment.h"
 #include "SizeHints.h"
 #include "types.h"
@@ -57,10 +60,16 @@ struct MetaTypeRegistration
         qRegisterMetaType<size_t>("size_t");
         qRegisterMetaType<deflect::BoolPromisePtr>("deflect::BoolPromisePtr");
         qRegisterMetaType<deflect::Segment>("deflect::Segment");
+        qRegisterMetaType<deflect::SegmentsPtr>("deflect::SegmentsPtr");
         qRegisterMetaType<deflect::SizeHints>("deflect::SizeHints");
         qRegisterMetaType<deflect::Event>("deflect::Event");
         qRegisterMetaType<deflect::FramePtr>("deflect::FramePtr");
+        qRegisterMetaType<deflect::Cursor>("deflect::Cursor");
+        qRegisterMetaType<deflect::FrameTimestamps>(
+            "deflect::FrameTimestamps");
         qRegisterMetaType<deflect::View>("deflect::View");
+        qRegisterMetaType<deflect::PixelFormat>("deflect::PixelFormat");
+        qRegisterMetaType<deflect::ServerMetrics>("deflect::ServerMetrics");
     }
 };
 
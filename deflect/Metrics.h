@@ -0,0 +1,153 @@
+/*********************************************************************/
+/* Copyright (c) 2017, EPFL/Blue Brain Project                       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef DEFLECT_METRICS_H
+#define DEFLECT_METRICS_H
+
+#include <deflect/types.h>
+
+#include <QString>
+
+#include <vector>
+
+namespace deflect
+{
+/**
+ * Counters for a single source of a stream.
+ *
+ * @version 1.8
+ */
+struct SourceMetrics
+{
+    /** Identifier of the source in its stream. */
+    size_t sourceIndex = 0;
+
+    /** Number of frames finished by the source. */
+    size_t framesReceived = 0;
+
+    /** Number of frames completed without the source, which was late. */
+    size_t framesLate = 0;
+
+    /** True if the source has not finished a frame that others finished. */
+    bool late = false;
+
+    /** Number of segments received from the source. */
+    size_t segmentsReceived = 0;
+
+    /** Number of image data bytes received from the source. */
+    size_t bytesReceived = 0;
+
+    /** Number of frames queued for the source, including the one in progress */
+    size_t queueSize = 0;
+
+    /** Number of image data bytes currently buffered for the source. */
+    size_t bufferedBytes = 0;
+};
+
+/**
+ * Counters and timings for a stream, accumulated since it was opened.
+ *
+ * @version 1.8
+ */
+struct StreamMetrics
+{
+    /** Identifier of the stream. */
+    QString uri;
+
+    /** Number of frames finished by any of the sources. */
+    size_t framesReceived = 0;
+
+    /** Number of frames completed by all the sources. */
+    size_t framesCompleted = 0;
+
+    /** Number of complete frames dropped because a newer one was ready. */
+    size_t framesDropped = 0;
+
+    /** Number of frames dispatched to the application. */
+    size_t framesDispatched = 0;
+
+    /** Number of image data bytes received from all the sources. */
+    size_t bytesReceived = 0;
+
+    /** Number of image data bytes currently buffered. */
+    size_t bufferedBytes = 0;
+
+    /** Largest number of frames queued by any of the sources. */
+    size_t queueSize = 0;
+
+    /** Average number of segments of the dispatched frames. */
+    double segmentsPerFrame = 0.0;
+
+    /** Average time from the capture to the sending of a frame. */
+    double captureToSendTimeMs = 0.0;
+
+    /** Average time from the sending to the reception of a frame. */
+    double sendToReceiveTimeMs = 0.0;
+
+    /** Average time from the first segment to the completion of a frame. */
+    double completionTimeMs = 0.0;
+
+    /** Average time from the completion to the dispatching of a frame. */
+    double dispatchTimeMs = 0.0;
+
+    /** Average time from the dispatching of a frame to the next request. */
+    double requestTimeMs = 0.0;
+
+    /** The counters of each source of the stream. */
+    std::vector<SourceMetrics> sources;
+};
+
+/**
+ * Snapshot of the metrics of all the streams of a Server.
+ *
+ * @version 1.8
+ */
+struct ServerMetrics
+{
+    /** The metrics of each open stream. */
+    std::vector<StreamMetrics> streams;
+
+    /** Number of image data bytes buffered for all the streams. */
+    size_t bufferedBytes = 0;
+
+    /** Number of segment buffers waiting for reuse in the frame pool. */
+    size_t pooledBuffers = 0;
+};
+}
+
+#endif
@@ -39,7 +39,15 @@
 #ifndef DEFLECT_NETWORK_PROTOCOL_H
 #define DEFLECT_NETWORK_PROTOCOL_H
 
-#define NETWORK_PROTOCOL_VERSION 8
+#define NETWORK_PROTOCOL_VERSION 9
 #define DEFAULT_PORT_NUMBER 1701
 
+// Oldest protocol version of the servers that clients can connect to
+#define MIN_NETWORK_PROTOCOL_VERSION 8
+
+// First protocol version supporting frame subscriptions, clock
+// synchronization, frame updates, cursors and view visibility events. These
+// messages are not sent to older servers, nor the events to older clients.
+#define FRAME_UPDATES_PROTOCOL_VERSION 9
+
 #endif
@@ -43,9 +43,6 @@
 #include "NetworkProtocol.h"
 #include "StreamPrivate.h"
 
-#include <QDataStream>
-
-#include <cassert>
 #include <iostream>
 
 namespace deflect
@@ -107,22 +104,17 @@ bool Observer::registerForEvents(const bool exclusive)
         return false;
     }
 
-    // Wait for bind reply
-    MessageHeader mh;
-    QByteArray message;
-    if (!_impl->socket.receive(mh, message))
-    {
-        std::cerr << "deflect::Stream::registerForEvents: receive bind reply "
-                  << "failed" << std::endl;
-        return false;
-    }
-    if (mh.type != MESSAGE_TYPE_BIND_EVENTS_REPLY)
+    // Wait for bind reply, frames may be received in the meantime
+    _impl->bindReplyReceived = false;
+    while (!_impl->bindReplyReceived)
     {
-        std::cerr << "deflect::Stream::registerForEvents: received unexpected "
-                  << "message type (" << int(mh.type) << ")" << std::endl;
-        return false;
+        if (!_impl->receiveMessage())
+        {
+            std::cerr << "deflect::Stream::registerForEvents: receive bind "
+                      << "reply failed" << std::endl;
+            return false;
+        }
     }
-    _impl->registeredForEvents = *(bool*)(message.data());
 
     return isRegisteredForEvents();
 }
@@ -139,33 +131,67 @@ int Observer::getDescriptor() const
 
 bool Observer::hasEvent() const
 {
-    return _impl->socket.hasMessage(Event::serializedSize);
+    _impl->receivePendingMessages();
+    return !_impl->events.empty();
 }
 
 Event Observer::getEvent()
 {
-    MessageHeader mh;
-    QByteArray message;
-    if (!_impl->socket.receive(mh, message))
+    while (_impl->events.empty())
+    {
+        if (!_impl->receiveMessage())
+        {
+            std::cerr << "deflect::Stream::getEvent: receive failed"
+                      << std::endl;
+            return Event();
+        }
+    }
+
+    const Event event = _impl->events.front();
+    _impl->events.pop();
+    return event;
+}
+
+bool Observer::subscribeToFrames()
+{
+    if (!isConnected())
     {
-        std::cerr << "deflect::Stream::getEvent: receive failed" << std::endl;
-        return Event();
+        std::cerr << "deflect::Observer::subscribeToFrames: not connected, "
+                  << "operation failed" << std::endl;
+        return false;
     }
-    if (mh.type != MESSAGE_TYPE_EVENT)
+
+    if (!_impl->supportsFrameUpdates())
     {
-        std::cerr << "deflect::Stream::getEvent: received unexpected message "
-                  << "type (" << int(mh.type) << ")" << std::endl;
-        return Event();
+        std::cerr << "deflect::Observer::subscribeToFrames: not supported by "
+                  << "the server" << std::endl;
+        return false;
     }
 
-    assert((size_t)message.size() == Event::serializedSize);
+    return _impl->sendWorker.enqueueFramesSubscription().get();
+}
+
+bool Observer::hasFrame() const
+{
+    _impl->receivePendingMessages();
+    return _impl->frame != nullptr;
+}
 
-    Event event;
+FramePtr Observer::getFrame()
+{
+    while (!_impl->frame)
     {
-        QDataStream stream(message);
-        stream >> event;
+        if (!_impl->receiveMessage())
+        {
+            std::cerr << "deflect::Observer::getFrame: receive failed"
+                      << std::endl;
+            return FramePtr();
+        }
     }
-    return event;
+
+    FramePtr frame;
+    std::swap(frame, _impl->frame);
+    return frame;
 }
 
 void Observer::setDisconnectedCallback(const std::function<void()> callback)
@@ -196,6 +196,47 @@ public:
      */
     DEFLECT_API Event getEvent();
 
+    /**
+     * Subscribe to the frames of the stream.
+     *
+     * After subscribing, the Server sends the frames of the stream with this
+     * identifier each time it dispatches them, forwarding the segments as
+     * they were received without compressing them again. Note that a Server
+     * which decodes the segments on reception (see
+     * Server::setSegmentDecoding()) forwards them decoded, which requires
+     * more bandwidth.
+     *
+     * Only the latest frame is kept by the Server and by the Observer until
+     * it is retrieved, older frames are dropped.
+     *
+     * Frames can be retrieved using hasFrame() and getFrame().
+     *
+     * @return true if the subscription request could be sent.
+     * @version 1.8
+     */
+    DEFLECT_API bool subscribeToFrames();
+
+    /**
+     * Check if a new Frame is available.
+     *
+     * This method is non-blocking.
+     *
+     * @return True if a Frame is available, false otherwise
+     * @version 1.8
+     */
+    DEFLECT_API bool hasFrame() const;
+
+    /**
+     * Get the latest Frame.
+     *
+     * This method is synchronous and waits until a Frame is available before
+     * returning (or a timeout occurs).
+     *
+     * @return The latest Frame if available, otherwise nullptr.
+     * @version 1.8
+     */
+    DEFLECT_API FramePtr getFrame();
+
     /**
      * Set a function to be be called just after the observer gets disconnected.
      *
@@ -39,10 +39,39 @@
 
 #include "ReceiveBuffer.h"
 
+#include "FramePool.h"
+
+#include <algorithm>
 #include <cassert>
+#include <stdexcept>
+
 namespace
 {
 const size_t MAX_QUEUE_SIZE = 150; // stream blocked for ~5 seconds at 30Hz
+
+double _toMilliseconds(const int64_t microseconds, const size_t count)
+{
+    return count == 0 ? 0.0 : microseconds / 1000.0 / count;
+}
+
+double _toMilliseconds(const std::pair<int64_t, size_t>& durations)
+{
+    return _toMilliseconds(durations.first, durations.second);
+}
+
+void _addDuration(std::pair<int64_t, size_t>& durations, const int64_t from,
+                  const int64_t to)
+{
+    if (from == 0 || to == 0)
+        return;
+    durations.first += to - from;
+    ++durations.second;
+}
+
+int64_t _earliest(const int64_t a, const int64_t b)
+{
+    return a == 0 ? b : (b == 0 ? a : std::min(a, b));
+}
 }
 
 namespace deflect
@@ -56,13 +85,36 @@ bool ReceiveBuffer::addSource(const size_t sourceIndex)
     if (_sourceBuffers.count(sourceIndex))
         return false;
 
-    _sourceBuffers[sourceIndex] = SourceBuffer();
+    // Unless frames are strictly synchronized, sources added while streaming
+    // contribute to the next frame instead of having to catch up
+    if (_synchronization == SourceSynchronization::strict)
+        _sourceBuffers[sourceIndex] = SourceBuffer();
+    else
+        _sourceBuffers[sourceIndex] = SourceBuffer(_lastFrameComplete);
+    _sourceMetrics[sourceIndex] = SourceMetrics();
+    _sourceMetrics[sourceIndex].sourceIndex = sourceIndex;
     return true;
 }
 
 void ReceiveBuffer::removeSource(const size_t sourceIndex)
 {
-    _sourceBuffers.erase(sourceIndex);
+    const auto it = _sourceBuffers.find(sourceIndex);
+    if (it == _sourceBuffers.end())
+        return;
+
+    // The source no longer counts for the frames it had finished
+    if (_synchronization != SourceSynchronization::independent)
+    {
+        const auto backFrameIndex = it->second.getBackFrameIndex();
+        for (FrameIndex i = _lastFrameComplete + 1; i <= backFrameIndex; ++i)
+            --_finishedSourcesCount[i - _lastFrameComplete - 1];
+    }
+
+    _bufferedBytes -= it->second.getBufferedBytes();
+    _sourceBuffers.erase(it);
+    _sourceMetrics.erase(sourceIndex);
+    _previousSegments.erase(sourceIndex);
+    _receiveTimes.erase(sourceIndex);
 }
 
 size_t ReceiveBuffer::getSourceCount() const
@@ -74,10 +126,23 @@ void ReceiveBuffer::insert(const Segment& segment, const size_t sourceIndex)
 {
     assert(_sourceBuffers.count(sourceIndex));
 
+    _recordSegment(segment, sourceIndex);
     _sourceBuffers[sourceIndex].insert(segment);
+    _bufferedBytes += segment.imageData.size();
 }
 
-void ReceiveBuffer::finishFrameForSource(const size_t sourceIndex)
+void ReceiveBuffer::insert(Segment&& segment, const size_t sourceIndex)
+{
+    assert(_sourceBuffers.count(sourceIndex));
+
+    _recordSegment(segment, sourceIndex);
+    _bufferedBytes += segment.imageData.size();
+    _sourceBuffers[sourceIndex].insert(std::move(segment));
+}
+
+void ReceiveBuffer::finishFrameForSource(const size_t sourceIndex,
+                                         const uint64_t frameId,
+                                         const FrameTimestamps& timestamps)
 {
     assert(_sourceBuffers.count(sourceIndex));
 
@@ -89,39 +154,175 @@ void ReceiveBuffer::finishFrameForSource(const size_t sourceIndex)
         throw std::runtime_error("client sent finish frame without image data");
 
     buffer.push();
+
+    ++_sourceMetrics[sourceIndex].framesReceived;
+
+    if (_synchronization == SourceSynchronization::independent)
+    {
+        _finishIndependentFrame(sourceIndex, frameId, timestamps);
+        _dropStaleFrames();
+        if (_maxBufferedBytes > 0 && _bufferedBytes > _maxBufferedBytes)
+            throw std::runtime_error("maximum buffer size exceeded");
+        return;
+    }
+
+    // Sources lagging behind the last complete frame (added during streaming)
+    // do not contribute to the following frames until they catch up
+    const auto backFrameIndex = buffer.getBackFrameIndex();
+    if (backFrameIndex > _lastFrameComplete)
+    {
+        const size_t i = backFrameIndex - _lastFrameComplete - 1;
+        if (i >= _finishedSourcesCount.size())
+            _finishedSourcesCount.resize(i + 1, 0);
+        ++_finishedSourcesCount[i];
+
+        _framesReceived = std::max(_framesReceived, size_t(backFrameIndex));
+
+        // Sources of a frame may have captured and sent it at different times
+        auto& info = _getFrameInfo(backFrameIndex);
+        info.id = std::max(info.id, frameId);
+        info.timestamps.captured =
+            _earliest(info.timestamps.captured, timestamps.captured);
+        info.timestamps.sent = _earliest(info.timestamps.sent, timestamps.sent);
+        info.timestamps.received =
+            _earliest(info.timestamps.received, timestamps.received);
+
+        if (info.firstFinished == 0)
+            info.firstFinished = currentTimestamp();
+
+        if (_finishedSourcesCount[i] == _sourceBuffers.size())
+            _completeFrame(info);
+    }
+    else if (_synchronization == SourceSynchronization::deadline)
+    {
+        // The frame was completed without this late source, which will use
+        // the segments it just finished for the following frames
+        _catchUp(sourceIndex);
+    }
+
+    _dropStaleFrames();
+
+    if (_maxBufferedBytes > 0 && _bufferedBytes > _maxBufferedBytes)
+        throw std::runtime_error("maximum buffer size exceeded");
 }
 
 bool ReceiveBuffer::hasCompleteFrame() const
 {
-    // Check if all sources for Stream have reached the same index
-    for (const auto& kv : _sourceBuffers)
+    switch (_synchronization)
     {
-        const auto& buffer = kv.second;
-        if (buffer.getBackFrameIndex() <= _lastFrameComplete)
-            return false;
+    case SourceSynchronization::deadline:
+        return _hasCompleteFrames(1) || _isDeadlineExceeded(1);
+    case SourceSynchronization::independent:
+        for (const auto& kv : _sourceBuffers)
+        {
+            if (kv.second.getQueueSize() > 1)
+                return true;
+        }
+        return false;
+    case SourceSynchronization::strict:
+    default:
+        return _hasCompleteFrames(1);
     }
-    return !_sourceBuffers.empty();
 }
 
 Segments ReceiveBuffer::popFrame()
 {
     Segments frame;
-    for (auto& kv : _sourceBuffers)
+    popFrame(frame);
+    return frame;
+}
+
+void ReceiveBuffer::popFrame(Segments& frame)
+{
+    const auto previousSize = frame.size();
+    _popFrame(frame);
+    ++_framesPopped;
+    _segmentsPopped += frame.size() - previousSize;
+}
+
+void ReceiveBuffer::popFrame(Frame& frame)
+{
+    popFrame(frame.segments);
+    frame.invalidateIndex();
+    frame.id = _lastPoppedFrame.id;
+    frame.timestamps = _lastPoppedFrame.timestamps;
+}
+
+void ReceiveBuffer::setFramePool(std::shared_ptr<FramePool> pool)
+{
+    _framePool = std::move(pool);
+}
+
+size_t ReceiveBuffer::getBufferedBytes() const
+{
+    return _bufferedBytes;
+}
+
+void ReceiveBuffer::setMaxBufferedBytes(const size_t bytes)
+{
+    _maxBufferedBytes = bytes;
+}
+
+size_t ReceiveBuffer::getDroppedFrameCount() const
+{
+    return _droppedFrames;
+}
+
+void ReceiveBuffer::setSynchronization(const SourceSynchronization sync)
+{
+    assert(_sourceBuffers.empty());
+    _synchronization = sync;
+}
+
+SourceSynchronization ReceiveBuffer::getSynchronization() const
+{
+    return _synchronization;
+}
+
+void ReceiveBuffer::setDeadline(const int ms)
+{
+    _deadline = ms;
+}
+
+int ReceiveBuffer::getDeadline() const
+{
+    return _deadline;
+}
+
+std::vector<size_t> ReceiveBuffer::getLateSources() const
+{
+    std::vector<size_t> sources;
+    if (_synchronization == SourceSynchronization::independent ||
+        _finishedSourcesCount.empty() || _finishedSourcesCount[0] == 0)
     {
-        auto& buffer = kv.second;
-        if (buffer.getBackFrameIndex() > _lastFrameComplete)
-        {
-            const auto& segments = buffer.getSegments();
-            frame.insert(frame.end(), segments.begin(), segments.end());
-            buffer.pop();
-        }
+        return sources;
     }
-    ++_lastFrameComplete;
-    return frame;
+
+    // Sources which have not finished a frame that others have finished
+    for (const auto& kv : _sourceBuffers)
+    {
+        if (kv.second.getBackFrameIndex() <= _lastFrameComplete)
+            sources.push_back(kv.first);
+    }
+    return sources;
 }
 
 void ReceiveBuffer::setAllowedToSend(const bool enable)
 {
+    if (!enable)
+    {
+        _dispatchTime = currentTimestamp();
+        _dispatched = true;
+        ++_framesDispatched;
+        _addDuration(_completeToDispatch,
+                     _lastPoppedFrame.timestamps.completed, _dispatchTime);
+    }
+    else if (_dispatched)
+    {
+        _requestTime += currentTimestamp() - _dispatchTime;
+        _dispatched = false;
+        ++_requestCount;
+    }
     _allowedToSend = enable;
 }
 
@@ -129,4 +330,236 @@ bool ReceiveBuffer::isAllowedToSend() const
 {
     return _allowedToSend;
 }
+
+StreamMetrics ReceiveBuffer::getMetrics() const
+{
+    StreamMetrics metrics;
+    metrics.framesReceived = _framesReceived;
+    metrics.framesCompleted = _framesCompleted;
+    metrics.framesDropped = _droppedFrames;
+    metrics.framesDispatched = _framesDispatched;
+    metrics.bufferedBytes = _bufferedBytes;
+    metrics.bytesReceived = _bytesReceived;
+    if (_framesPopped > 0)
+        metrics.segmentsPerFrame = double(_segmentsPopped) / _framesPopped;
+    metrics.captureToSendTimeMs = _toMilliseconds(_captureToSend);
+    metrics.sendToReceiveTimeMs = _toMilliseconds(_sendToReceive);
+    metrics.completionTimeMs = _toMilliseconds(_receiveToComplete);
+    metrics.dispatchTimeMs = _toMilliseconds(_completeToDispatch);
+    metrics.requestTimeMs = _toMilliseconds(_requestTime, _requestCount);
+
+    const auto lateSources = getLateSources();
+    for (const auto& kv : _sourceBuffers)
+    {
+        auto source = _sourceMetrics.at(kv.first);
+        source.late = std::find(lateSources.begin(), lateSources.end(),
+                                kv.first) != lateSources.end();
+        source.queueSize = kv.second.getQueueSize();
+        source.bufferedBytes = kv.second.getBufferedBytes();
+        metrics.queueSize = std::max(metrics.queueSize, source.queueSize);
+        metrics.sources.push_back(source);
+    }
+    return metrics;
+}
+
+bool ReceiveBuffer::_hasCompleteFrames(const FrameIndex count) const
+{
+    // Check if all sources for Stream have reached the same index
+    return !_sourceBuffers.empty() && _finishedSourcesCount.size() >= count &&
+           _finishedSourcesCount[count - 1] == _sourceBuffers.size();
+}
+
+ReceiveBuffer::FrameInfo& ReceiveBuffer::_getFrameInfo(
+    const FrameIndex frameIndex)
+{
+    assert(frameIndex > _lastFrameComplete);
+
+    const size_t i = frameIndex - _lastFrameComplete - 1;
+    if (i >= _frameInfos.size())
+        _frameInfos.resize(i + 1);
+    return _frameInfos[i];
+}
+
+bool ReceiveBuffer::_isDeadlineExceeded(const FrameIndex count) const
+{
+    // Check if a source finished the frame at index count for long enough
+    if (_frameInfos.size() < count || _finishedSourcesCount.size() < count ||
+        _finishedSourcesCount[count - 1] == 0)
+    {
+        return false;
+    }
+    const auto firstFinished = _frameInfos[count - 1].firstFinished;
+    return firstFinished > 0 &&
+           currentTimestamp() - firstFinished >= int64_t(_deadline) * 1000;
+}
+
+void ReceiveBuffer::_popFrame(Segments& frame)
+{
+    if (_synchronization == SourceSynchronization::independent)
+    {
+        for (auto& kv : _sourceBuffers)
+            _popSource(kv.first, kv.second.getQueueSize() > 1, frame);
+        _lastPoppedFrame = _latestFrame;
+        return;
+    }
+
+    for (auto& kv : _sourceBuffers)
+    {
+        const auto backFrameIndex = kv.second.getBackFrameIndex();
+        const bool finished = backFrameIndex > _lastFrameComplete;
+        if (finished || _synchronization == SourceSynchronization::deadline)
+            _popSource(kv.first, finished, frame);
+    }
+    ++_lastFrameComplete;
+    if (!_finishedSourcesCount.empty())
+        _finishedSourcesCount.pop_front();
+    _lastPoppedFrame = FrameInfo();
+    if (!_frameInfos.empty())
+    {
+        _lastPoppedFrame = _frameInfos.front();
+        _frameInfos.pop_front();
+    }
+    // Frames completed by the deadline, without all the sources
+    if (_synchronization == SourceSynchronization::deadline &&
+        _lastPoppedFrame.timestamps.completed == 0)
+    {
+        _completeFrame(_lastPoppedFrame);
+    }
+}
+
+void ReceiveBuffer::_popSource(const size_t sourceIndex, const bool finished,
+                               Segments& frame)
+{
+    if (!finished)
+    {
+        // Late sources contribute the segments of their previous frame, which
+        // share their image data with it
+        const auto& previous = _previousSegments[sourceIndex];
+        frame.insert(frame.end(), previous.begin(), previous.end());
+        if (_synchronization == SourceSynchronization::deadline)
+            ++_sourceMetrics[sourceIndex].framesLate;
+        return;
+    }
+
+    const auto start = frame.size();
+    auto& buffer = _sourceBuffers[sourceIndex];
+    _bufferedBytes -= buffer.getBufferedBytes();
+    buffer.pop(frame);
+    _bufferedBytes += buffer.getBufferedBytes();
+
+    if (_synchronization != SourceSynchronization::strict)
+    {
+        _previousSegments[sourceIndex].assign(frame.begin() + start,
+                                              frame.end());
+    }
+}
+
+void ReceiveBuffer::_catchUp(const size_t sourceIndex)
+{
+    // Keep only the latest frame of the source, which is already late
+    auto& buffer = _sourceBuffers[sourceIndex];
+    auto& previous = _previousSegments[sourceIndex];
+    _bufferedBytes -= buffer.getBufferedBytes();
+    while (buffer.getQueueSize() > 1)
+    {
+        _staleSegments.swap(previous);
+        _recycleStaleSegments();
+        buffer.pop(previous);
+    }
+    _bufferedBytes += buffer.getBufferedBytes();
+}
+
+void ReceiveBuffer::_finishIndependentFrame(const size_t sourceIndex,
+                                            const uint64_t frameId,
+                                            const FrameTimestamps& timestamps)
+{
+    _framesReceived = std::max(_framesReceived,
+                               _sourceMetrics[sourceIndex].framesReceived);
+
+    // The dispatched frame carries the information of the latest source frame
+    _latestFrame = FrameInfo();
+    _latestFrame.id = frameId;
+    _latestFrame.timestamps.captured = timestamps.captured;
+    _latestFrame.timestamps.sent = timestamps.sent;
+    _latestFrame.timestamps.received =
+        _earliest(_receiveTimes[sourceIndex], timestamps.received);
+    _receiveTimes[sourceIndex] = 0;
+    _completeFrame(_latestFrame);
+}
+
+void ReceiveBuffer::_completeFrame(FrameInfo& info)
+{
+    ++_framesCompleted;
+
+    auto& timestamps = info.timestamps;
+    timestamps.completed = currentTimestamp();
+    _addDuration(_captureToSend, timestamps.captured, timestamps.sent);
+    _addDuration(_sendToReceive, timestamps.sent, timestamps.received);
+    _addDuration(_receiveToComplete, timestamps.received,
+                 timestamps.completed);
+}
+
+void ReceiveBuffer::_recordSegment(const Segment& segment,
+                                   const size_t sourceIndex)
+{
+    auto& source = _sourceMetrics[sourceIndex];
+    ++source.segmentsReceived;
+    source.bytesReceived += segment.imageData.size();
+    _bytesReceived += segment.imageData.size();
+
+    if (_synchronization == SourceSynchronization::independent)
+    {
+        auto& received = _receiveTimes[sourceIndex];
+        if (received == 0)
+            received = currentTimestamp();
+        return;
+    }
+
+    // The segment belongs to the frame following the source's back frame
+    const auto frameIndex = _sourceBuffers[sourceIndex].getBackFrameIndex() + 1;
+    if (frameIndex <= _lastFrameComplete)
+        return;
+
+    auto& timestamps = _getFrameInfo(frameIndex).timestamps;
+    if (timestamps.received == 0)
+        timestamps.received = currentTimestamp();
+}
+
+void ReceiveBuffer::_dropStaleFrames()
+{
+    // Only the latest complete frame is ever dispatched, release older ones
+    if (_synchronization == SourceSynchronization::independent)
+    {
+        for (auto& kv : _sourceBuffers)
+        {
+            auto& buffer = kv.second;
+            while (buffer.getQueueSize() > 2)
+            {
+                _bufferedBytes -= buffer.getBufferedBytes();
+                buffer.pop(_staleSegments);
+                _bufferedBytes += buffer.getBufferedBytes();
+                _recycleStaleSegments();
+                ++_droppedFrames;
+            }
+        }
+        return;
+    }
+
+    const bool deadline = _synchronization == SourceSynchronization::deadline;
+    while (_hasCompleteFrames(2) || (deadline && _isDeadlineExceeded(2)))
+    {
+        // Not counted as popped, only dispatched frames make the metrics
+        _popFrame(_staleSegments);
+        _recycleStaleSegments();
+        ++_droppedFrames;
+    }
+}
+
+void ReceiveBuffer::_recycleStaleSegments()
+{
+    if (_framePool)
+        _framePool->recycle(_staleSegments);
+    else
+        _staleSegments.clear();
+}
 }
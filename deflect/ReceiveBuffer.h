@@ -40,6 +40,8 @@
 #ifndef DEFLECT_RECEIVEBUFFER_H
 #define DEFLECT_RECEIVEBUFFER_H
 
+#include <deflect/Frame.h>
+#include <deflect/Metrics.h>
 #include <deflect/Segment.h>
 #include <deflect/SourceBuffer.h>
 #include <deflect/api.h>
@@ -47,6 +49,7 @@
 
 #include <QSize>
 
+#include <deque>
 #include <map>
 #include <queue>
 
@@ -86,35 +89,198 @@ public:
      */
     DEFLECT_API void insert(const Segment& segment, size_t sourceIndex);
 
+    /**
+     * Move a segment into the current frame and source.
+     * @param segment The segment to insert
+     * @param sourceIndex Unique source identifier
+     */
+    DEFLECT_API void insert(Segment&& segment, size_t sourceIndex);
+
     /**
      * Call when the source has finished sending segments for the current frame.
+     *
+     * Only the latest complete frame is kept: older complete frames are
+     * dropped as soon as a newer frame is completed by all sources.
+     *
      * @param sourceIndex Unique source identifier
-     * @throw std::runtime_error if the buffer exceeds its maximum size
+     * @param frameId Identifier of the frame given by the source, 0 if unknown
+     * @param timestamps Times of capture and sending of the frame by the
+     *        source and of reception of its first segment, if known. The
+     *        others are determined by the buffer.
+     * @throw std::runtime_error if the buffer exceeds its maximum size, either
+     *        in number of frames or in bytes.
      */
-    DEFLECT_API void finishFrameForSource(size_t sourceIndex);
+    DEFLECT_API void finishFrameForSource(
+        size_t sourceIndex, uint64_t frameId = 0,
+        const FrameTimestamps& timestamps = FrameTimestamps());
 
     /** Does the Buffer have a new complete frame (from all sources) */
     DEFLECT_API bool hasCompleteFrame() const;
 
+    /** @return the number of image data bytes held by the buffer. */
+    DEFLECT_API size_t getBufferedBytes() const;
+
+    /**
+     * Set the maximum number of image data bytes held by the buffer.
+     * @param bytes the maximum size, 0 for unlimited
+     * @see finishFrameForSource()
+     */
+    DEFLECT_API void setMaxBufferedBytes(size_t bytes);
+
+    /** @return the number of complete frames dropped before being popped. */
+    DEFLECT_API size_t getDroppedFrameCount() const;
+
+    /**
+     * Set how the frames of the different sources are synchronized.
+     *
+     * With SourceSynchronization::deadline, a frame finished by some of the
+     * sources is complete once the deadline has elapsed since the first of
+     * them finished it. The other sources contribute the segments of their
+     * previous frame, and their own late frame replaces them afterwards.
+     *
+     * With SourceSynchronization::independent, a frame is complete as soon as
+     * any source finished a new frame, combined with the latest frame of each
+     * of the other sources.
+     *
+     * @param sync the synchronization policy (default: strict)
+     * @note must be set before adding sources.
+     */
+    DEFLECT_API void setSynchronization(SourceSynchronization sync);
+
+    /** @return how the frames of the different sources are synchronized. */
+    DEFLECT_API SourceSynchronization getSynchronization() const;
+
+    /**
+     * Set the deadline for SourceSynchronization::deadline.
+     * @param ms the time to wait for late sources, in milliseconds
+     */
+    DEFLECT_API void setDeadline(int ms);
+
+    /** @return the deadline for SourceSynchronization::deadline. */
+    DEFLECT_API int getDeadline() const;
+
+    /**
+     * @return the sources which have not finished the next frame yet, while
+     *         other sources already have.
+     */
+    DEFLECT_API std::vector<size_t> getLateSources() const;
+
     /**
      * Get the finished frame.
+     *
+     * The segments are moved out of the buffer without copying.
      * @return A collection of segments that form a frame
      */
     DEFLECT_API Segments popFrame();
 
-    /** Allow this buffer to be used by the next
-     * FrameDispatcher::sendLatestFrame */
+    /**
+     * Get the finished frame into an existing container.
+     *
+     * @param segments The container to which the segments that form the frame
+     *        are appended, which allows reusing its memory.
+     */
+    DEFLECT_API void popFrame(Segments& segments);
+
+    /**
+     * Get the finished frame with its identifier and timestamps.
+     *
+     * @param frame The frame to which the segments are appended.
+     */
+    DEFLECT_API void popFrame(Frame& frame);
+
+    /**
+     * Set a pool in which the memory of dropped frames is recycled.
+     * @param pool the pool to use, nullptr to free the memory instead
+     */
+    DEFLECT_API void setFramePool(std::shared_ptr<FramePool> pool);
+
+    /**
+     * Allow this buffer to be used by the next
+     * FrameDispatcher::sendLatestFrame.
+     *
+     * Disallowing it marks the dispatching of a frame, the time until it is
+     * allowed again is reported as StreamMetrics::requestTimeMs.
+     */
     DEFLECT_API void setAllowedToSend(bool enable);
 
     /** @return true if this buffer can be sent by FrameDispatcher */
     DEFLECT_API bool isAllowedToSend() const;
 
+    /**
+     * @return the counters and timings accumulated by the buffer, without the
+     *         uri of the stream.
+     */
+    DEFLECT_API StreamMetrics getMetrics() const;
+
 private:
     using SourceBufferMap = std::map<size_t, SourceBuffer>;
 
     FrameIndex _lastFrameComplete = 0;
     SourceBufferMap _sourceBuffers;
     bool _allowedToSend = false;
+
+    SourceSynchronization _synchronization = SourceSynchronization::strict;
+    int _deadline = 0;
+
+    /** Segments of the previous frame of each source, except if strict. */
+    std::map<size_t, Segments> _previousSegments;
+
+    /** Number of sources which finished each frame after the last complete */
+    std::deque<size_t> _finishedSourcesCount;
+
+    size_t _bufferedBytes = 0;
+    size_t _maxBufferedBytes = 0;
+    size_t _droppedFrames = 0;
+
+    std::shared_ptr<FramePool> _framePool;
+    Segments _staleSegments;
+
+    struct FrameInfo
+    {
+        uint64_t id = 0;
+        FrameTimestamps timestamps;
+        int64_t firstFinished = 0;
+    };
+
+    /** Identifier and timestamps of each frame after the last complete */
+    std::deque<FrameInfo> _frameInfos;
+    FrameInfo _lastPoppedFrame;
+
+    /** Latest source frame and pending reception times, if independent */
+    FrameInfo _latestFrame;
+    std::map<size_t, int64_t> _receiveTimes;
+
+    int64_t _dispatchTime = 0;
+    bool _dispatched = false;
+
+    std::map<size_t, SourceMetrics> _sourceMetrics;
+    size_t _framesReceived = 0;
+    size_t _framesCompleted = 0;
+    size_t _framesDispatched = 0;
+    size_t _framesPopped = 0;
+    size_t _segmentsPopped = 0;
+    size_t _bytesReceived = 0;
+    size_t _requestCount = 0;
+
+    /** Sums of the durations in microseconds, with the number of samples */
+    std::pair<int64_t, size_t> _captureToSend{0, 0};
+    std::pair<int64_t, size_t> _sendToReceive{0, 0};
+    std::pair<int64_t, size_t> _receiveToComplete{0, 0};
+    std::pair<int64_t, size_t> _completeToDispatch{0, 0};
+    int64_t _requestTime = 0;
+
+    bool _hasCompleteFrames(FrameIndex count) const;
+    FrameInfo& _getFrameInfo(FrameIndex frameIndex);
+    bool _isDeadlineExceeded(FrameIndex count) const;
+    void _popFrame(Segments& frame);
+    void _popSource(size_t sourceIndex, bool finished, Segments& frame);
+    void _catchUp(size_t sourceIndex);
+    void _finishIndependentFrame(size_t sourceIndex, uint64_t frameId,
+                                 const FrameTimestamps& timestamps);
+    void _completeFrame(FrameInfo& info);
+    void _recordSegment(const Segment& segment, size_t sourceIndex);
+    void _dropStaleFrames();
+    void _recycleStaleSegments();
 };
 }
 
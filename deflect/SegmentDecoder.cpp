@@ -39,12 +39,19 @@
 
 #include "SegmentDecoder.h"
 
+#include "Frame.h"
 #include "ImageJpegDecompressor.h"
 #include "Segment.h"
 
+#include <algorithm>
+#include <functional>
 #include <iostream>
+#include <string>
+#include <vector>
 
 #include <QFuture>
+#include <QThreadStorage>
+#include <QtConcurrentMap>
 #include <QtConcurrentRun>
 
 namespace deflect
@@ -77,27 +84,96 @@ ChromaSubsampling SegmentDecoder::decodeType(const Segment& segment)
     return _impl->decompressor.decompressHeader(segment.imageData).subsampling;
 }
 
-size_t _getExpectedSize(const DataType dataType,
-                        const SegmentParameters& params)
+/** The row size in bytes and the number of rows of an image plane. */
+struct Plane
 {
-    const size_t imageSize = params.height * params.width;
+    size_t rowSize;
+    size_t rows;
+};
+
+std::vector<Plane> _getPlanes(const DataType dataType, const size_t width,
+                              const size_t height)
+{
+    // Subsampled chroma planes are rounded up for odd dimensions
+    const size_t chromaWidth = (width + 1) / 2;
+    const size_t chromaHeight = (height + 1) / 2;
     switch (dataType)
     {
     case DataType::rgba:
-        return imageSize * 4;
+        return {{width * 4, height}};
     case DataType::yuv444:
-        return imageSize * 3;
+        return {{width, height}, {width, height}, {width, height}};
     case DataType::yuv422:
-        return imageSize * 2;
+        return {{width, height}, {chromaWidth, height}, {chromaWidth, height}};
     case DataType::yuv420:
-        return imageSize + (imageSize >> 1);
+        return {{width, height},
+                {chromaWidth, chromaHeight},
+                {chromaWidth, chromaHeight}};
     default:
-        return 0;
+        return {};
     };
 }
 
+size_t _getExpectedSize(const DataType dataType, const size_t width,
+                        const size_t height)
+{
+    size_t size = 0;
+    for (const auto& plane : _getPlanes(dataType, width, height))
+        size += plane.rowSize * plane.rows;
+    return size;
+}
+
+QByteArray _crop(const QByteArray& data, const DataType dataType,
+                 const size_t width, const size_t height,
+                 const size_t croppedWidth, const size_t croppedHeight)
+{
+    const auto planes = _getPlanes(dataType, width, height);
+    const auto croppedPlanes =
+        _getPlanes(dataType, croppedWidth, croppedHeight);
+
+    const auto croppedSize =
+        _getExpectedSize(dataType, croppedWidth, croppedHeight);
+    QByteArray cropped;
+    cropped.resize(int(croppedSize));
+
+    const char* in = data.constData();
+    char* out = cropped.data();
+    for (size_t i = 0; i < planes.size(); ++i)
+    {
+        for (size_t row = 0; row < croppedPlanes[i].rows; ++row)
+        {
+            std::copy(in + row * planes[i].rowSize,
+                      in + row * planes[i].rowSize + croppedPlanes[i].rowSize,
+                      out + row * croppedPlanes[i].rowSize);
+        }
+        in += planes[i].rowSize * planes[i].rows;
+        out += croppedPlanes[i].rowSize * croppedPlanes[i].rows;
+    }
+    return cropped;
+}
+
+uint32_t _getScaledSize(const uint32_t size, const unsigned int scale)
+{
+    if (scale != 1 && scale != 2 && scale != 4 && scale != 8)
+        throw std::invalid_argument("unsupported scale factor " +
+                                    std::to_string(scale));
+    return (size + scale - 1) / scale;
+}
+
+void _scaleParameters(SegmentParameters& params, const unsigned int scale)
+{
+    // Scale the edges rather than the size so that adjacent segments share
+    // their scaled edges and still tile the frame without overlaps or gaps
+    const auto right = _getScaledSize(params.x + params.width, scale);
+    const auto bottom = _getScaledSize(params.y + params.height, scale);
+    params.x = _getScaledSize(params.x, scale);
+    params.y = _getScaledSize(params.y, scale);
+    params.width = right - params.x;
+    params.height = bottom - params.y;
+}
+
 void _decodeSegment(ImageJpegDecompressor* decompressor, Segment* segment,
-                    const bool skipRgbConversion)
+                    const bool skipRgbConversion, const unsigned int scale)
 {
     if (segment->parameters.dataType != DataType::jpeg)
         return;
@@ -109,7 +185,8 @@ void _decodeSegment(ImageJpegDecompressor* decompressor, Segment* segment,
 #ifndef DEFLECT_USE_LEGACY_LIBJPEGTURBO
         if (skipRgbConversion)
         {
-            const auto yuv = decompressor->decompressToYUV(segment->imageData);
+            const auto yuv =
+                decompressor->decompressToYUV(segment->imageData, scale);
             decodedData = yuv.first;
             switch (yuv.second)
             {
@@ -131,7 +208,7 @@ void _decodeSegment(ImageJpegDecompressor* decompressor, Segment* segment,
         Q_UNUSED(skipRgbConversion);
 #endif
         {
-            decodedData = decompressor->decompress(segment->imageData);
+            decodedData = decompressor->decompress(segment->imageData, scale);
             dataType = DataType::rgba;
         }
     }
@@ -140,24 +217,183 @@ void _decodeSegment(ImageJpegDecompressor* decompressor, Segment* segment,
         throw;
     }
 
-    const auto expectedSize = _getExpectedSize(dataType, segment->parameters);
+    const auto width = _getScaledSize(segment->parameters.width, scale);
+    const auto height = _getScaledSize(segment->parameters.height, scale);
+    const auto expectedSize = _getExpectedSize(dataType, width, height);
     if (size_t(decodedData.size()) != expectedSize)
         throw std::runtime_error("unexpected segment size");
 
+    auto parameters = segment->parameters;
+    _scaleParameters(parameters, scale);
+
+    // A segment which is not aligned on the scale factor covers one pixel less
+    // than its decoded image in the scaled frame
+    if (parameters.width != width || parameters.height != height)
+    {
+        decodedData = _crop(decodedData, dataType, width, height,
+                            parameters.width, parameters.height);
+    }
+
     segment->imageData = decodedData;
+    segment->parameters = parameters;
     segment->parameters.dataType = dataType;
 }
 
-void SegmentDecoder::decode(Segment& segment)
+void _decodeFrameSegment(Segment* segment, const bool skipRgbConversion,
+                         const unsigned int scale)
+{
+    // Each thread of the pool uses its own decompressor
+    static QThreadStorage<ImageJpegDecompressor> decompressor;
+    try
+    {
+        _decodeSegment(&decompressor.localData(), segment, skipRgbConversion,
+                       scale);
+    }
+    catch (...)
+    {
+        segment->exception = std::current_exception();
+    }
+}
+
+void _decodeSegments(std::vector<Segment*>& segments,
+                     const bool skipRgbConversion, const unsigned int scale)
+{
+    QtConcurrent::blockingMap(segments, std::bind(&_decodeFrameSegment,
+                                                  std::placeholders::_1,
+                                                  skipRgbConversion, scale));
+
+    std::exception_ptr exception;
+    for (auto segment : segments)
+    {
+        if (segment->exception && !exception)
+            exception = segment->exception;
+        segment->exception = nullptr;
+    }
+    if (exception)
+        std::rethrow_exception(exception);
+}
+
+void _decodeFrame(Frame& frame, const bool skipRgbConversion,
+                  const unsigned int scale)
+{
+    std::vector<Segment*> segments;
+    segments.reserve(frame.segments.size());
+    for (auto& segment : frame.segments)
+        segments.push_back(&segment);
+
+    _decodeSegments(segments, skipRgbConversion, scale);
+    if (scale != 1)
+        frame.invalidateIndex();
+}
+
+void _decodeFrame(Frame& frame, const QRect& viewport,
+                  const bool skipRgbConversion)
+{
+    auto segments = frame.segmentsIntersecting(viewport);
+    _decodeSegments(segments, skipRgbConversion, 1);
+}
+
+void SegmentDecoder::decode(Segment& segment, const unsigned int scale)
+{
+    _decodeSegment(&_impl->decompressor, &segment, false, scale);
+}
+
+JpegHeader _decodeHeader(ImageJpegDecompressor& decompressor,
+                         const Segment& segment)
+{
+    if (segment.parameters.dataType != DataType::jpeg)
+        throw std::runtime_error("Segment is not in JPEG format");
+
+    const auto header = decompressor.decompressHeader(segment.imageData);
+    if (uint32_t(header.width) != segment.parameters.width ||
+        uint32_t(header.height) != segment.parameters.height)
+    {
+        throw std::runtime_error("unexpected segment size");
+    }
+    return header;
+}
+
+void SegmentDecoder::decode(const Segment& segment, void* buffer,
+                            const size_t pitch, const PixelFormat format,
+                            const unsigned int scale)
+{
+    if (format < RGB || format > ABGR)
+        throw std::invalid_argument("unknown pixel format");
+
+    const auto width = _getScaledSize(segment.parameters.width, scale);
+    const ImageWrapper image(nullptr, width, 1, format);
+    if (pitch > 0 && pitch < image.getBufferSize())
+        throw std::invalid_argument("pitch is smaller than the segment width");
+
+    const auto header = _decodeHeader(_impl->decompressor, segment);
+    _impl->decompressor.decompress(segment.imageData, header, buffer,
+                                   int(pitch), format, scale);
+}
+
+#ifndef DEFLECT_USE_LEGACY_LIBJPEGTURBO
+
+void SegmentDecoder::decodeToYUV(Segment& segment, const unsigned int scale)
+{
+    _decodeSegment(&_impl->decompressor, &segment, true, scale);
+}
+
+void SegmentDecoder::decodeToYUV(const Segment& segment,
+                                 unsigned char* planes[3], const int strides[3],
+                                 const unsigned int scale)
+{
+    const auto header = _decodeHeader(_impl->decompressor, segment);
+    _impl->decompressor.decompressToYUV(segment.imageData, header, planes,
+                                        strides, scale);
+}
+
+#endif
+
+void SegmentDecoder::decode(Frame& frame, const unsigned int scale)
+{
+    _decodeFrame(frame, false, scale);
+}
+
+#ifndef DEFLECT_USE_LEGACY_LIBJPEGTURBO
+
+void SegmentDecoder::decodeToYUV(Frame& frame, const unsigned int scale)
+{
+    _decodeFrame(frame, true, scale);
+}
+
+#endif
+
+void SegmentDecoder::decode(Frame& frame, const QRect& viewport)
+{
+    _decodeFrame(frame, viewport, false);
+}
+
+#ifndef DEFLECT_USE_LEGACY_LIBJPEGTURBO
+
+void SegmentDecoder::decodeToYUV(Frame& frame, const QRect& viewport)
+{
+    _decodeFrame(frame, viewport, true);
+}
+
+#endif
+
+std::future<void> SegmentDecoder::decodeAsync(FramePtr frame,
+                                              const unsigned int scale)
 {
-    _decodeSegment(&_impl->decompressor, &segment, false);
+    // Not using QtConcurrent::run, blockingMap must not be called from a thread
+    // of the global pool which it would otherwise compete with.
+    return std::async(std::launch::async, [frame, scale] {
+        _decodeFrame(*frame, false, scale);
+    });
 }
 
 #ifndef DEFLECT_USE_LEGACY_LIBJPEGTURBO
 
-void SegmentDecoder::decodeToYUV(Segment& segment)
+std::future<void> SegmentDecoder::decodeToYUVAsync(FramePtr frame,
+                                                   const unsigned int scale)
 {
-    _decodeSegment(&_impl->decompressor, &segment, true);
+    return std::async(std::launch::async, [frame, scale] {
+        _decodeFrame(*frame, true, scale);
+    });
 }
 
 #endif
@@ -175,7 +411,7 @@ void SegmentDecoder::startDecoding(Segment& segment)
 
     _impl->decodingFuture =
         QtConcurrent::run(_decodeSegment, &_impl->decompressor, &segment,
-                          false);
+                          false, 1u);
 }
 
 void SegmentDecoder::waitDecoding()
@@ -40,10 +40,13 @@
 #ifndef DEFLECT_SEGMENTDECODER_H
 #define DEFLECT_SEGMENTDECODER_H
 
+#include <deflect/ImageWrapper.h>
 #include <deflect/api.h>
 #include <deflect/defines.h>
 #include <deflect/types.h>
 
+#include <QRect>
+
 namespace deflect
 {
 /**
@@ -69,24 +72,168 @@ public:
     /**
      * Decode a JPEG segment to RGB.
      *
+     * The image can be downscaled during decompression at a fraction of the
+     * cost of a full resolution decoding, for display in smaller windows. The
+     * segment parameters are then adjusted to the scaled position and size.
+     * The edges of the segment are scaled (rounded up), so that the segments
+     * of a frame still tile the scaled frame; a segment whose position is not
+     * a multiple of the scale factor is cropped by one pixel if needed.
+     *
      * @param segment The segment to decode. Upon success, its imageData member
      *        will hold the decompressed RGB image and its "dataType" flag will
      *        be set to DataType::rgba.
+     * @param scale The downscaling factor of the output: 1, 2, 4 or 8.
+     * @throw std::invalid_argument if the scale factor is not supported
      * @throw std::runtime_error if a decompression error occured
      */
-    DEFLECT_API void decode(Segment& segment);
+    DEFLECT_API void decode(Segment& segment, unsigned int scale = 1);
+
+    /**
+     * Decode a JPEG segment directly into a caller-provided buffer.
+     *
+     * This avoids the intermediate allocation and copy of decode(Segment&),
+     * for instance when decoding into mapped texture memory.
+     *
+     * @param segment The segment to decode, which is not modified.
+     * @param buffer The output buffer, of at least pitch * height bytes.
+     * @param pitch The number of bytes per line in the output buffer, or 0
+     *        for a tightly packed image.
+     * @param format The pixel format of the output.
+     * @param scale The downscaling factor of the output: 1, 2, 4 or 8.
+     * @throw std::invalid_argument if the pitch, format or scale is invalid
+     * @throw std::runtime_error if a decompression error occured or if the
+     *        image does not match the segment parameters
+     * @see decode(Segment&, unsigned int)
+     */
+    DEFLECT_API void decode(const Segment& segment, void* buffer, size_t pitch,
+                            PixelFormat format = RGBA, unsigned int scale = 1);
 
 #ifndef DEFLECT_USE_LEGACY_LIBJPEGTURBO
 
+    /**
+     * Decode a JPEG segment to caller-provided Y, U and V planes.
+     *
+     * The dimensions of the U and V planes depend on the chroma subsampling of
+     * the segment, which can be obtained beforehand with decodeType().
+     *
+     * @param segment The segment to decode, which is not modified.
+     * @param planes The output Y, U and V planes.
+     * @param strides The number of bytes per line of each plane, or 0 for
+     *        tightly packed planes.
+     * @param scale The downscaling factor of the output: 1, 2, 4 or 8.
+     * @throw std::invalid_argument if the scale factor is not supported
+     * @throw std::runtime_error if a decompression error occured or if the
+     *        image does not match the segment parameters
+     */
+    DEFLECT_API void decodeToYUV(const Segment& segment,
+                                 unsigned char* planes[3],
+                                 const int strides[3], unsigned int scale = 1);
+
     /**
      * Decode a JPEG segment to YUV, skipping the YUV -> RGB step.
      *
      * @param segment The segment to decode. Upon success, its imageData member
      *        will hold the decompressed YUV image and its "dataType" flag will
      *        be set to the matching DataType::yuv4**.
+     * @param scale The downscaling factor of the output: 1, 2, 4 or 8.
+     * @throw std::invalid_argument if the scale factor is not supported
      * @throw std::runtime_error if a decompression error occured
+     * @see decode(Segment&, unsigned int)
+     */
+    DEFLECT_API void decodeToYUV(Segment& segment, unsigned int scale = 1);
+
+#endif
+
+    /**
+     * Decode all the JPEG segments of a frame to RGB in parallel.
+     *
+     * The segments are decoded concurrently in the global thread pool, each
+     * thread using its own decompressor. Segments which are not in JPEG format
+     * are left untouched.
+     *
+     * @param frame The frame to decode. Upon success, the imageData member of
+     *        all its segments will hold the decompressed RGB images and their
+     *        "dataType" flag will be set to DataType::rgba.
+     * @param scale The downscaling factor of the output: 1, 2, 4 or 8.
+     * @throw std::runtime_error if a decompression error occured for any of
+     *        the segments; the other segments are still decoded.
+     * @see decode(Segment&, unsigned int)
+     */
+    DEFLECT_API void decode(Frame& frame, unsigned int scale = 1);
+
+#ifndef DEFLECT_USE_LEGACY_LIBJPEGTURBO
+
+    /**
+     * Decode all the JPEG segments of a frame to YUV in parallel.
+     *
+     * @param frame The frame to decode.
+     * @param scale The downscaling factor of the output: 1, 2, 4 or 8.
+     * @throw std::runtime_error if a decompression error occured
+     * @see decode(Frame&, unsigned int)
+     * @see decodeToYUV(Segment&, unsigned int)
+     */
+    DEFLECT_API void decodeToYUV(Frame& frame, unsigned int scale = 1);
+
+#endif
+
+    /**
+     * Decode only the JPEG segments of a frame visible in a viewport.
+     *
+     * Segments outside of the viewport are left untouched, which saves most of
+     * the decoding work when only a part of a large frame is displayed. The
+     * segments are decoded at full resolution, so that all the segments of the
+     * frame keep the same coordinates.
+     *
+     * @param frame The frame to decode.
+     * @param viewport The visible region, in frame coordinates.
+     * @throw std::runtime_error if a decompression error occured
+     * @see decode(Frame&, unsigned int)
+     * @see Frame::segmentsIntersecting()
+     */
+    DEFLECT_API void decode(Frame& frame, const QRect& viewport);
+
+#ifndef DEFLECT_USE_LEGACY_LIBJPEGTURBO
+
+    /**
+     * Decode only the JPEG segments of a frame visible in a viewport to YUV.
+     *
+     * @param frame The frame to decode.
+     * @param viewport The visible region, in frame coordinates.
+     * @throw std::runtime_error if a decompression error occured
+     * @see decode(Frame&, const QRect&)
+     */
+    DEFLECT_API void decodeToYUV(Frame& frame, const QRect& viewport);
+
+#endif
+
+    /**
+     * Decode all the JPEG segments of a frame to RGB asynchronously.
+     *
+     * @param frame The frame to decode, which must not be accessed until the
+     *        returned future is ready.
+     * @return a future that is ready when all segments are decoded, holding
+     *         a std::runtime_error if a decompression error occured. Note that
+     *         its destructor blocks until the decoding has completed.
+     * @param scale The downscaling factor of the output: 1, 2, 4 or 8.
+     * @see decode(Frame&, unsigned int)
+     */
+    DEFLECT_API std::future<void> decodeAsync(FramePtr frame,
+                                              unsigned int scale = 1);
+
+#ifndef DEFLECT_USE_LEGACY_LIBJPEGTURBO
+
+    /**
+     * Decode all the JPEG segments of a frame to YUV asynchronously.
+     *
+     * @param frame The frame to decode, which must not be accessed until the
+     *        returned future is ready.
+     * @param scale The downscaling factor of the output: 1, 2, 4 or 8.
+     * @return a future that is ready when all segments are decoded.
+     * @see decodeAsync()
+     * @see decodeToYUV(Frame&, unsigned int)
      */
-    DEFLECT_API void decodeToYUV(Segment& segment);
+    DEFLECT_API std::future<void> decodeToYUVAsync(FramePtr frame,
+                                                   unsigned int scale = 1);
 
 #endif
 
@@ -94,7 +241,7 @@ public:
      * Start decoding a segment.
      *
      * This function will silently ignore the request if a decoding is already
-     * in progress.
+     * in progress. Use decodeAsync() to decode all the segments of a frame.
      * @param segment The segement to decode. The segment will be modified by
      *        this function. It must remain valid and should not be accessed
      *        until the decoding procedure has completed.
@@ -46,6 +46,7 @@
 
 #include <QNetworkProxy>
 #include <QThread>
+#include <QTimer>
 #include <stdexcept>
 
 namespace deflect
@@ -62,6 +63,8 @@ public:
     }
 
     FrameDispatcher* frameDispatcher;
+    SegmentDecoding segmentDecoding = SegmentDecoding::none;
+    QTimer metricsTimer;
 };
 
 Server::Server(const int port)
@@ -83,8 +86,13 @@ Server::Server(const int port)
             &Server::pixelStreamClosed);
     connect(_impl->frameDispatcher, &FrameDispatcher::sendFrame, this,
             &Server::receivedFrame);
+    connect(_impl->frameDispatcher, &FrameDispatcher::cursorChanged, this,
+            &Server::receivedCursor);
     connect(_impl->frameDispatcher, &FrameDispatcher::bufferSizeExceeded, this,
             &Server::closePixelStream);
+
+    connect(&_impl->metricsTimer, &QTimer::timeout,
+            [this] { emit metricsUpdated(getMetrics()); });
 }
 
 Server::~Server()
@@ -99,6 +107,91 @@ Server::~Server()
     }
 }
 
+void Server::setSegmentDecoding(const SegmentDecoding decoding)
+{
+#ifndef DEFLECT_USE_LIBJPEGTURBO
+    if (decoding != SegmentDecoding::none)
+        throw std::invalid_argument("Deflect was built without libjpegturbo");
+#elif defined(DEFLECT_USE_LEGACY_LIBJPEGTURBO)
+    if (decoding == SegmentDecoding::yuv)
+        throw std::invalid_argument("YUV decoding requires libjpegturbo 1.4+");
+#endif
+    _impl->segmentDecoding = decoding;
+}
+
+SegmentDecoding Server::getSegmentDecoding() const
+{
+    return _impl->segmentDecoding;
+}
+
+void Server::setMaxStreamBufferSize(const size_t bytes)
+{
+    _impl->frameDispatcher->setMaxStreamBufferSize(bytes);
+}
+
+size_t Server::getMaxStreamBufferSize() const
+{
+    return _impl->frameDispatcher->getMaxStreamBufferSize();
+}
+
+void Server::setMaxBufferSize(const size_t bytes)
+{
+    _impl->frameDispatcher->setMaxBufferSize(bytes);
+}
+
+size_t Server::getMaxBufferSize() const
+{
+    return _impl->frameDispatcher->getMaxBufferSize();
+}
+
+void Server::setSourceSynchronization(const SourceSynchronization sync)
+{
+    _impl->frameDispatcher->setSourceSynchronization(sync);
+}
+
+SourceSynchronization Server::getSourceSynchronization() const
+{
+    return _impl->frameDispatcher->getSourceSynchronization();
+}
+
+void Server::setSynchronizationDeadline(const int ms)
+{
+    _impl->frameDispatcher->setSynchronizationDeadline(ms);
+}
+
+int Server::getSynchronizationDeadline() const
+{
+    return _impl->frameDispatcher->getSynchronizationDeadline();
+}
+
+void Server::setViewHiddenTimeout(const int ms)
+{
+    _impl->frameDispatcher->setViewHiddenTimeout(ms);
+}
+
+int Server::getViewHiddenTimeout() const
+{
+    return _impl->frameDispatcher->getViewHiddenTimeout();
+}
+
+ServerMetrics Server::getMetrics() const
+{
+    return _impl->frameDispatcher->getMetrics();
+}
+
+void Server::setMetricsInterval(const int ms)
+{
+    if (ms > 0)
+        _impl->metricsTimer.start(ms);
+    else
+        _impl->metricsTimer.stop();
+}
+
+int Server::getMetricsInterval() const
+{
+    return _impl->metricsTimer.isActive() ? _impl->metricsTimer.interval() : 0;
+}
+
 void Server::requestFrame(const QString uri)
 {
     _impl->frameDispatcher->requestFrame(uri);
@@ -113,7 +206,9 @@ void Server::closePixelStream(const QString uri)
 void Server::incomingConnection(const qintptr socketHandle)
 {
     QThread* workerThread = new QThread(this);
-    ServerWorker* worker = new ServerWorker(socketHandle);
+    ServerWorker* worker =
+        new ServerWorker(socketHandle, _impl->segmentDecoding,
+                         _impl->frameDispatcher->getFramePool());
 
     worker->moveToThread(workerThread);
 
@@ -140,16 +235,26 @@ void Server::incomingConnection(const qintptr socketHandle)
     // FrameDispatcher
     connect(worker, &ServerWorker::addStreamSource, _impl->frameDispatcher,
             &FrameDispatcher::addSource);
-    connect(worker, &ServerWorker::receivedSegment, _impl->frameDispatcher,
-            &FrameDispatcher::processSegment);
+    connect(worker, &ServerWorker::receivedSegments, _impl->frameDispatcher,
+            &FrameDispatcher::processSegments);
     connect(worker, &ServerWorker::receivedFrameFinished,
             _impl->frameDispatcher, &FrameDispatcher::processFrameFinished);
+    connect(worker, &ServerWorker::receivedCursor, _impl->frameDispatcher,
+            &FrameDispatcher::processCursor);
     connect(worker, &ServerWorker::removeStreamSource, _impl->frameDispatcher,
             &FrameDispatcher::removeSource);
     connect(worker, &ServerWorker::addObserver, _impl->frameDispatcher,
             &FrameDispatcher::addObserver);
     connect(worker, &ServerWorker::removeObserver, _impl->frameDispatcher,
             &FrameDispatcher::removeObserver);
+    connect(worker, &ServerWorker::subscribeToFrames, _impl->frameDispatcher,
+            &FrameDispatcher::addFrameSubscriber);
+    connect(worker, &ServerWorker::unsubscribeFromFrames,
+            _impl->frameDispatcher, &FrameDispatcher::removeFrameSubscriber);
+    connect(_impl->frameDispatcher, &FrameDispatcher::forwardFrame, worker,
+            &ServerWorker::sendFrame);
+    connect(_impl->frameDispatcher, &FrameDispatcher::viewVisibilityChanged,
+            worker, &ServerWorker::notifyViewVisibility);
 
     workerThread->start();
 }
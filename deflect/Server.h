@@ -41,6 +41,8 @@
 #ifndef DEFLECT_SERVER_H
 #define DEFLECT_SERVER_H
 
+#include <deflect/Frame.h>
+#include <deflect/Metrics.h>
 #include <deflect/SizeHints.h>
 #include <deflect/api.h>
 #include <deflect/types.h>
@@ -76,6 +78,122 @@ public:
     /** Stop the server and close all open pixel stream connections. */
     ~Server();
 
+    /**
+     * Set the decoding applied to incoming JPEG segments.
+     *
+     * When enabled, segments are decompressed in a thread pool as soon as they
+     * are received, overlapping decoding with the reception of the rest of the
+     * frame. The receivedFrame() signal then delivers segments which are
+     * already of DataType::rgba, resp. DataType::yuv4**. The compressed
+     * segments are not kept, so frame subscribers (see
+     * Observer::subscribeToFrames()) also receive the decoded segments.
+     *
+     * The setting only applies to connections opened after this call.
+     *
+     * @param decoding the decoding to apply (default: SegmentDecoding::none)
+     * @throw std::invalid_argument if the requested decoding is not supported
+     *        by this build of Deflect.
+     */
+    void setSegmentDecoding(SegmentDecoding decoding);
+
+    /** @return the decoding applied to incoming JPEG segments. */
+    SegmentDecoding getSegmentDecoding() const;
+
+    /**
+     * Set the maximum number of image bytes buffered for each stream.
+     *
+     * Only the latest complete frame of a stream is kept until it is requested
+     * with requestFrame(), older frames are dropped. Streams exceeding the
+     * limit (for instance because one of their sources stopped sending frames)
+     * are closed.
+     *
+     * @param bytes the maximum size, 0 for unlimited (default: 1 GiB)
+     */
+    void setMaxStreamBufferSize(size_t bytes);
+
+    /** @return the maximum number of image bytes buffered for each stream. */
+    size_t getMaxStreamBufferSize() const;
+
+    /**
+     * Set the maximum number of image bytes buffered for all streams.
+     *
+     * A stream which causes this limit to be exceeded is closed.
+     *
+     * @param bytes the maximum size, 0 for unlimited (default)
+     */
+    void setMaxBufferSize(size_t bytes);
+
+    /** @return the maximum number of image bytes buffered for all streams. */
+    size_t getMaxBufferSize() const;
+
+    /**
+     * Set how the frames of the multiple sources of a stream are synchronized.
+     *
+     * By default, a frame is complete once all the sources of the stream have
+     * finished it, so a single stalled source freezes the whole stream. With
+     * SourceSynchronization::deadline, frames are completed after the
+     * synchronization deadline even if some sources are late, reusing the
+     * segments of their previous frame. With
+     * SourceSynchronization::independent, each new frame of any source
+     * completes a frame, combined with the latest frame of the other sources.
+     *
+     * The setting only applies to streams opened after this call. The late
+     * sources of each stream are reported by getMetrics().
+     *
+     * @param sync the synchronization policy (default: strict)
+     * @version 1.8
+     */
+    void setSourceSynchronization(SourceSynchronization sync);
+
+    /** @return how the frames of the sources of a stream are synchronized. */
+    SourceSynchronization getSourceSynchronization() const;
+
+    /**
+     * Set the time to wait for late sources with
+     * SourceSynchronization::deadline.
+     *
+     * @param ms the deadline in milliseconds (default: 100)
+     * @version 1.8
+     */
+    void setSynchronizationDeadline(int ms);
+
+    /** @return the time to wait for late sources, in milliseconds. */
+    int getSynchronizationDeadline() const;
+
+    /**
+     * Set the time after which the view of a stream is considered hidden.
+     *
+     * When no new frame is requested for this time after the last dispatched
+     * frame, the stream is sent an Event::EVT_VIEW_HIDDEN so that it can
+     * suspend streaming. The next requestFrame() sends Event::EVT_VIEW_SHOWN.
+     *
+     * @param ms the timeout in milliseconds, 0 to disable (default: 1000)
+     * @version 1.8
+     */
+    void setViewHiddenTimeout(int ms);
+
+    /** @return the time after which an unrequested view is hidden, in ms. */
+    int getViewHiddenTimeout() const;
+
+    /**
+     * Get the counters and timings of all the open streams.
+     *
+     * @return a snapshot of the metrics, accumulated since each stream opened.
+     * @version 1.8
+     */
+    ServerMetrics getMetrics() const;
+
+    /**
+     * Set the interval at which metricsUpdated() is emitted.
+     *
+     * @param ms the interval in milliseconds, 0 to disable (default)
+     * @version 1.8
+     */
+    void setMetricsInterval(int ms);
+
+    /** @return the interval at which metricsUpdated() is emitted. */
+    int getMetricsInterval() const;
+
 public slots:
     /**
      * Request the dispatching of the next frame for a given pixel stream.
@@ -150,6 +268,27 @@ signals:
      */
     void receivedData(QString uri, QByteArray data);
 
+    /**
+     * Emitted periodically with the metrics of all the open streams.
+     *
+     * @param metrics A snapshot of the metrics, as returned by getMetrics().
+     * @see setMetricsInterval()
+     * @version 1.8
+     */
+    void metricsUpdated(deflect::ServerMetrics metrics);
+
+    /**
+     * Emitted when the mouse cursor of a stream changes.
+     *
+     * The cursor is also attached to the frames of the stream, this signal
+     * allows redrawing it when it moves between two frames.
+     *
+     * @param uri Identifier for the stream
+     * @param cursor The new cursor, see Frame::cursor
+     * @version 1.8
+     */
+    void receivedCursor(QString uri, deflect::Cursor cursor);
+
 private:
     class Impl;
     std::unique_ptr<Impl> _impl;
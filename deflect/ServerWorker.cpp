@@ -40,27 +40,71 @@
 
 #include "ServerWorker.h"
 
+#include "Frame.h"
+#include "FramePool.h"
 #include "NetworkProtocol.h"
+#ifdef DEFLECT_USE_LIBJPEGTURBO
+#include "SegmentDecoder.h"
+#endif
 
+#include <algorithm>
+#include <cstddef>
 #include <iostream>
 #include <stdint.h>
 
 #include <QDataStream>
+#include <QFutureWatcher>
+#include <QThreadStorage>
+#include <QtConcurrentRun>
 
 namespace
 {
 const int RECEIVE_TIMEOUT_MS = 3000;
+const size_t MAX_HELD_FRAME_BYTES = 16 * 1024 * 1024;
 }
 
 namespace deflect
 {
-ServerWorker::ServerWorker(const int socketDescriptor)
+namespace
+{
+#ifdef DEFLECT_USE_LIBJPEGTURBO
+Segment _decodeSegment(Segment segment, const SegmentDecoding decoding)
+{
+    if (segment.parameters.dataType != DataType::jpeg)
+        return segment;
+
+    static QThreadStorage<SegmentDecoder> decoders;
+    try
+    {
+#ifndef DEFLECT_USE_LEGACY_LIBJPEGTURBO
+        if (decoding == SegmentDecoding::yuv)
+            decoders.localData().decodeToYUV(segment);
+        else
+#else
+        Q_UNUSED(decoding);
+#endif
+            decoders.localData().decode(segment);
+    }
+    catch (...)
+    {
+        segment.exception = std::current_exception();
+    }
+    return segment;
+}
+#endif
+}
+
+ServerWorker::ServerWorker(const int socketDescriptor,
+                           const SegmentDecoding decoding,
+                           std::shared_ptr<FramePool> framePool)
     : _tcpSocket{new QTcpSocket(this)} // Ensure that _tcpSocket parent is
                                        // *this* so it gets moved to thread
     , _sourceId{socketDescriptor}
-    , _clientProtocolVersion{NETWORK_PROTOCOL_VERSION}
+    , _clientProtocolVersion{0} // unknown until the stream is opened
     , _registeredToEvents{false}
     , _activeView{View::mono}
+    , _segmentDecoding{decoding}
+    , _framePool{framePool ? std::move(framePool) : FramePool::create()}
 {
     if (!_tcpSocket->setSocketDescriptor(socketDescriptor))
     {
@@ -77,6 +121,8 @@ ServerWorker::ServerWorker(const int socketDescriptor)
             &ServerWorker::_processMessages, Qt::QueuedConnection);
     connect(this, &ServerWorker::_dataAvailable, this,
             &ServerWorker::_processMessages, Qt::QueuedConnection);
+    connect(_tcpSocket, &QTcpSocket::bytesWritten, this,
+            &ServerWorker::_sendPendingFrame);
 }
 
 ServerWorker::~ServerWorker()
@@ -87,6 +133,8 @@ ServerWorker::~ServerWorker()
     // more senders contribute to it.
     if (!_streamId.isEmpty())
     {
+        if (_subscribedToFrames)
+            emit unsubscribeFromFrames(_streamId);
         if (_observer)
             emit removeObserver(_streamId);
         else
@@ -105,6 +153,31 @@ void ServerWorker::processEvent(const Event evt)
     emit _dataAvailable();
 }
 
+void ServerWorker::sendFrame(const FramePtr frame)
+{
+    if (!_subscribedToFrames || frame->uri != _streamId)
+        return;
+
+    // A frame which could not be sent yet is replaced by the newer one, so
+    // that a slow observer drops frames instead of accumulating them
+    _pendingFrame = frame;
+    _sendPendingFrame();
+}
+
+void ServerWorker::notifyViewVisibility(const QString uri, const bool visible)
+{
+    if (!_registeredToEvents || uri != _streamId)
+        return;
+
+    // Older clients do not know these event types
+    if (_clientProtocolVersion < FRAME_UPDATES_PROTOCOL_VERSION)
+        return;
+
+    Event event;
+    event.type = visible ? Event::EVT_VIEW_SHOWN : Event::EVT_VIEW_HIDDEN;
+    processEvent(event);
+}
+
 void ServerWorker::initConnection()
 {
     _sendProtocolVersion();
@@ -151,6 +224,11 @@ void ServerWorker::_processMessages()
 void ServerWorker::_receiveMessage()
 {
     const MessageHeader mh = _receiveMessageHeader();
+    if (mh.type == MESSAGE_TYPE_PIXELSTREAM)
+    {
+        _receivePixelStreamMessage(mh);
+        return;
+    }
     const QByteArray messageByteArray = _receiveMessageBody(mh.size);
     _handleMessage(mh, messageByteArray);
 }
@@ -189,15 +267,37 @@ QByteArray ServerWorker::_receiveMessageBody(const int size)
     return messageByteArray;
 }
 
-void ServerWorker::_handleMessage(const MessageHeader& messageHeader,
-                                  const QByteArray& byteArray)
+bool ServerWorker::_receiveMessageBody(char* data, const int size)
+{
+    int received = 0;
+    while (received < size)
+    {
+        const qint64 count = _tcpSocket->read(data + received, size - received);
+        if (count < 0)
+        {
+            emit connectionClosed();
+            return false;
+        }
+        received += count;
+
+        if (received < size &&
+            !_tcpSocket->waitForReadyRead(RECEIVE_TIMEOUT_MS))
+        {
+            emit connectionClosed();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ServerWorker::_isValidMessage(const MessageHeader& messageHeader)
 {
     const QString uri(messageHeader.uri);
     if (uri.isEmpty())
     {
         std::cerr << "Warning: rejecting streamer with empty id" << std::endl;
         closeConnection(_streamId);
-        return;
+        return false;
     }
     if (uri != _streamId &&
         messageHeader.type != MESSAGE_TYPE_PIXELSTREAM_OPEN &&
@@ -206,12 +306,37 @@ void ServerWorker::_handleMessage(const MessageHeader& messageHeader,
         std::cerr << "Warning: ignoring message with incorrect stream id: '"
                   << messageHeader.uri << "', expected: '"
                   << _streamId.toStdString() << "'" << std::endl;
-        return;
+        return false;
     }
+    return true;
+}
+
+void ServerWorker::_handleMessage(const MessageHeader& messageHeader,
+                                  const QByteArray& byteArray)
+{
+    if (!_isValidMessage(messageHeader))
+        return;
 
+    const QString uri(messageHeader.uri);
     switch (messageHeader.type)
     {
     case MESSAGE_TYPE_QUIT:
+        // Dispatch the frames which the client finished before quitting
+        for (auto& frame : _decodingFrames)
+        {
+            for (auto& future : frame.segments)
+                future.waitForFinished();
+        }
+        _processDecodedSegments();
+        _decodingFrames.clear();
+        _clearFrame();
+        _retainedSegments.clear();
+        _frameReceived = 0;
+        _cursor = Cursor();
+        if (_subscribedToFrames)
+            emit unsubscribeFromFrames(_streamId);
+        _subscribedToFrames = false;
+        _pendingFrame.reset();
         if (_observer)
             emit removeObserver(_streamId);
         else
@@ -234,16 +359,47 @@ void ServerWorker::_handleMessage(const MessageHeader& messageHeader,
 
     case MESSAGE_TYPE_OBSERVER_OPEN:
         _streamId = uri;
+        if (!byteArray.isEmpty())
+            _parseClientProtocolVersion(byteArray);
         emit addObserver(_streamId);
         _observer = true;
         break;
 
+    case MESSAGE_TYPE_SUBSCRIBE_FRAMES:
+        if (!_observer)
+        {
+            std::cerr << "Warning: only observers can subscribe to frames"
+                      << std::endl;
+            return;
+        }
+        if (!_subscribedToFrames)
+        {
+            _subscribedToFrames = true;
+            emit subscribeToFrames(_streamId);
+        }
+        break;
+
     case MESSAGE_TYPE_PIXELSTREAM_FINISH_FRAME:
-        emit receivedFrameFinished(_streamId, _sourceId);
+    {
+        auto finish = _parseFrameFinish(byteArray);
+        finish.timestamps.received = _frameReceived;
+        _frameReceived = 0;
+        if (_decodingFrames.empty())
+        {
+            _finishFrame(finish);
+            break;
+        }
+        // Dispatched once all its segments and the previous frames are decoded
+        if (_decodingFrames.back().finished)
+            _decodingFrames.emplace_back();
+        _decodingFrames.back().finished = true;
+        _decodingFrames.back().finish = finish;
+        _processDecodedSegments();
         break;
+    }
 
-    case MESSAGE_TYPE_PIXELSTREAM:
-        _handlePixelStreamMessage(byteArray);
+    case MESSAGE_TYPE_CLOCK_SYNC:
+        _sendClockSync(byteArray);
         break;
 
     case MESSAGE_TYPE_SIZE_HINTS:
@@ -258,6 +414,14 @@ void ServerWorker::_handleMessage(const MessageHeader& messageHeader,
         emit receivedData(_streamId, byteArray);
         break;
 
+    case MESSAGE_TYPE_CURSOR_SHAPE:
+        _parseCursorShape(byteArray);
+        break;
+
+    case MESSAGE_TYPE_CURSOR_POSITION:
+        _parseCursorPosition(byteArray);
+        break;
+
     case MESSAGE_TYPE_IMAGE_VIEW:
     {
         const auto view = reinterpret_cast<const View*>(byteArray.data());
@@ -294,6 +458,38 @@ void ServerWorker::_handleMessage(const MessageHeader& messageHeader,
     }
 }
 
+void ServerWorker::_parseCursorShape(const QByteArray& message)
+{
+    if (message.size() < int(sizeof(CursorShapeMessage)))
+        return;
+
+    const auto shape =
+        reinterpret_cast<const CursorShapeMessage*>(message.data());
+    const auto imageSize = size_t(shape->width) * shape->height * 4;
+    if (size_t(message.size()) != sizeof(CursorShapeMessage) + imageSize)
+    {
+        std::cerr << "Ignoring cursor shape with invalid size" << std::endl;
+        return;
+    }
+
+    _cursor.image = message.mid(sizeof(CursorShapeMessage));
+    _cursor.size = QSize(shape->width, shape->height);
+    _cursor.hotspot = QPoint(shape->hotspotX, shape->hotspotY);
+    emit receivedCursor(_streamId, _cursor);
+}
+
+void ServerWorker::_parseCursorPosition(const QByteArray& message)
+{
+    if (message.size() < int(sizeof(CursorPositionMessage)))
+        return;
+
+    const auto position =
+        reinterpret_cast<const CursorPositionMessage*>(message.data());
+    _cursor.position = QPoint(position->x, position->y);
+    _cursor.visible = position->visible != 0;
+    emit receivedCursor(_streamId, _cursor);
+}
+
 void ServerWorker::_parseClientProtocolVersion(const QByteArray& message)
 {
     bool ok = false;
@@ -302,16 +498,204 @@ void ServerWorker::_parseClientProtocolVersion(const QByteArray& message)
         _clientProtocolVersion = version;
 }
 
-void ServerWorker::_handlePixelStreamMessage(const QByteArray& message)
+void ServerWorker::_receivePixelStreamMessage(const MessageHeader& header)
 {
+    if (_frameReceived == 0)
+        _frameReceived = currentTimestamp();
+
+    const int paramsSize = sizeof(SegmentParameters);
+    if (header.size < paramsSize)
+    {
+        _receiveMessageBody(header.size);
+        std::cerr << "Warning: ignoring truncated segment" << std::endl;
+        return;
+    }
+
+    // Receive the image data directly into a recycled buffer
     Segment segment;
+    auto params = reinterpret_cast<char*>(&segment.parameters);
+    if (!_receiveMessageBody(params, paramsSize))
+        return;
+    const int dataSize = header.size - paramsSize;
+    segment.imageData = _framePool->takeBuffer(dataSize);
+    if (!_receiveMessageBody(segment.imageData.data(), dataSize))
+        return;
 
-    const auto data = message.data();
-    segment.parameters = *reinterpret_cast<const SegmentParameters*>(data);
-    segment.imageData =
-        message.right(message.size() - sizeof(SegmentParameters));
+    if (!_isValidMessage(header))
+        return;
     segment.view = _activeView;
-    emit(receivedSegment(_streamId, _sourceId, segment));
+
+    if (_segmentDecoding != SegmentDecoding::none)
+        _startDecoding(std::move(segment));
+    else
+        _addFrameSegment(std::move(segment));
+}
+
+ServerWorker::FrameFinish ServerWorker::_parseFrameFinish(
+    const QByteArray& message) const
+{
+    // The frame id and timestamps are only sent by clients since v. 1.8
+    FrameFinish finish;
+    const auto data =
+        reinterpret_cast<const FinishFrameMessage*>(message.data());
+    if (message.size() >= int(offsetof(FinishFrameMessage, update)))
+    {
+        finish.id = data->frameId;
+        finish.timestamps.captured = data->captured;
+        finish.timestamps.sent = data->sent;
+    }
+    if (message.size() >= int(sizeof(FinishFrameMessage)) &&
+        data->update <= as_underlying_type(FrameUpdate::partial))
+    {
+        finish.update = FrameUpdate(data->update);
+    }
+    return finish;
+}
+
+void ServerWorker::_startDecoding(Segment&& segment)
+{
+#ifdef DEFLECT_USE_LIBJPEGTURBO
+    if (_decodingFrames.empty() || _decodingFrames.back().finished)
+        _decodingFrames.emplace_back();
+
+    // Decode while the remaining segments of the frame are received; the
+    // worker keeps reading messages and collects the results when notified
+    auto future = QtConcurrent::run(_decodeSegment, std::move(segment),
+                                    _segmentDecoding);
+    auto watcher = new QFutureWatcher<Segment>(this);
+    connect(watcher, &QFutureWatcher<Segment>::finished, this,
+            &ServerWorker::_processDecodedSegments);
+    connect(watcher, &QFutureWatcher<Segment>::finished, watcher,
+            &QObject::deleteLater);
+    watcher->setFuture(future);
+    _decodingFrames.back().segments.enqueue(future);
+#else
+    _addFrameSegment(std::move(segment));
+#endif
+}
+
+void ServerWorker::_processDecodedSegments()
+{
+    // Segments are collected in order, so that each frame is only finished
+    // after all of its own segments
+    while (!_decodingFrames.empty())
+    {
+        auto& frame = _decodingFrames.front();
+        while (!frame.segments.isEmpty() && frame.segments.head().isFinished())
+        {
+            Segment segment = frame.segments.dequeue().result();
+            if (segment.exception)
+            {
+                try
+                {
+                    std::rethrow_exception(segment.exception);
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << "Segment decoding failed, closing stream: "
+                              << e.what() << std::endl;
+                }
+                _decodingFrames.clear();
+                _clearFrame();
+                closeConnection(_streamId);
+                return;
+            }
+            _addFrameSegment(std::move(segment));
+        }
+        if (!frame.finished || !frame.segments.isEmpty())
+            return;
+
+        const auto finish = frame.finish;
+        _decodingFrames.pop_front();
+        _finishFrame(finish);
+    }
+}
+
+void ServerWorker::_addFrameSegment(Segment&& segment)
+{
+    _frameBytes += segment.imageData.size();
+    _frameSegments.push_back(std::move(segment));
+
+    // Hand over large frames in parts, so that their memory counts towards
+    // the limits of the stream buffer before they are finished
+    if (_frameBytes >= MAX_HELD_FRAME_BYTES)
+    {
+        _flushedSegments.insert(_flushedSegments.end(), _frameSegments.begin(),
+                                _frameSegments.end());
+        _emitFrameSegments();
+    }
+}
+
+void ServerWorker::_finishFrame(const FrameFinish& finish)
+{
+    _applyFrameUpdate(finish.update);
+    _emitFrameSegments();
+    _flushedSegments.clear();
+
+    emit receivedFrameFinished(_streamId, _sourceId, finish.id,
+                               finish.timestamps);
+}
+
+void ServerWorker::_applyFrameUpdate(const FrameUpdate update)
+{
+    switch (update)
+    {
+    case FrameUpdate::partial:
+        // Complete the frame with the retained segments of unchanged regions
+        for (const auto& segment : _retainedSegments)
+        {
+            if (!_overlapsFrameSegments(segment))
+                _frameSegments.push_back(segment);
+        }
+    // fall through
+    case FrameUpdate::keyframe:
+        // Retained copies share their image data with the emitted segments
+        _retainedSegments = _flushedSegments;
+        _retainedSegments.insert(_retainedSegments.end(),
+                                 _frameSegments.begin(), _frameSegments.end());
+        break;
+    case FrameUpdate::full:
+    default:
+        _retainedSegments.clear();
+        break;
+    }
+}
+
+bool ServerWorker::_overlapsFrameSegments(const Segment& segment) const
+{
+    const auto overlaps = [&segment](const Segment& frameSegment) {
+        const auto& a = segment.parameters;
+        const auto& b = frameSegment.parameters;
+        return segment.view == frameSegment.view && a.x < b.x + b.width &&
+               b.x < a.x + a.width && a.y < b.y + b.height &&
+               b.y < a.y + a.height;
+    };
+    return std::any_of(_frameSegments.begin(), _frameSegments.end(),
+                       overlaps) ||
+           std::any_of(_flushedSegments.begin(), _flushedSegments.end(),
+                       overlaps);
+}
+
+void ServerWorker::_emitFrameSegments()
+{
+    if (_frameSegments.empty())
+        return;
+
+    // The held segments are handed over in a single queued signal, which
+    // only copies a pointer instead of each segment
+    const auto count = _frameSegments.size();
+    auto segments = std::make_shared<Segments>(std::move(_frameSegments));
+    _frameSegments = Segments();
+    _frameSegments.reserve(count);
+    _frameBytes = 0;
+    emit receivedSegments(_streamId, _sourceId, std::move(segments));
+}
+
+void ServerWorker::_clearFrame()
+{
+    _frameSegments.clear();
+    _flushedSegments.clear();
+    _frameBytes = 0;
 }
 
 void ServerWorker::_sendProtocolVersion()
@@ -330,6 +714,20 @@ void ServerWorker::_sendBindReply(const bool successful)
     _flushSocket();
 }
 
+void ServerWorker::_sendClockSync(const QByteArray& message)
+{
+    if (message.size() < int(sizeof(ClockSyncMessage)))
+        return;
+
+    ClockSyncMessage sync =
+        *reinterpret_cast<const ClockSyncMessage*>(message.data());
+    sync.serverTime = currentTimestamp();
+
+    _send(MessageHeader(MESSAGE_TYPE_CLOCK_SYNC, sizeof(ClockSyncMessage)));
+    _tcpSocket->write((const char*)&sync, sizeof(ClockSyncMessage));
+    _flushSocket();
+}
+
 void ServerWorker::_send(const Event& evt)
 {
     // send message header
@@ -343,6 +741,48 @@ void ServerWorker::_send(const Event& evt)
     _flushSocket();
 }
 
+void ServerWorker::_sendPendingFrame()
+{
+    // Wait until the previous frame is written to send the latest one
+    if (!_pendingFrame || _tcpSocket->bytesToWrite() > 0 || !_isConnected())
+        return;
+
+    const FramePtr frame = _pendingFrame;
+    _pendingFrame.reset();
+
+    // The segments are forwarded as they were received, using the same
+    // messages as a stream sending them to the server
+    const auto uri = _streamId.toStdString();
+    View view = View::mono;
+    for (const auto& segment : frame->segments)
+    {
+        if (segment.view != view)
+        {
+            view = segment.view;
+            _send(MessageHeader(MESSAGE_TYPE_IMAGE_VIEW, sizeof(View), uri));
+            _tcpSocket->write((const char*)(&view), sizeof(View));
+        }
+        _sendSegment(segment);
+    }
+    // The timestamps are relative to this server's clock, only forward the id
+    const FinishFrameMessage finish{frame->id, 0, 0,
+                                    as_underlying_type(FrameUpdate::full)};
+    _send(MessageHeader(MESSAGE_TYPE_PIXELSTREAM_FINISH_FRAME, sizeof(finish),
+                        uri));
+    _tcpSocket->write((const char*)(&finish), sizeof(finish));
+    _tcpSocket->flush();
+}
+
+void ServerWorker::_sendSegment(const Segment& segment)
+{
+    const auto size = sizeof(SegmentParameters) + segment.imageData.size();
+    _send(MessageHeader(MESSAGE_TYPE_PIXELSTREAM, size,
+                        _streamId.toStdString()));
+    _tcpSocket->write((const char*)(&segment.parameters),
+                      sizeof(SegmentParameters));
+    _tcpSocket->write(segment.imageData);
+}
+
 void ServerWorker::_sendQuit()
 {
     MessageHeader mh(MESSAGE_TYPE_QUIT, 0);
@@ -43,14 +43,18 @@
 
 #include <deflect/Event.h>
 #include <deflect/EventReceiver.h>
+#include <deflect/Frame.h>
 #include <deflect/MessageHeader.h>
 #include <deflect/Segment.h>
 #include <deflect/SizeHints.h>
 #include <deflect/types.h>
 
+#include <QFuture>
 #include <QQueue>
 #include <QtNetwork/QTcpSocket>
 
+#include <deque>
+
 namespace deflect
 {
 class ServerWorker : public EventReceiver
@@ -58,11 +62,15 @@ class ServerWorker : public EventReceiver
     Q_OBJECT
 
 public:
-    explicit ServerWorker(int socketDescriptor);
+    ServerWorker(int socketDescriptor,
+                 SegmentDecoding decoding = SegmentDecoding::none,
+                 std::shared_ptr<FramePool> framePool = nullptr);
     ~ServerWorker();
 
 public slots:
     void processEvent(Event evt) final;
+    void sendFrame(deflect::FramePtr frame);
+    void notifyViewVisibility(QString uri, bool visible);
 
     void initConnection();
     void closeConnection(QString uri);
@@ -74,9 +82,14 @@ signals:
     void addObserver(QString uri);
     void removeObserver(QString uri);
 
-    void receivedSegment(QString uri, size_t sourceIndex,
-                         deflect::Segment segment);
-    void receivedFrameFinished(QString uri, size_t sourceIndex);
+    void subscribeToFrames(QString uri);
+    void unsubscribeFromFrames(QString uri);
+
+    void receivedSegments(QString uri, size_t sourceIndex,
+                          deflect::SegmentsPtr segments);
+    void receivedFrameFinished(QString uri, size_t sourceIndex,
+                               quint64 frameId,
+                               deflect::FrameTimestamps timestamps);
 
     void registerToEvents(QString uri, bool exclusive,
                           deflect::EventReceiver* receiver,
@@ -86,6 +99,8 @@ signals:
 
     void receivedData(QString uri, QByteArray data);
 
+    void receivedCursor(QString uri, deflect::Cursor cursor);
+
     void connectionClosed();
 
     /** @internal */
@@ -93,6 +108,8 @@ signals:
 
 private slots:
     void _processMessages();
+    void _sendPendingFrame();
+    void _processDecodedSegments();
 
 private:
     QTcpSocket* _tcpSocket;
@@ -101,25 +118,67 @@ private:
     int _sourceId;
     int _clientProtocolVersion;
     bool _observer{false};
+    bool _subscribedToFrames{false};
+    FramePtr _pendingFrame;
 
     bool _registeredToEvents;
     QQueue<Event> _events;
 
     View _activeView;
 
+    /** The end of a frame, as notified by the client. */
+    struct FrameFinish
+    {
+        quint64 id = 0;
+        FrameTimestamps timestamps;
+        FrameUpdate update = FrameUpdate::full;
+    };
+
+    /** A frame whose segments are decoded while the next ones are received */
+    struct DecodingFrame
+    {
+        QQueue<QFuture<Segment>> segments;
+        bool finished = false;
+        FrameFinish finish;
+    };
+
+    SegmentDecoding _segmentDecoding;
+    std::deque<DecodingFrame> _decodingFrames;
+    std::shared_ptr<FramePool> _framePool;
+    Segments _frameSegments;
+    size_t _frameBytes = 0;
+    int64_t _frameReceived = 0;
+    Segments _flushedSegments;
+    Segments _retainedSegments;
+    Cursor _cursor;
+
     void _receiveMessage();
     MessageHeader _receiveMessageHeader();
     QByteArray _receiveMessageBody(int size);
+    bool _receiveMessageBody(char* data, int size);
 
+    bool _isValidMessage(const MessageHeader& messageHeader);
     void _handleMessage(const MessageHeader& messageHeader,
                         const QByteArray& message);
     void _parseClientProtocolVersion(const QByteArray& message);
-    void _handlePixelStreamMessage(const QByteArray& message);
+    void _receivePixelStreamMessage(const MessageHeader& header);
+    FrameFinish _parseFrameFinish(const QByteArray& message) const;
+    void _startDecoding(Segment&& segment);
+    void _addFrameSegment(Segment&& segment);
+    void _finishFrame(const FrameFinish& finish);
+    void _clearFrame();
+    void _applyFrameUpdate(FrameUpdate update);
+    bool _overlapsFrameSegments(const Segment& segment) const;
+    void _emitFrameSegments();
+    void _parseCursorShape(const QByteArray& message);
+    void _parseCursorPosition(const QByteArray& message);
 
     void _sendProtocolVersion();
     void _sendBindReply(bool successful);
+    void _sendClockSync(const QByteArray& message);
     void _send(const Event& evt);
     void _sendQuit();
+    void _sendSegment(const Segment& segment);
     bool _send(const MessageHeader& messageHeader);
     void _flushSocket();
     bool _isConnected() const;
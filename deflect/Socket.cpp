@@ -42,6 +42,7 @@
 
 #include "MessageHeader.h"
 #include "NetworkProtocol.h"
+#include "SegmentParameters.h"
 
 #include <QCoreApplication>
 #include <QDataStream>
@@ -102,8 +103,17 @@ bool Socket::hasMessage(const size_t messageSize) const
 
     // needed to 'wakeup' socket when no data was streamed for a while
     _socket->waitForReadyRead(0);
-    return _socket->bytesAvailable() >=
-           (int)(MessageHeader::serializedSize + messageSize);
+    const auto available = _socket->bytesAvailable();
+    if (available < qint64(MessageHeader::serializedSize + messageSize))
+        return false;
+
+    // Only a complete message can be received without blocking
+    const auto headerData = _socket->peek(MessageHeader::serializedSize);
+    QDataStream stream(headerData);
+    MessageHeader header;
+    stream >> header;
+    return stream.status() == QDataStream::Ok &&
+           available >= qint64(MessageHeader::serializedSize + header.size);
 }
 
 bool Socket::send(const MessageHeader& messageHeader, const QByteArray& message,
@@ -120,15 +130,32 @@ bool Socket::send(const MessageHeader& messageHeader, const QByteArray& message,
         return false;
 
     // send message
-    const bool allSent = _write(message);
+    const bool allSent = _write(message.constData(), message.size());
 
     if (waitForBytesWritten)
-    {
-        // Needed in the absence of event loop, otherwise the reception is
-        // frozen.
-        while (_socket->bytesToWrite() > 0 && isConnected())
-            _socket->waitForBytesWritten();
-    }
+        _waitForBytesWritten();
+    return allSent;
+}
+
+bool Socket::send(const MessageHeader& messageHeader,
+                  const SegmentParameters& parameters,
+                  const QByteArray& imageData, const bool waitForBytesWritten)
+{
+    QMutexLocker locker(&_socketMutex);
+    if (!isConnected())
+        return false;
+
+    QDataStream stream(_socket);
+    stream << messageHeader;
+    if (stream.status() != QDataStream::Ok)
+        return false;
+
+    const bool allSent =
+        _write((const char*)(&parameters), sizeof(SegmentParameters)) &&
+        _write(imageData.constData(), imageData.size());
+
+    if (waitForBytesWritten)
+        _waitForBytesWritten();
     return allSent;
 }
 
@@ -192,12 +219,12 @@ void Socket::_connect(const std::string& host, const unsigned short port)
         throw std::runtime_error("server protocol version was not received");
     }
 
-    if (_serverProtocolVersion < NETWORK_PROTOCOL_VERSION)
+    if (_serverProtocolVersion < MIN_NETWORK_PROTOCOL_VERSION)
     {
         _socket->disconnectFromHost();
         std::stringstream ss;
         ss << "server uses unsupported protocol: " << _serverProtocolVersion
-           << " < " << NETWORK_PROTOCOL_VERSION;
+           << " < " << MIN_NETWORK_PROTOCOL_VERSION;
         throw std::runtime_error(ss.str());
     }
 }
@@ -213,15 +240,12 @@ bool Socket::_receiveProtocolVersion()
     return true;
 }
 
-bool Socket::_write(const QByteArray& message)
+bool Socket::_write(const char* data, const int size)
 {
     bool allSent = true;
-    if (!message.isEmpty())
+    if (size > 0)
     {
         // Send message data
-        const char* data = message.constData();
-        const int size = message.size();
-
         int sent = _socket->write(data, size);
 
         while (sent < size && isConnected())
@@ -231,4 +255,11 @@ bool Socket::_write(const QByteArray& message)
     }
     return allSent;
 }
+
+void Socket::_waitForBytesWritten()
+{
+    // Needed in the absence of event loop, otherwise the reception is frozen.
+    while (_socket->bytesToWrite() > 0 && isConnected())
+        _socket->waitForBytesWritten();
+}
 }
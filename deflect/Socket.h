@@ -93,7 +93,8 @@ public:
     int getFileDescriptor() const;
 
     /**
-     * Is there a pending message
+     * Is there a complete pending message, which can be received without
+     * blocking.
      * @param messageSize Minimum size of the message
      */
     bool hasMessage(const size_t messageSize = 0) const;
@@ -110,6 +111,18 @@ public:
     bool send(const MessageHeader& messageHeader, const QByteArray& message,
               bool waitForBytesWritten);
 
+    /**
+     * Send a segment message without concatenating its parts in a new buffer.
+     * @param messageHeader The message header
+     * @param parameters The parameters of the segment, sent first
+     * @param imageData The image data of the segment, sent after parameters
+     * @param waitForBytesWritten @see send()
+     * @return true if the message could be sent, false otherwise
+     */
+    bool send(const MessageHeader& messageHeader,
+              const SegmentParameters& parameters, const QByteArray& imageData,
+              bool waitForBytesWritten);
+
     /**
      * Receive a message.
      * @param messageHeader The received message header
@@ -131,7 +144,8 @@ private:
     bool _receiveHeader(MessageHeader& messageHeader);
     void _connect(const std::string& host, const unsigned short port);
     bool _receiveProtocolVersion();
-    bool _write(const QByteArray& data);
+    bool _write(const char* data, int size);
+    void _waitForBytesWritten();
 };
 }
 
@@ -39,18 +39,19 @@
 
 #include "SourceBuffer.h"
 
-#include <exception>
+#include <algorithm>
 
 namespace deflect
 {
-SourceBuffer::SourceBuffer()
+SourceBuffer::SourceBuffer(const FrameIndex frameIndex)
+    : _frames(1)
+    , _backFrameIndex(frameIndex)
 {
-    _segments.push(Segments());
 }
 
 const Segments& SourceBuffer::getSegments() const
 {
-    return _segments.front();
+    return _frames[_front];
 }
 
 FrameIndex SourceBuffer::getBackFrameIndex() const
@@ -60,27 +61,64 @@ FrameIndex SourceBuffer::getBackFrameIndex() const
 
 bool SourceBuffer::isBackFrameEmpty() const
 {
-    return _segments.back().empty();
+    return _back().empty();
 }
 
-void SourceBuffer::pop()
+void SourceBuffer::pop(Segments& segments)
 {
-    _segments.pop();
+    auto& front = _frames[_front];
+    for (auto& segment : front)
+    {
+        _bufferedBytes -= segment.imageData.size();
+        segments.push_back(std::move(segment));
+    }
+    front.clear();
+    _front = (_front + 1) % _frames.size();
+    --_size;
 }
 
 void SourceBuffer::push()
 {
-    _segments.push(Segments());
+    if (_size == _frames.size())
+    {
+        // Grow the ring, keeping the existing containers and their capacity
+        std::rotate(_frames.begin(), _frames.begin() + _front, _frames.end());
+        _frames.emplace_back();
+        _front = 0;
+    }
+    ++_size;
     ++_backFrameIndex;
 }
 
 void SourceBuffer::insert(const Segment& segment)
 {
-    _segments.back().push_back(segment);
+    _back().push_back(segment);
+    _bufferedBytes += segment.imageData.size();
+}
+
+void SourceBuffer::insert(Segment&& segment)
+{
+    _bufferedBytes += segment.imageData.size();
+    _back().push_back(std::move(segment));
 }
 
 size_t SourceBuffer::getQueueSize() const
 {
-    return _segments.size();
+    return _size;
+}
+
+size_t SourceBuffer::getBufferedBytes() const
+{
+    return _bufferedBytes;
+}
+
+Segments& SourceBuffer::_back()
+{
+    return _frames[(_front + _size - 1) % _frames.size()];
+}
+
+const Segments& SourceBuffer::_back() const
+{
+    return _frames[(_front + _size - 1) % _frames.size()];
 }
 }
@@ -44,8 +44,7 @@
 #include <deflect/api.h>
 #include <deflect/types.h>
 
-#include <array>
-#include <queue>
+#include <vector>
 
 namespace deflect
 {
@@ -57,8 +56,12 @@ using FrameIndex = unsigned int;
 class SourceBuffer
 {
 public:
-    /** Construct an empty buffer. */
-    SourceBuffer();
+    /**
+     * Construct an empty buffer.
+     * @param frameIndex the index of the last frame before the first one to be
+     *        received.
+     */
+    explicit SourceBuffer(FrameIndex frameIndex = 0);
 
     /** @return the segments at the front of the queue. */
     const Segments& getSegments() const;
@@ -72,21 +75,46 @@ public:
     /** Insert a segment into the back frame. */
     void insert(const Segment& segment);
 
+    /** Move a segment into the back frame. */
+    void insert(Segment&& segment);
+
     /** Push a new frame to the back. */
     void push();
 
-    /** Pop the front frame. */
-    void pop();
+    /**
+     * Pop the front frame.
+     * @param segments the container to which the frame's segments are moved
+     */
+    void pop(Segments& segments);
 
     /** @return the size of the queue. */
     size_t getQueueSize() const;
 
+    /** @return the number of image data bytes of all the queued segments. */
+    size_t getBufferedBytes() const;
+
 private:
-    /** The collections of segments for each mono/left/right view. */
-    std::queue<Segments> _segments;
+    /**
+     * Ring of frames, from _front to the back frame. Popped containers are
+     * cleared but kept, so that pushing a frame does not allocate once the
+     * ring has reached the maximum queue size of the source.
+     */
+    std::vector<Segments> _frames;
+
+    /** The position of the front frame in the ring. */
+    size_t _front = 0u;
+
+    /** The number of frames in the queue. */
+    size_t _size = 1u;
 
     /** The current indices of the mono/left/right frame for this source. */
     FrameIndex _backFrameIndex = 0u;
+
+    /** The total size of the image data in the queue. */
+    size_t _bufferedBytes = 0u;
+
+    Segments& _back();
+    const Segments& _back() const;
 };
 }
 
@@ -42,6 +42,8 @@
 #include "Stream.h"
 #include "StreamPrivate.h"
 
+#include <stdexcept>
+
 namespace deflect
 {
 Stream::Stream(const unsigned short port)
@@ -64,13 +66,53 @@ Stream::Future Stream::send(const ImageWrapper& image)
     return _impl->sendWorker.enqueueImage(image, false);
 }
 
+Stream::Future Stream::send(Segments segments)
+{
+    return _impl->sendWorker.enqueueSegments(std::move(segments));
+}
+
 Stream::Future Stream::finishFrame()
 {
+    _impl->updateClockOffset();
     return _impl->sendWorker.enqueueFinish();
 }
 
+Stream::Future Stream::finishFrame(const FrameUpdate update)
+{
+    // Older servers complete each frame with its own segments only
+    if (update == FrameUpdate::partial && !supportsFrameUpdates())
+    {
+        return make_exception_future<bool>(
+            std::runtime_error("Partial frames not supported by the server"));
+    }
+    _impl->updateClockOffset();
+    return _impl->sendWorker.enqueueFinish(update);
+}
+
 Stream::Future Stream::sendAndFinish(const ImageWrapper& image)
 {
+    _impl->updateClockOffset();
     return _impl->sendWorker.enqueueImage(image, true);
 }
+
+Stream::Future Stream::sendCursorShape(const ImageWrapper& image,
+                                       const int hotspotX, const int hotspotY)
+{
+    if (!supportsFrameUpdates())
+        return make_ready_future(false);
+    return _impl->sendWorker.enqueueCursorShape(image, hotspotX, hotspotY);
+}
+
+Stream::Future Stream::sendCursorPosition(const int x, const int y,
+                                          const bool visible)
+{
+    if (!supportsFrameUpdates())
+        return make_ready_future(false);
+    return _impl->sendWorker.enqueueCursorPosition(x, y, visible);
+}
+
+bool Stream::supportsFrameUpdates() const
+{
+    return _impl->supportsFrameUpdates();
+}
 }
@@ -44,6 +44,7 @@
 
 #include <deflect/ImageWrapper.h>
 #include <deflect/Observer.h>
+#include <deflect/Segment.h>
 #include <deflect/api.h>
 #include <deflect/types.h>
 
@@ -123,6 +124,21 @@ public:
      */
     DEFLECT_API Future send(const ImageWrapper& image);
 
+    /**
+     * Send already encoded segments asynchronously.
+     *
+     * The segments are sent unchanged, which allows forwarding the segments of
+     * a Frame received by a Server without compressing them again.
+     *
+     * @param segments The segments to send, with their image data in the
+     *        format given by their parameters.
+     * @return true if the segments could be sent, false otherwise
+     * @throw std::runtime_error if pending finishFrame() has not been completed
+     * @version 1.8
+     * @sa finishFrame()
+     */
+    DEFLECT_API Future send(Segments segments);
+
     /**
      * Asynchronously notify that all the images for this frame have been sent.
      *
@@ -137,6 +153,25 @@ public:
      */
     DEFLECT_API Future finishFrame();
 
+    /**
+     * Asynchronously finish a frame which may only update parts of the image.
+     *
+     * With FrameUpdate::partial, only the images of the regions which changed
+     * since the previous frame need to be sent: the receiver completes the
+     * frame with the retained segments of the previous keyframe or partial
+     * frame that do not overlap with the new ones. The images must thus be
+     * aligned on the segments of the keyframe, for instance by sending
+     * sub-images of 512x512 pixels at multiples of 512.
+     *
+     * @param update the relation of this frame to the previous ones.
+     * @return true if the frame could be finished, false otherwise.
+     * @throw std::runtime_error if partial and the server does not support
+     *        frame updates, see supportsFrameUpdates().
+     * @sa finishFrame()
+     * @version 1.8
+     */
+    DEFLECT_API Future finishFrame(FrameUpdate update);
+
     /**
      * Send an image and finish the frame asynchronously.
      *
@@ -158,6 +193,48 @@ public:
 
     /** @deprecated */
     Future asyncSend(const ImageWrapper& image) { return sendAndFinish(image); }
+
+    /**
+     * Send the shape of the mouse cursor asynchronously.
+     *
+     * The receiver draws the cursor over the frames at the position given by
+     * sendCursorPosition(), so that moving it does not require sending new
+     * images.
+     *
+     * @param image The image of the cursor, which is copied.
+     * @param hotspotX The horizontal position of the pointer in the image.
+     * @param hotspotY The vertical position of the pointer in the image.
+     * @return true if the shape could be sent, false otherwise or if the
+     *         server does not support cursors, see supportsFrameUpdates().
+     * @throw std::invalid_argument if not RGBA, top-down and uncompressed
+     * @version 1.8
+     */
+    DEFLECT_API Future sendCursorShape(const ImageWrapper& image, int hotspotX,
+                                       int hotspotY);
+
+    /**
+     * Send the position of the mouse cursor asynchronously.
+     *
+     * @param x The horizontal position of the pointer in the stream.
+     * @param y The vertical position of the pointer in the stream.
+     * @param visible false to hide the cursor.
+     * @return true if the position could be sent, false otherwise
+     * @version 1.8
+     */
+    DEFLECT_API Future sendCursorPosition(int x, int y, bool visible = true);
+
+    /**
+     * Check if the server supports the frame updates of finishFrame() and the
+     * cursors.
+     *
+     * Servers using an older network protocol complete each frame with its
+     * own segments only and do not draw cursors. They also do not receive the
+     * timestamps of the frames.
+     *
+     * @return true if the server supports frame updates and cursors.
+     * @version 1.8
+     */
+    DEFLECT_API bool supportsFrameUpdates() const;
     //@}
 
 private:
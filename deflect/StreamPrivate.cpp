@@ -41,8 +41,14 @@
 
 #include "StreamPrivate.h"
 
+#include "Frame.h"
+#include "NetworkProtocol.h"
+#include "Segment.h"
+
+#include <QDataStream>
 #include <QHostInfo>
 
+#include <iostream>
 #include <stdexcept>
 
 namespace
@@ -96,7 +102,16 @@ StreamPrivate::StreamPrivate(const std::string& id_, const std::string& host,
     if (observer)
         sendWorker.enqueueObserverOpen().wait();
     else
+    {
         sendWorker.enqueueOpen().wait();
+        // The reply is processed with the other incoming messages, frames
+        // are sent without timestamps until then
+        if (supportsFrameUpdates())
+        {
+            sendWorker.enqueueClockSync();
+            _clockSyncPending = true;
+        }
+    }
 }
 
 StreamPrivate::~StreamPrivate()
@@ -104,4 +119,96 @@ StreamPrivate::~StreamPrivate()
     if (socket.isConnected())
         sendWorker.enqueueClose().wait();
 }
+
+bool StreamPrivate::receiveMessage()
+{
+    MessageHeader mh;
+    QByteArray message;
+    if (!socket.receive(mh, message))
+        return false;
+
+    switch (mh.type)
+    {
+    case MESSAGE_TYPE_EVENT:
+    {
+        Event event;
+        QDataStream stream(message);
+        stream >> event;
+        events.push(event);
+        break;
+    }
+    case MESSAGE_TYPE_BIND_EVENTS_REPLY:
+        registeredForEvents = *(bool*)(message.data());
+        bindReplyReceived = true;
+        break;
+    case MESSAGE_TYPE_IMAGE_VIEW:
+        _incomingView = *reinterpret_cast<const View*>(message.constData());
+        break;
+    case MESSAGE_TYPE_PIXELSTREAM:
+    {
+        Segment segment;
+        segment.parameters =
+            *reinterpret_cast<const SegmentParameters*>(message.constData());
+        segment.imageData =
+            message.right(message.size() - sizeof(SegmentParameters));
+        segment.view = _incomingView;
+        _incomingSegments.push_back(std::move(segment));
+        break;
+    }
+    case MESSAGE_TYPE_PIXELSTREAM_FINISH_FRAME:
+        // Only the latest frame is kept, older ones are dropped
+        frame = std::make_shared<Frame>();
+        frame->uri = QString::fromStdString(id);
+        if (message.size() >= int(sizeof(FinishFrameMessage)))
+        {
+            frame->id = reinterpret_cast<const FinishFrameMessage*>(
+                            message.constData())
+                            ->frameId;
+        }
+        frame->segments = std::move(_incomingSegments);
+        _incomingSegments = Segments();
+        _incomingView = View::mono;
+        break;
+    case MESSAGE_TYPE_CLOCK_SYNC:
+    {
+        if (message.size() < int(sizeof(ClockSyncMessage)))
+            break;
+        const auto now = currentTimestamp();
+        const auto sync =
+            reinterpret_cast<const ClockSyncMessage*>(message.constData());
+        // Assuming symmetric network delays, the server time was taken in the
+        // middle of the round trip
+        sendWorker.setClockOffset(sync->serverTime -
+                                  (sync->clientTime + now) / 2);
+        _clockSyncPending = false;
+        break;
+    }
+    default:
+        std::cerr << "deflect::Stream: received unexpected message type ("
+                  << int(mh.type) << ")" << std::endl;
+        break;
+    }
+    return true;
+}
+
+bool StreamPrivate::receivePendingMessages()
+{
+    while (socket.hasMessage())
+    {
+        if (!receiveMessage())
+            return false;
+    }
+    return true;
+}
+
+void StreamPrivate::updateClockOffset()
+{
+    if (_clockSyncPending)
+        receivePendingMessages();
+}
+
+bool StreamPrivate::supportsFrameUpdates() const
+{
+    return socket.getServerProtocolVersion() >= FRAME_UPDATES_PROTOCOL_VERSION;
+}
 }
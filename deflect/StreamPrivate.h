@@ -42,10 +42,13 @@
 #ifndef DEFLECT_STREAMPRIVATE_H
 #define DEFLECT_STREAMPRIVATE_H
 
+#include "Event.h"            // member
+#include "Segment.h"          // member
 #include "Socket.h"           // member
 #include "StreamSendWorker.h" // member
 
 #include <functional>
+#include <queue>
 #include <string>
 
 namespace deflect
@@ -77,11 +80,48 @@ public:
     /** Has a successful event registration reply been received */
     bool registeredForEvents = false;
 
+    /** Has a reply to the last event registration request been received */
+    bool bindReplyReceived = false;
+
+    /** The events received and not yet retrieved. */
+    std::queue<Event> events;
+
+    /** The latest complete frame received and not yet retrieved. */
+    FramePtr frame;
+
+    /**
+     * Receive the next message from the Server, blocking until available.
+     *
+     * Events and frames are stored until they are retrieved.
+     * @return false if no message could be received
+     */
+    bool receiveMessage();
+
+    /**
+     * Receive all the messages already available, without blocking.
+     * @return false if a message could not be received
+     */
+    bool receivePendingMessages();
+
+    /**
+     * Process the reply to the clock synchronization request sent when the
+     * stream was opened, if it has arrived. Does not block.
+     */
+    void updateClockOffset();
+
+    /** @sa Stream::supportsFrameUpdates() */
+    bool supportsFrameUpdates() const;
+
     /** Optional callback when the socket is disconnected. */
     std::function<void()> disconnectedCallback;
 
     /** The worker doing all the socket send operations. */
     StreamSendWorker sendWorker;
+
+private:
+    Segments _incomingSegments;
+    View _incomingView = View::mono;
+    bool _clockSyncPending = false;
 };
 }
 #endif
@@ -40,6 +40,7 @@
 
 #include "StreamSendWorker.h"
 
+#include "Frame.h"
 #include "NetworkProtocol.h"
 #include "Segment.h"
 #include "SizeHints.h"
@@ -94,7 +95,7 @@ void StreamSendWorker::run()
                 count = 1;
                 _finishRequest.isFinish = false; // reset this to process this
                                                  // request now
-                _dequeuedRequests[0] = _finishRequest;
+                _dequeuedRequests[0] = std::move(_finishRequest);
                 _pendingFinish = false;
             }
         }
@@ -116,7 +117,7 @@ void StreamSendWorker::run()
                     continue;
                 }
 
-                _finishRequest = request;
+                _finishRequest = std::move(request);
                 _pendingFinish = true;
                 continue;
             }
@@ -190,7 +191,9 @@ Stream::Future StreamSendWorker::enqueueImage(const ImageWrapper& image,
         }
     }
 
+    const auto captured = currentTimestamp();
     std::vector<Task> tasks;
+    tasks.emplace_back([this, captured] { return _startFrame(captured); });
 
     if (image.width <= SMALL_IMAGE_SIZE && image.height <= SMALL_IMAGE_SIZE)
     {
@@ -198,13 +201,13 @@ Stream::Future StreamSendWorker::enqueueImage(const ImageWrapper& image,
         {
             auto segment = _imageSegmenter.createSingleSegment(image);
 
-            tasks.emplace_back(
-                [this, segment] { return _sendSegment(segment); });
+            tasks.emplace_back(std::bind(&StreamSendWorker::_sendSegment,
+                                         this, std::move(segment)));
 
             // as we expect to encounter a lot of these small sends, be
             // optimistic and fulfill the promise already to reduce load in the
             // send thread (c.f. lock ops performance on KNL)
-            _requests.enqueue({nullptr, tasks, false});
+            _requests.enqueue({nullptr, std::move(tasks), false});
             if (finish)
                 return enqueueFinish();
             return make_ready_future(true);
@@ -223,9 +226,26 @@ Stream::Future StreamSendWorker::enqueueImage(const ImageWrapper& image,
     return _enqueueRequest(std::move(tasks));
 }
 
-Stream::Future StreamSendWorker::enqueueFinish()
+Stream::Future StreamSendWorker::enqueueSegments(Segments&& segments)
 {
-    return _enqueueRequest({[this] { return _sendFinish(); }}, true);
+    if (_pendingFinish)
+    {
+        return make_exception_future<bool>(
+            std::runtime_error("Pending finish, no send allowed"));
+    }
+
+    const auto captured = currentTimestamp();
+    std::vector<Task> tasks;
+    tasks.emplace_back([this, captured] { return _startFrame(captured); });
+    tasks.emplace_back(std::bind(&StreamSendWorker::_sendSegments, this,
+                                 std::move(segments)));
+    return _enqueueRequest(std::move(tasks));
+}
+
+Stream::Future StreamSendWorker::enqueueFinish(const FrameUpdate update)
+{
+    return _enqueueRequest({[this, update] { return _sendFinish(update); }},
+                           true);
 }
 
 Stream::Future StreamSendWorker::enqueueOpen()
@@ -258,6 +278,12 @@ Stream::Future StreamSendWorker::enqueueBindRequest(const bool exclusive)
     }});
 }
 
+Stream::Future StreamSendWorker::enqueueFramesSubscription()
+{
+    return _enqueueRequest(
+        {[this] { return _send(MESSAGE_TYPE_SUBSCRIBE_FRAMES, {}); }});
+}
+
 Stream::Future StreamSendWorker::enqueueSizeHints(const SizeHints& hints)
 {
     return _enqueueRequest({[this, hints] {
@@ -272,14 +298,68 @@ Stream::Future StreamSendWorker::enqueueData(const QByteArray data)
         {[this, data] { return _send(MESSAGE_TYPE_DATA, data); }});
 }
 
+Stream::Future StreamSendWorker::enqueueCursorShape(const ImageWrapper& image,
+                                                    const int hotspotX,
+                                                    const int hotspotY)
+{
+    if (image.compressionPolicy == COMPRESSION_ON ||
+        image.pixelFormat != RGBA || image.rowOrder != RowOrder::top_down)
+    {
+        return make_exception_future<bool>(std::invalid_argument(
+            "The cursor image must be uncompressed, top-down RGBA"));
+    }
+
+    const CursorShapeMessage shape{image.width, image.height, hotspotX,
+                                   hotspotY};
+    QByteArray message{(const char*)(&shape), sizeof(shape)};
+    message.append((const char*)image.data, int(image.getBufferSize()));
+
+    return _enqueueRequest({[this, message] {
+        return _send(MESSAGE_TYPE_CURSOR_SHAPE, message);
+    }});
+}
+
+Stream::Future StreamSendWorker::enqueueCursorPosition(const int x, const int y,
+                                                       const bool visible)
+{
+    return _enqueueRequest({[this, x, y, visible] {
+        const CursorPositionMessage position{x, y, visible ? 1u : 0u};
+        return _send(MESSAGE_TYPE_CURSOR_POSITION,
+                     QByteArray{(const char*)(&position), sizeof(position)});
+    }});
+}
+
+Stream::Future StreamSendWorker::enqueueClockSync()
+{
+    return _enqueueRequest({[this] {
+        const ClockSyncMessage sync{currentTimestamp(), 0};
+        return _send(MESSAGE_TYPE_CLOCK_SYNC,
+                     QByteArray{(const char*)(&sync), sizeof(sync)});
+    }});
+}
+
+void StreamSendWorker::setClockOffset(const int64_t offset)
+{
+    _clockOffset = offset;
+    _hasClockOffset = true;
+}
+
 Stream::Future StreamSendWorker::_enqueueRequest(std::vector<Task>&& tasks,
                                                  const bool isFinish)
 {
     PromisePtr promise(new Promise);
-    _requests.enqueue({promise, tasks, isFinish});
+    _requests.enqueue({promise, std::move(tasks), isFinish});
     return promise->get_future();
 }
 
+bool StreamSendWorker::_startFrame(const int64_t captured)
+{
+    // The first image of a frame gives its capture time
+    if (_frameCaptured == 0)
+        _frameCaptured = captured;
+    return true;
+}
+
 bool StreamSendWorker::_sendImage(const ImageWrapper& image)
 {
     const auto sendFunc =
@@ -305,15 +385,39 @@ bool StreamSendWorker::_sendSegment(const Segment& segment)
         _currentView = segment.view;
     }
 
-    auto message = QByteArray{(const char*)(&segment.parameters),
-                              sizeof(SegmentParameters)};
-    message.append(segment.imageData);
-    return _send(MESSAGE_TYPE_PIXELSTREAM, message, false);
+    if (_frameSent == 0)
+        _frameSent = currentTimestamp();
+
+    const int size = sizeof(SegmentParameters) + segment.imageData.size();
+    return _socket.send(MessageHeader(MESSAGE_TYPE_PIXELSTREAM, size, _id),
+                        segment.parameters, segment.imageData, false);
+}
+
+bool StreamSendWorker::_sendSegments(const Segments& segments)
+{
+    for (const auto& segment : segments)
+    {
+        if (!_sendSegment(segment))
+            return false;
+    }
+    return true;
 }
 
-bool StreamSendWorker::_sendFinish()
+bool StreamSendWorker::_sendFinish(const FrameUpdate update)
 {
-    return _send(MESSAGE_TYPE_PIXELSTREAM_FINISH_FRAME, {});
+    const bool hasClockOffset = _hasClockOffset;
+    const int64_t clockOffset = _clockOffset;
+    const auto toServerClock = [hasClockOffset, clockOffset](const int64_t t) {
+        return (t == 0 || !hasClockOffset) ? 0 : t + clockOffset;
+    };
+    const FinishFrameMessage finish{++_frameId, toServerClock(_frameCaptured),
+                                    toServerClock(_frameSent),
+                                    as_underlying_type(update)};
+    _frameCaptured = 0;
+    _frameSent = 0;
+
+    return _send(MESSAGE_TYPE_PIXELSTREAM_FINISH_FRAME,
+                 QByteArray{(const char*)(&finish), sizeof(finish)});
 }
 
 bool StreamSendWorker::_send(const MessageType type, const QByteArray& message,
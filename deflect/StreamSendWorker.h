@@ -57,6 +57,8 @@
 
 #include <QThread>
 
+#include <atomic>
+
 namespace deflect
 {
 /**
@@ -82,7 +84,13 @@ public:
 
     /** Enqueue an image to be send during the execution of run(). */
     Stream::Future enqueueImage(const ImageWrapper& image, bool finish);
-    Stream::Future enqueueFinish();       //!< Enqueue a finishFrame()
+
+    /** Enqueue already encoded segments to be sent unchanged. */
+    Stream::Future enqueueSegments(Segments&& segments);
+
+    /** Enqueue a finishFrame() */
+    Stream::Future enqueueFinish(FrameUpdate update = FrameUpdate::full);
+
     Stream::Future enqueueOpen();         //!< Enqueue an open message
     Stream::Future enqueueClose();        //!< Enqueue a close message
     Stream::Future enqueueObserverOpen(); //!< Enqueue an observer open message
@@ -90,12 +98,33 @@ public:
     /** @sa Stream::registerForEvents */
     Stream::Future enqueueBindRequest(bool exclusive);
 
+    /** @sa Observer::subscribeToFrames */
+    Stream::Future enqueueFramesSubscription();
+
     /** @sa Stream::sendSizeHints */
     Stream::Future enqueueSizeHints(const SizeHints& hints);
 
     /** @sa Stream::sendData */
     Stream::Future enqueueData(QByteArray data);
 
+    /** @sa Stream::sendCursorShape */
+    Stream::Future enqueueCursorShape(const ImageWrapper& image, int hotspotX,
+                                      int hotspotY);
+
+    /** @sa Stream::sendCursorPosition */
+    Stream::Future enqueueCursorPosition(int x, int y, bool visible);
+
+    /** Enqueue a request for the server time to estimate the clock offset. */
+    Stream::Future enqueueClockSync();
+
+    /**
+     * Set the offset from the local clock to the server clock, applied to the
+     * timestamps sent with each frame. Until it is set, the frames are sent
+     * without timestamps.
+     * @threadsafe
+     */
+    void setClockOffset(int64_t offset);
+
 private:
     using Promise = std::promise<bool>;
     using PromisePtr = std::shared_ptr<Promise>;
@@ -120,6 +149,12 @@ private:
     bool _pendingFinish = false;
     Request _finishRequest;
 
+    std::atomic<int64_t> _clockOffset{0};
+    std::atomic<bool> _hasClockOffset{false};
+    uint64_t _frameId = 0;
+    int64_t _frameCaptured = 0;
+    int64_t _frameSent = 0;
+
     /** Main QThread loop doing asynchronous processing of queued tasks. */
     void run() final;
 
@@ -127,10 +162,12 @@ private:
                                    bool isFinish = false);
 
     friend class deflect::test::Application; // to send pre-compressed segments
+    bool _startFrame(int64_t captured);
     bool _sendImage(const ImageWrapper& image);
     bool _sendImageView(View view);
     bool _sendSegment(const Segment& segment);
-    bool _sendFinish();
+    bool _sendSegments(const Segments& segments);
+    bool _sendFinish(FrameUpdate update = FrameUpdate::full);
     bool _send(MessageType type, const QByteArray& message,
                bool waitForBytesWritten = true);
 };
@@ -76,10 +76,28 @@ void EventReceiver::_onEvent(const int socket)
     if (socket != _stream.getDescriptor())
         return;
 
+    // Moves accumulated since the last call are only emitted with their latest
+    // position, but always before the next event of another type to preserve
+    // the order of presses and releases. Touch points are updated in the order
+    // of their first pending update.
     while (_stream.hasEvent())
     {
         const Event& deflectEvent = _stream.getEvent();
 
+        if (deflectEvent.type == Event::EVT_MOVE)
+        {
+            _hasPendingMove = true;
+            _pendingMove = _pos(deflectEvent);
+            continue;
+        }
+        if (deflectEvent.type == Event::EVT_TOUCH_UPDATE)
+        {
+            _addTouchUpdate(deflectEvent.key, _pos(deflectEvent));
+            continue;
+        }
+
+        _flushMoves();
+
         switch (deflectEvent.type)
         {
         case Event::EVT_CLOSE:
@@ -91,12 +109,15 @@ void EventReceiver::_onEvent(const int socket)
         case Event::EVT_RELEASE:
             emit released(_pos(deflectEvent));
             break;
-        case Event::EVT_MOVE:
-            emit moved(_pos(deflectEvent));
-            break;
         case Event::EVT_VIEW_SIZE_CHANGED:
             emit resized(QSize{int(deflectEvent.dx), int(deflectEvent.dy)});
             break;
+        case Event::EVT_VIEW_HIDDEN:
+            emit hidden();
+            break;
+        case Event::EVT_VIEW_SHOWN:
+            emit shown();
+            break;
         case Event::EVT_SWIPE_LEFT:
             emit swipeLeft();
             break;
@@ -120,9 +141,6 @@ void EventReceiver::_onEvent(const int socket)
         case Event::EVT_TOUCH_ADD:
             emit touchPointAdded(deflectEvent.key, _pos(deflectEvent));
             break;
-        case Event::EVT_TOUCH_UPDATE:
-            emit touchPointUpdated(deflectEvent.key, _pos(deflectEvent));
-            break;
         case Event::EVT_TOUCH_REMOVE:
             emit touchPointRemoved(deflectEvent.key, _pos(deflectEvent));
             break;
@@ -134,11 +152,39 @@ void EventReceiver::_onEvent(const int socket)
             break;
         }
     }
+    _flushMoves();
 
     if (!_stream.isConnected())
         _stop();
 }
 
+void EventReceiver::_flushMoves()
+{
+    if (_hasPendingMove)
+    {
+        _hasPendingMove = false;
+        emit moved(_pendingMove);
+    }
+
+    const auto touchUpdates = std::move(_pendingTouchUpdates);
+    _pendingTouchUpdates.clear();
+    for (const auto& update : touchUpdates)
+        emit touchPointUpdated(update.first, update.second);
+}
+
+void EventReceiver::_addTouchUpdate(const int id, const QPointF& position)
+{
+    for (auto& update : _pendingTouchUpdates)
+    {
+        if (update.first == id)
+        {
+            update.second = position;
+            return;
+        }
+    }
+    _pendingTouchUpdates.emplace_back(id, position);
+}
+
 void EventReceiver::_stop()
 {
     _notifier->setEnabled(false);
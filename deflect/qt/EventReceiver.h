@@ -49,6 +49,9 @@
 
 #include <deflect/Stream.h>
 
+#include <utility>
+#include <vector>
+
 namespace deflect
 {
 namespace qt
@@ -67,6 +70,8 @@ signals:
     void moved(QPointF position);
 
     void resized(QSize newSize);
+    void hidden();
+    void shown();
     void closed();
 
     void keyPress(int key, int modifiers, QString text);
@@ -86,7 +91,13 @@ private:
     std::unique_ptr<QSocketNotifier> _notifier;
     std::unique_ptr<QTimer> _timer;
 
+    bool _hasPendingMove = false;
+    QPointF _pendingMove;
+    std::vector<std::pair<int, QPointF>> _pendingTouchUpdates;
+
     void _onEvent(int socket);
+    void _addTouchUpdate(int id, const QPointF& position);
+    void _flushMoves();
     void _stop();
 };
 }
@@ -0,0 +1,138 @@
+/*********************************************************************/
+/* Copyright (c) 2017, EPFL/Blue Brain Project                       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+
+#include "ImageHandoff.h"
+
+#include <QtConcurrentRun>
+
+#include <utility>
+
+namespace
+{
+bool _waitFor(const std::vector<std::shared_future<bool>>& futures)
+{
+    bool success = true;
+    for (const auto& future : futures)
+    {
+        try
+        {
+            if (!future.get())
+                success = false;
+        }
+        catch (...)
+        {
+            success = false;
+        }
+    }
+    return success;
+}
+}
+
+namespace deflect
+{
+namespace qt
+{
+ImageHandoff::ImageHandoff(SendFunc sendFunc)
+    : _sendFunc(std::move(sendFunc))
+{
+    connect(&_sendWatcher, &QFutureWatcher<bool>::finished, this,
+            &ImageHandoff::_onSendFinished);
+}
+
+ImageHandoff::~ImageHandoff()
+{
+    // The sender may still be reading the pixels of the image being sent
+    _sendWatcher.waitForFinished();
+}
+
+void ImageHandoff::push(Image image)
+{
+    if (_failed)
+        return;
+
+    // Replaces the previous image if it could not be sent in the meantime
+    _pendingImage = std::move(image);
+
+    // The next image is only sent once the completion of the current one has
+    // been processed
+    if (!_sending)
+        _sendPendingImage();
+}
+
+void ImageHandoff::waitForFinished()
+{
+    _sendWatcher.waitForFinished();
+}
+
+bool ImageHandoff::hasFailed() const
+{
+    return _failed;
+}
+
+void ImageHandoff::_onSendFinished()
+{
+    _sending = false;
+    if (!_sendWatcher.result())
+    {
+        _failed = true;
+        return;
+    }
+    _sendPendingImage();
+}
+
+void ImageHandoff::_sendPendingImage()
+{
+    if (_pendingImage.pixels.isEmpty())
+        return;
+
+    // Keep the pixels alive until they have been sent, and the previous ones
+    // to find the regions that changed
+    std::swap(_sendingImage, _pendingImage);
+    _previousImage = std::move(_pendingImage);
+    _pendingImage = Image();
+
+    const auto futures = _sendFunc(_sendingImage, _previousImage);
+    if (futures.empty())
+        return;
+
+    _sending = true;
+    _sendWatcher.setFuture(QtConcurrent::run(_waitFor, futures));
+}
+}
+}
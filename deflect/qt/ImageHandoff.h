@@ -0,0 +1,130 @@
+/*********************************************************************/
+/* Copyright (c) 2017, EPFL/Blue Brain Project                       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+
+#ifndef DELFECT_QT_IMAGEHANDOFF_H
+#define DELFECT_QT_IMAGEHANDOFF_H
+
+#include <deflect/ImageWrapper.h>
+
+#include <QByteArray>
+#include <QFutureWatcher>
+#include <QObject>
+#include <QSize>
+
+#include <functional>
+#include <future>
+#include <vector>
+
+namespace deflect
+{
+namespace qt
+{
+/**
+ * Hand the rendered images over to an asynchronous sender.
+ *
+ * Together with the image being rendered, the newest pushed image and the one
+ * being sent form a triple buffer: push() never waits for the network, and
+ * images pushed while sending are replaced by newer ones. The last image sent
+ * is kept to find the regions that changed in the next one.
+ */
+class ImageHandoff : public QObject
+{
+    Q_OBJECT
+
+public:
+    /** A rendered image, in the bottom-up order of the GL readback. */
+    struct Image
+    {
+        QByteArray pixels;
+        QSize size;
+        PixelFormat format = BGRA;
+    };
+
+    using Futures = std::vector<std::shared_future<bool>>;
+
+    /**
+     * Start sending an image.
+     *
+     * Called with the image to send and the last image sent, which is empty
+     * for the first image. Both are kept alive until the returned futures are
+     * ready. Returning no futures means that nothing had to be sent.
+     */
+    using SendFunc =
+        std::function<Futures(const Image& image, const Image& previous)>;
+
+    /** @param sendFunc the function which sends the images. */
+    explicit ImageHandoff(SendFunc sendFunc);
+
+    /** Wait until the image being sent has been sent. */
+    ~ImageHandoff();
+
+    /**
+     * Send an image, or keep it until the image being sent has been sent.
+     *
+     * An image kept from a previous call is dropped. Does nothing once
+     * sending has failed.
+     * @param image the image to send.
+     */
+    void push(Image image);
+
+    /** Wait until the image being sent has been sent. */
+    void waitForFinished();
+
+    /** @return true if sending an image has failed. */
+    bool hasFailed() const;
+
+private slots:
+    void _onSendFinished();
+
+private:
+    SendFunc _sendFunc;
+
+    Image _pendingImage;
+    Image _sendingImage;
+    Image _previousImage;
+    QFutureWatcher<bool> _sendWatcher;
+    bool _sending = false;
+    bool _failed = false;
+
+    void _sendPendingImage();
+};
+}
+}
+
+#endif
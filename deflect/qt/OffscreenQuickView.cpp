@@ -40,6 +40,7 @@
 
 #include "OffscreenQuickView.h"
 
+#include "PixelBufferReader.h"
 #include "QuickRenderer.h"
 
 #include <QOpenGLContext>
@@ -50,6 +51,9 @@
 #include <QQuickRenderControl>
 #include <QThread>
 
+#include <algorithm>
+#include <stdexcept>
+
 namespace deflect
 {
 namespace qt
@@ -119,19 +123,74 @@ QQmlContext* OffscreenQuickView::getRootContext() const
     return _qmlEngine->rootContext();
 }
 
-void OffscreenQuickView::timerEvent(QTimerEvent* e)
+void OffscreenQuickView::setAsyncReadback(const bool enable)
 {
-    if (e->timerId() == _renderTimer)
-        _render();
-    else if (e->timerId() == _stopRenderingDelayTimer)
+    if (_quickRenderer)
+        throw std::runtime_error(
+            "the readback mode must be set before the rendering starts");
+
+    if (enable)
+        _pixelBufferReader.reset(new PixelBufferReader);
+    else
+        _pixelBufferReader.reset();
+}
+
+void OffscreenQuickView::setMaxFrameRate(const unsigned int fps)
+{
+    if (fps == 0)
+        throw std::invalid_argument("the frame rate must be positive");
+
+    _maxFrameRate = fps;
+
+    // apply the new rate if currently rendering
+    if (_renderTimer != 0)
     {
         killTimer(_renderTimer);
-        killTimer(_stopRenderingDelayTimer);
         _renderTimer = 0;
-        _stopRenderingDelayTimer = 0;
+        _requestRender();
     }
 }
 
+unsigned int OffscreenQuickView::getMaxFrameRate() const
+{
+    return _maxFrameRate;
+}
+
+void OffscreenQuickView::setIdleTimeout(const int ms)
+{
+    _idleTimeout = std::max(0, ms);
+}
+
+int OffscreenQuickView::getIdleTimeout() const
+{
+    return _idleTimeout;
+}
+
+void OffscreenQuickView::setRenderingSuspended(const bool suspend)
+{
+    if (suspend == _renderingSuspended)
+        return;
+
+    _renderingSuspended = suspend;
+    if (_renderingSuspended)
+        _stopRendering();
+    else
+        _requestRender();
+}
+
+bool OffscreenQuickView::isRenderingSuspended() const
+{
+    return _renderingSuspended;
+}
+
+void OffscreenQuickView::timerEvent(QTimerEvent* e)
+{
+    if (e->timerId() == _renderTimer)
+        _render();
+    else if (e->timerId() == _stopRenderingDelayTimer)
+        _stopRendering();
+}
+
 void OffscreenQuickView::_setupRootItem()
 {
     disconnect(_qmlComponent.get(), &QQmlComponent::statusChanged, this,
@@ -180,11 +239,30 @@ void OffscreenQuickView::_setupRootItem()
 
 void OffscreenQuickView::_requestRender()
 {
+    if (_renderingSuspended)
+        return;
+
     killTimer(_stopRenderingDelayTimer);
     _stopRenderingDelayTimer = 0;
 
     if (_renderTimer == 0)
-        _renderTimer = startTimer(5, Qt::PreciseTimer);
+    {
+        const int interval = std::max(1, int(1000 / _maxFrameRate));
+        _renderTimer = startTimer(interval, Qt::PreciseTimer);
+    }
+}
+
+void OffscreenQuickView::_stopRendering()
+{
+    killTimer(_renderTimer);
+    killTimer(_stopRenderingDelayTimer);
+    _renderTimer = 0;
+    _stopRenderingDelayTimer = 0;
+
+    // deliver the last frame, which is otherwise only read back by the next
+    // rendering
+    if (_quickRenderer)
+        _quickRenderer->pause();
 }
 
 void OffscreenQuickView::_initRenderer()
@@ -220,6 +298,15 @@ void OffscreenQuickView::_initRenderer()
 
     connect(_quickRenderer.get(), &QuickRenderer::afterRender, this,
             &OffscreenQuickView::_afterRender, Qt::DirectConnection);
+    if (_pixelBufferReader)
+    {
+        connect(_quickRenderer.get(), &QuickRenderer::pausing, this,
+                &OffscreenQuickView::_flushReadback, Qt::DirectConnection);
+
+        // pixel buffers must be released while the GL context is current
+        connect(_quickRenderer.get(), &QuickRenderer::stopping,
+                [this]() { _pixelBufferReader->clear(); });
+    }
 
     _quickRenderer->init();
 }
@@ -235,14 +322,27 @@ void OffscreenQuickView::_render()
     _quickRenderer->render();
 
     if (_stopRenderingDelayTimer == 0)
-        _stopRenderingDelayTimer = startTimer(5000 /*ms*/);
+        _stopRenderingDelayTimer = startTimer(_idleTimeout);
 }
 
 void OffscreenQuickView::_afterRender()
 {
     // Called directly by the render thread just after the rendering is done.
     // The fbo can be safely assumed to be valid when this function executes.
+    if (_pixelBufferReader)
+    {
+        if (auto image = _pixelBufferReader->read(*_quickRenderer->fbo()))
+            emit afterRenderPixels(image->pixels, image->size, image->format);
+        return;
+    }
     emit afterRender(_quickRenderer->fbo()->toImage());
 }
+
+void OffscreenQuickView::_flushReadback()
+{
+    // Called directly by the render thread once the rendering has stopped
+    if (auto image = _pixelBufferReader->flush())
+        emit afterRenderPixels(image->pixels, image->size, image->format);
+}
 }
 }
@@ -41,6 +41,8 @@
 #ifndef DELFECT_QT_OFFSCREENQUICKVIEW_H
 #define DELFECT_QT_OFFSCREENQUICKVIEW_H
 
+#include <deflect/ImageWrapper.h>
+
 #include <QQuickWindow>
 #include <future>
 
@@ -62,6 +64,7 @@ enum class RenderMode
     DISABLED        /**< Only process events without rendering */
 };
 
+class PixelBufferReader;
 class QuickRenderer;
 
 /**
@@ -99,6 +102,51 @@ public:
     /** @return the root qml context. */
     QQmlContext* getRootContext() const;
 
+    /**
+     * Read back the rendered frames asynchronously using pixel buffer objects.
+     *
+     * When enabled, afterRenderPixels() is emitted instead of afterRender(),
+     * one frame later, without blocking the render thread on the transfer.
+     * The last frame is delivered when the rendering stops or is suspended.
+     * @param enable the new readback mode.
+     * @throw std::runtime_error if the rendering has already started.
+     */
+    void setAsyncReadback(bool enable);
+
+    /**
+     * Limit the rate at which the scene is rendered after it changed.
+     * @param fps the maximum number of frames per second (default: 200).
+     * @throw std::invalid_argument if fps is 0.
+     */
+    void setMaxFrameRate(unsigned int fps);
+
+    /** @return the maximum number of frames rendered per second. */
+    unsigned int getMaxFrameRate() const;
+
+    /**
+     * Set for how long the scene keeps being rendered after its last change.
+     *
+     * Some items (such as WebEngineView) update their content without
+     * notifying the scene of the change.
+     * @param ms the timeout in milliseconds (default: 5000).
+     */
+    void setIdleTimeout(int ms);
+
+    /** @return the time during which rendering continues after a change. */
+    int getIdleTimeout() const;
+
+    /**
+     * Suspend or resume the rendering, for instance while nobody looks at it.
+     *
+     * While suspended, scene changes are not rendered. The scene is rendered
+     * again as soon as the rendering is resumed.
+     * @param suspend true to suspend, false to resume the rendering.
+     */
+    void setRenderingSuspended(bool suspend);
+
+    /** @return true if the rendering is suspended. */
+    bool isRenderingSuspended() const;
+
 signals:
     /**
      * Notify that the scene has just finished rendering.
@@ -109,6 +157,18 @@ signals:
      */
     void afterRender(QImage image);
 
+    /**
+     * Notify that a frame has been read back asynchronously.
+     *
+     * @param pixels the rendered pixels, ordered bottom-up without padding.
+     * @param size the size of the image in pixels.
+     * @param format the format of the pixels (BGRA, or RGBA on OpenGL ES).
+     * @note this signal is emitted from the render thread.
+     * @see setAsyncReadback()
+     */
+    void afterRenderPixels(QByteArray pixels, QSize size,
+                           deflect::PixelFormat format);
+
 private:
     std::unique_ptr<QQuickRenderControl> _renderControl;
     const RenderMode _mode;
@@ -119,19 +179,25 @@ private:
 
     std::unique_ptr<QThread> _quickRendererThread;
     std::unique_ptr<QuickRenderer> _quickRenderer;
+    std::unique_ptr<PixelBufferReader> _pixelBufferReader;
 
     std::promise<bool> _loadPromise;
 
     int _renderTimer = 0;
     int _stopRenderingDelayTimer = 0;
+    unsigned int _maxFrameRate = 200;
+    int _idleTimeout = 5000;
+    bool _renderingSuspended = false;
 
     void timerEvent(QTimerEvent* e) final;
 
     void _setupRootItem();
     void _requestRender();
+    void _stopRendering();
     void _initRenderer();
     void _render();
     void _afterRender();
+    void _flushReadback();
 };
 }
 }
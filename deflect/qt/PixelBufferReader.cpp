@@ -0,0 +1,198 @@
+/*********************************************************************/
+/* Copyright (c) 2017, EPFL/Blue Brain Project                       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#include "PixelBufferReader.h"
+
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions>
+
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+// Not defined by the OpenGL ES headers
+const GLenum GL_BGRA_FORMAT = 0x80E1;
+const int BYTES_PER_PIXEL = 4;
+}
+
+namespace deflect
+{
+namespace qt
+{
+PixelBufferReader::PixelBufferReader(const size_t count)
+    : _transfers(count)
+{
+    if (count < 2)
+        throw std::invalid_argument(
+            "PixelBufferReader needs at least two pixel buffers");
+}
+
+bool PixelBufferReader::isSupported(const QOpenGLContext& context)
+{
+    if (context.isOpenGLES())
+        return context.format().majorVersion() >= 3;
+
+    return context.format().version() >= qMakePair(2, 1) ||
+           context.hasExtension("GL_ARB_pixel_buffer_object");
+}
+
+const PixelBufferReader::Image* PixelBufferReader::read(
+    QOpenGLFramebufferObject& fbo)
+{
+    if (!isSupported(*QOpenGLContext::currentContext()))
+        return _readDirectly(fbo, _image) ? &_image : nullptr;
+
+    _start(_transfers[_next], fbo);
+    _next = (_next + 1) % _transfers.size();
+
+    // The oldest transfer is the one to be overwritten by the next read
+    auto& oldest = _transfers[_next];
+    if (!oldest.pending)
+        return nullptr;
+
+    oldest.pending = false;
+    return _map(oldest, _image) ? &_image : nullptr;
+}
+
+const PixelBufferReader::Image* PixelBufferReader::flush()
+{
+    const auto count = _transfers.size();
+    auto& latest = _transfers[(_next + count - 1) % count];
+    if (!latest.pending)
+        return nullptr;
+
+    for (auto& transfer : _transfers)
+        transfer.pending = false;
+    return _map(latest, _image) ? &_image : nullptr;
+}
+
+void PixelBufferReader::clear()
+{
+    for (auto& transfer : _transfers)
+    {
+        transfer.buffer.destroy();
+        transfer.pending = false;
+    }
+    _next = 0;
+}
+
+bool PixelBufferReader::_readDirectly(QOpenGLFramebufferObject& fbo,
+                                      Image& image) const
+{
+    const auto size = fbo.size();
+    const int byteCount = size.width() * size.height() * BYTES_PER_PIXEL;
+
+    if (image.pixels.size() != byteCount || !image.pixels.isDetached())
+        image.pixels = QByteArray(byteCount, Qt::Uninitialized);
+    image.size = size;
+    image.format = RGBA;
+
+    fbo.bind();
+    QOpenGLContext::currentContext()->functions()->glReadPixels(
+        0, 0, size.width(), size.height(), GL_RGBA, GL_UNSIGNED_BYTE,
+        image.pixels.data());
+    fbo.release();
+    return true;
+}
+
+void PixelBufferReader::_start(Transfer& transfer,
+                               QOpenGLFramebufferObject& fbo) const
+{
+    auto context = QOpenGLContext::currentContext();
+
+    if (!transfer.buffer.isCreated())
+    {
+        if (!transfer.buffer.create())
+            throw std::runtime_error("could not create pixel buffer object");
+        transfer.buffer.setUsagePattern(QOpenGLBuffer::StreamRead);
+    }
+
+    // BGRA matches the native layout of most desktop GPUs, avoiding a
+    // conversion by the driver. OpenGL ES only guarantees RGBA readback.
+    const bool gles = context->isOpenGLES();
+    transfer.format = gles ? RGBA : BGRA;
+    transfer.size = fbo.size();
+
+    const int byteCount =
+        transfer.size.width() * transfer.size.height() * BYTES_PER_PIXEL;
+
+    transfer.buffer.bind();
+    if (transfer.buffer.size() != byteCount)
+        transfer.buffer.allocate(byteCount);
+
+    // Returns immediately, the data is copied to the buffer by the GPU
+    fbo.bind();
+    context->functions()->glReadPixels(0, 0, transfer.size.width(),
+                                       transfer.size.height(),
+                                       gles ? GL_RGBA : GL_BGRA_FORMAT,
+                                       GL_UNSIGNED_BYTE, nullptr);
+    fbo.release();
+    transfer.buffer.release();
+
+    transfer.pending = true;
+}
+
+bool PixelBufferReader::_map(Transfer& transfer, Image& image) const
+{
+    const int byteCount = transfer.buffer.size();
+
+    transfer.buffer.bind();
+    auto data =
+        transfer.buffer.mapRange(0, byteCount, QOpenGLBuffer::RangeRead);
+    if (!data)
+        data = transfer.buffer.map(QOpenGLBuffer::ReadOnly);
+    if (!data)
+    {
+        transfer.buffer.release();
+        return false;
+    }
+
+    if (image.pixels.size() != byteCount || !image.pixels.isDetached())
+        image.pixels = QByteArray(byteCount, Qt::Uninitialized);
+    std::memcpy(image.pixels.data(), data, byteCount);
+    image.size = transfer.size;
+    image.format = transfer.format;
+
+    transfer.buffer.unmap();
+    transfer.buffer.release();
+    return true;
+}
+}
+}
@@ -0,0 +1,133 @@
+/*********************************************************************/
+/* Copyright (c) 2017, EPFL/Blue Brain Project                       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#ifndef DELFECT_QT_PIXELBUFFERREADER_H
+#define DELFECT_QT_PIXELBUFFERREADER_H
+
+#include <deflect/ImageWrapper.h>
+
+#include <QByteArray>
+#include <QOpenGLBuffer>
+#include <QSize>
+
+#include <vector>
+
+QT_FORWARD_DECLARE_CLASS(QOpenGLContext)
+QT_FORWARD_DECLARE_CLASS(QOpenGLFramebufferObject)
+
+namespace deflect
+{
+namespace qt
+{
+/**
+ * Read back the content of framebuffer objects asynchronously, through a ring
+ * of pixel buffer objects.
+ *
+ * Each call to read() starts the transfer of the FBO into the next pixel buffer
+ * and maps the pixel buffer of the oldest transfer, which had time to complete
+ * while the subsequent frames were rendering. The images are thus delivered
+ * with a delay of (count - 1) frames.
+ *
+ * If the context does not support pixel buffer objects, the FBO is read
+ * synchronously instead.
+ *
+ * All the methods must be called from the render thread with the GL context
+ * current.
+ */
+class PixelBufferReader
+{
+public:
+    /** An image read back from an FBO. */
+    struct Image
+    {
+        QByteArray pixels; /**< Bottom-up rows, without padding */
+        QSize size;
+        PixelFormat format = BGRA;
+    };
+
+    /**
+     * @param count the number of pixel buffers to cycle through, at least 2.
+     * @throw std::invalid_argument if count is less than 2.
+     */
+    explicit PixelBufferReader(size_t count = 2);
+
+    /** @return true if the context supports pixel buffer objects. */
+    static bool isSupported(const QOpenGLContext& context);
+
+    /**
+     * Start reading the given FBO and map the oldest pending transfer.
+     *
+     * @param fbo the framebuffer object to read.
+     * @return the image of the oldest pending transfer, or nullptr if none is
+     *         available yet. Its pixel buffer is reused for the next images
+     *         once it is no longer shared.
+     */
+    const Image* read(QOpenGLFramebufferObject& fbo);
+
+    /**
+     * Map the most recent pending transfer, once no more FBO will be read for
+     * a while, discarding the older ones.
+     *
+     * @return the image of the last FBO read, or nullptr if it was already
+     *         returned by read() or flush().
+     */
+    const Image* flush();
+
+    /** Release the GL resources, discarding the pending transfers. */
+    void clear();
+
+private:
+    struct Transfer
+    {
+        QOpenGLBuffer buffer{QOpenGLBuffer::PixelPackBuffer};
+        QSize size;
+        PixelFormat format = BGRA;
+        bool pending = false;
+    };
+    std::vector<Transfer> _transfers;
+    size_t _next = 0;
+    Image _image;
+
+    bool _readDirectly(QOpenGLFramebufferObject& fbo, Image& image) const;
+    void _start(Transfer& transfer, QOpenGLFramebufferObject& fbo) const;
+    bool _map(Transfer& transfer, Image& image) const;
+};
+}
+}
+
+#endif
@@ -59,7 +59,27 @@ QmlStreamer::~QmlStreamer()
 
 void QmlStreamer::useAsyncSend(const bool async)
 {
-    _impl->useAsyncSend(async);
+    Q_UNUSED(async);
+}
+
+void QmlStreamer::setMaxFrameRate(const unsigned int fps)
+{
+    _impl->getQuickView().setMaxFrameRate(fps);
+}
+
+unsigned int QmlStreamer::getMaxFrameRate() const
+{
+    return _impl->getQuickView().getMaxFrameRate();
+}
+
+void QmlStreamer::setIdleTimeout(const int ms)
+{
+    _impl->getQuickView().setIdleTimeout(ms);
+}
+
+int QmlStreamer::getIdleTimeout() const
+{
+    return _impl->getQuickView().getIdleTimeout();
 }
 
 QQuickItem* QmlStreamer::getRootItem()
@@ -70,6 +70,12 @@ namespace qt
  * of an on-screen context menu (which may crash the application) and instead
  * switch to a "mouse" interaction mode. This allows users to interact within
  * a WebGL canevas or select text instead of scrolling the page.
+ *
+ * Rendering and streaming are decoupled: the scene is rendered at its own pace
+ * while the stream sends the most recent frame each time the previous one has
+ * been sent, dropping the intermediate frames if the network is too slow.
+ * The rendering is suspended while the remote window is hidden, as notified by
+ * Event::EVT_VIEW_HIDDEN and Event::EVT_VIEW_SHOWN.
  */
 class DEFLECTQT_API QmlStreamer : public QObject
 {
@@ -91,9 +97,31 @@ public:
 
     ~QmlStreamer();
 
-    /** Use asynchronous send of images via Deflect stream. Default off. */
+    /**
+     * @deprecated images are always sent asynchronously since version 1.8, this
+     *             method has no effect.
+     */
     void useAsyncSend(bool async);
 
+    /**
+     * Limit the frame rate of the rendering and thus of the stream.
+     * @param fps the maximum number of frames per second (default: 200).
+     * @throw std::invalid_argument if fps is 0.
+     */
+    void setMaxFrameRate(unsigned int fps);
+
+    /** @return the maximum number of frames per second. */
+    unsigned int getMaxFrameRate() const;
+
+    /**
+     * Set for how long the scene keeps being rendered after its last change.
+     * @param ms the timeout in milliseconds (default: 5000).
+     */
+    void setIdleTimeout(int ms);
+
+    /** @return the idle timeout in milliseconds. */
+    int getIdleTimeout() const;
+
     /** @return the QML root item, might be nullptr if not ready yet. */
     QQuickItem* getRootItem();
 
@@ -49,6 +49,9 @@
 #include <QQmlContext>
 #include <QQuickItem>
 #include <QQuickRenderControl>
+#include <QRect>
+
+#include <cstring>
 
 namespace
 {
@@ -57,6 +60,51 @@ const QString GESTURES_CONTEXT_PROPERTY("deflectgestures");
 const QString WEBENGINEVIEW_OBJECT_NAME("webengineview");
 const int TOUCH_TAPANDHOLD_DIST_PX = 20;
 const int TOUCH_TAPANDHOLD_TIMEOUT_MS = 200;
+const int TILE_SIZE = 512; // aligned with the segments of the Stream
+const int BYTES_PER_PIXEL = 4;
+
+// The pixels are bottom-up, so the rows of a tile are stored in reverse order
+int _firstRow(const QSize& size, const QRect& tile)
+{
+    return size.height() - tile.y() - tile.height();
+}
+
+bool _isTileChanged(const QByteArray& pixels, const QByteArray& previous,
+                    const QSize& size, const QRect& tile)
+{
+    const int pitch = size.width() * BYTES_PER_PIXEL;
+    const int lineSize = tile.width() * BYTES_PER_PIXEL;
+    const int start =
+        _firstRow(size, tile) * pitch + tile.x() * BYTES_PER_PIXEL;
+    for (int i = 0; i < tile.height(); ++i)
+    {
+        const int offset = start + i * pitch;
+        if (std::memcmp(pixels.constData() + offset,
+                        previous.constData() + offset, lineSize) != 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+QByteArray _copyTile(const QByteArray& pixels, const QSize& size,
+                     const QRect& tile)
+{
+    const int pitch = size.width() * BYTES_PER_PIXEL;
+    const int lineSize = tile.width() * BYTES_PER_PIXEL;
+    const int start =
+        _firstRow(size, tile) * pitch + tile.x() * BYTES_PER_PIXEL;
+
+    QByteArray tilePixels(lineSize * tile.height(), Qt::Uninitialized);
+    for (int i = 0; i < tile.height(); ++i)
+    {
+        std::memcpy(tilePixels.data() + i * lineSize,
+                    pixels.constData() + start + i * pitch, lineSize);
+    }
+    return tilePixels;
+}
+
 #ifdef DEFLECTQT_MULTITHREADED
 const auto renderMode = deflect::qt::RenderMode::MULTITHREADED;
 #else
@@ -76,12 +124,15 @@ QmlStreamer::Impl::Impl(const QString& qmlFile, const std::string& streamHost,
     , _touchInjector{TouchInjector::create(*_quickView)}
     , _streamHost{streamHost}
     , _streamId{streamId}
-    , _sendFuture{make_ready_future(true)}
+    , _imageHandoff{[this](const Image& image, const Image& previous) {
+        return _sendImage(image, previous);
+    }}
 {
     _setupMouseModeSwitcher();
     _setupSizeHintsConnections();
 
-    connect(_quickView.get(), &OffscreenQuickView::afterRender, this,
+    _quickView->setAsyncReadback(true);
+    connect(_quickView.get(), &OffscreenQuickView::afterRenderPixels, this,
             &QmlStreamer::Impl::_afterRender);
 
     // Expose stream gestures to qml objects
@@ -98,11 +149,14 @@ QmlStreamer::Impl::Impl(const QString& qmlFile, const std::string& streamHost,
 
 QmlStreamer::Impl::~Impl()
 {
+    // The stream may still be reading the pixels of the image being sent
+    _imageHandoff.waitForFinished();
 }
 
-void QmlStreamer::Impl::_afterRender(const QImage image)
+void QmlStreamer::Impl::_afterRender(const QByteArray pixels, const QSize size,
+                                     const PixelFormat format)
 {
-    if (!_sendFuture.valid() || !_sendFuture.get())
+    if (_imageHandoff.hasFailed())
         return;
 
     if (!_stream && !_setupDeflectStream())
@@ -111,33 +165,82 @@ void QmlStreamer::Impl::_afterRender(const QImage image)
         return;
     }
 
-    if (image.isNull())
+    if (pixels.isEmpty())
     {
         qDebug() << "Empty image not streamed";
         return;
     }
 
-    _image = image;
-    ImageWrapper imageWrapper(_image.constBits(), _image.width(),
-                              _image.height(), BGRA);
+    _imageHandoff.push(Image{pixels, size, format});
+}
+
+QmlStreamer::Impl::Futures QmlStreamer::Impl::_sendImage(
+    const Image& image, const Image& previous)
+{
+    const bool keyframe = !_stream->supportsFrameUpdates() ||
+                          previous.pixels.isEmpty() ||
+                          previous.size != image.size ||
+                          previous.format != image.format;
+
+    return keyframe ? _sendKeyframe(image) : _sendChangedTiles(image, previous);
+}
+
+QmlStreamer::Impl::Futures QmlStreamer::Impl::_sendKeyframe(const Image& image)
+{
+    ImageWrapper imageWrapper(image.pixels.constData(), image.size.width(),
+                              image.size.height(), image.format);
+    imageWrapper.rowOrder = RowOrder::bottom_up;
     imageWrapper.compressionPolicy = COMPRESSION_ON;
     imageWrapper.compressionQuality = 80;
 
-    _sendFuture = _stream->sendAndFinish(imageWrapper);
-    if (!_asyncSend)
-        _sendFuture.wait();
+    Futures futures;
+    futures.push_back(_stream->send(imageWrapper).share());
+    futures.push_back(_stream->finishFrame(FrameUpdate::keyframe).share());
+    return futures;
+}
+
+QmlStreamer::Impl::Futures QmlStreamer::Impl::_sendChangedTiles(
+    const Image& image, const Image& previous)
+{
+    const auto& size = image.size;
+
+    _tiles.clear();
+    Futures futures;
+    for (int y = 0; y < size.height(); y += TILE_SIZE)
+    {
+        for (int x = 0; x < size.width(); x += TILE_SIZE)
+        {
+            const QRect tile = QRect(x, y, TILE_SIZE, TILE_SIZE) &
+                               QRect(QPoint(), size);
+            if (!_isTileChanged(image.pixels, previous.pixels, size, tile))
+                continue;
+            _tiles.push_back(_copyTile(image.pixels, size, tile));
+
+            ImageWrapper imageWrapper(_tiles.back().constData(), tile.width(),
+                                      tile.height(), image.format, tile.x(),
+                                      tile.y());
+            imageWrapper.rowOrder = RowOrder::bottom_up;
+            imageWrapper.compressionPolicy = COMPRESSION_ON;
+            imageWrapper.compressionQuality = 80;
+            futures.push_back(_stream->send(imageWrapper).share());
+        }
+    }
+
+    // The server keeps the segments of the tiles that did not change
+    if (!futures.empty())
+        futures.push_back(_stream->finishFrame(FrameUpdate::partial).share());
+    return futures;
 }
 
 void QmlStreamer::Impl::_onStreamClosed()
 {
     // Stop rendering
-    disconnect(_quickView.get(), &OffscreenQuickView::afterRender, this,
+    disconnect(_quickView.get(), &OffscreenQuickView::afterRenderPixels, this,
                &QmlStreamer::Impl::_afterRender);
     _quickView.reset();
 
     // Terminate the stream
-    if (_sendFuture.valid())
-        _sendFuture.wait();
+    _imageHandoff.waitForFinished();
     _eventReceiver.reset();
     _stream.reset();
 
@@ -279,6 +382,12 @@ bool QmlStreamer::Impl::_setupDeflectStream()
     connect(_eventReceiver.get(), &EventReceiver::resized,
             [this](const QSize size) { _quickView->resize(size); });
 
+    // do not render while nobody is looking
+    connect(_eventReceiver.get(), &EventReceiver::hidden,
+            [this]() { _quickView->setRenderingSuspended(true); });
+    connect(_eventReceiver.get(), &EventReceiver::shown,
+            [this]() { _quickView->setRenderingSuspended(false); });
+
     // inject key events
     connect(_eventReceiver.get(), &EventReceiver::keyPress, this,
             &QmlStreamer::Impl::_onKeyPress);
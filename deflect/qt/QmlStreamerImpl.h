@@ -41,12 +41,14 @@
 #ifndef DELFECT_QT_QMLSTREAMERIMPL_H
 #define DELFECT_QT_QMLSTREAMERIMPL_H
 
-#include <QImage>
+#include <QByteArray>
 #include <QObject>
+#include <QSize>
 #include <QThread>
 #include <QTimer>
 
 #include "../SizeHints.h"
+#include "ImageHandoff.h"
 #include "OffscreenQuickView.h"
 #include "QmlStreamer.h"
 
@@ -72,7 +74,7 @@ public:
          const std::string& streamId);
     ~Impl();
 
-    void useAsyncSend(const bool async) { _asyncSend = async; }
+    OffscreenQuickView& getQuickView() { return *_quickView; }
     QQuickItem* getRootItem() { return _quickView->getRootItem(); }
     QQmlEngine* getQmlEngine() { return _quickView->getEngine(); }
     Stream* getStream() { return _stream.get(); }
@@ -80,7 +82,7 @@ signals:
     void streamClosed();
 
 private slots:
-    void _afterRender(QImage image);
+    void _afterRender(QByteArray pixels, QSize size, PixelFormat format);
 
     void _onPressed(QPointF position);
     void _onReleased(QPointF position);
@@ -93,6 +95,11 @@ private slots:
 
 private:
     void _setupSizeHintsConnections();
+    using Image = ImageHandoff::Image;
+    using Futures = ImageHandoff::Futures;
+    Futures _sendImage(const Image& image, const Image& previous);
+    Futures _sendKeyframe(const Image& image);
+    Futures _sendChangedTiles(const Image& image, const Image& previous);
     void _send(QKeyEvent& keyEvent);
     bool _sendToWebengineviewItems(QKeyEvent& keyEvent);
     std::string _getDeflectStreamIdentifier() const;
@@ -119,9 +126,10 @@ private:
     const std::string _streamId;
     SizeHints _sizeHints;
 
-    bool _asyncSend{false};
-    Stream::Future _sendFuture;
-    QImage _image;
+    // Rendering never waits for the network, only the tiles that differ from
+    // the previous image are sent
+    ImageHandoff _imageHandoff;
+    std::vector<QByteArray> _tiles;
 
     QTimer _mouseModeTimer;
     bool _mouseMode{false};
@@ -129,6 +129,13 @@ void QuickRenderer::render()
         _onRender();
 }
 
+void QuickRenderer::pause()
+{
+    const auto type =
+        _multithreaded ? Qt::QueuedConnection : Qt::DirectConnection;
+    QMetaObject::invokeMethod(this, "_onPause", type);
+}
+
 void QuickRenderer::stop()
 {
     QMetaObject::invokeMethod(this, "_onStop", _connectionType());
@@ -219,6 +226,15 @@ void QuickRenderer::_initRenderControl()
     _initialized = true;
 }
 
+void QuickRenderer::_onPause()
+{
+    if (!_initialized || _renderTarget == RenderTarget::NONE)
+        return;
+
+    _context->makeCurrent(_getSurface());
+    emit pausing();
+}
+
 void QuickRenderer::_onStop()
 {
     _initialized = false;
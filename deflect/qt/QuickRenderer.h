@@ -122,6 +122,12 @@ public:
      */
     void render();
 
+    /**
+     * To be called from GUI/main thread when no frame will be rendered for a
+     * while. Does not block, rendering can resume with render() at any time.
+     */
+    void pause();
+
     /**
      * To be called from GUI/main thread to stop using this object on the render
      * thread. Blocks until operation on render thread is done.
@@ -135,6 +141,13 @@ signals:
      */
     void afterRender();
 
+    /**
+     * Emitted from the render thread after pause(). Can be used to complete
+     * pending operations on the last rendered frame while the GL context is
+     * bound.
+     */
+    void pausing();
+
     /**
      * Emitted from the render thread during stop(). Can be used to do some last
      * cleanup operations while the GL context is bound.
@@ -168,6 +181,7 @@ private slots:
     // Called in the render thread
     void _createGLContext();
     void _initRenderControl();
+    void _onPause();
     void _onStop();
 };
 }
@@ -77,7 +77,9 @@ void TouchInjector::updateTouchPoint(const int id, const QPointF position)
     if (!_touchPointMap.contains(id))
         return;
 
-    _handleEvent(id, position, QEvent::TouchUpdate);
+    if (_pendingUpdates.isEmpty())
+        QMetaObject::invokeMethod(this, "_flushUpdates", Qt::QueuedConnection);
+    _pendingUpdates[id] = position;
 }
 
 void TouchInjector::removeTouchPoint(const int id, const QPointF position)
@@ -135,8 +137,28 @@ Qt::TouchPointStates _getTouchPointState(const QEvent::Type eventType)
     }
 }
 
-void TouchInjector::_handleEvent(const int id, const QPointF& normalizedPos,
-                                 const QEvent::Type eventType)
+void TouchInjector::_flushUpdates()
+{
+    if (_pendingUpdates.isEmpty())
+        return;
+
+    for (auto it = _pendingUpdates.begin(); it != _pendingUpdates.end(); ++it)
+    {
+        auto touchPoint = _makeTouchPoint(it.key(), it.value());
+        _fill(touchPoint, _touchPointMap.value(it.key()));
+        touchPoint.setState(Qt::TouchPointMoved);
+        _touchPointMap.insert(it.key(), touchPoint);
+    }
+    _pendingUpdates.clear();
+
+    _postTouchEvent(QEvent::TouchUpdate, Qt::TouchPointMoved);
+
+    for (auto& touchPoint : _touchPointMap)
+        touchPoint.setState(Qt::TouchPointStationary);
+}
+
+QTouchEvent::TouchPoint TouchInjector::_makeTouchPoint(
+    const int id, const QPointF& normalizedPos) const
 {
     const QPointF screenPos = _mapToSceneFunction(normalizedPos);
 
@@ -145,6 +167,25 @@ void TouchInjector::_handleEvent(const int id, const QPointF& normalizedPos,
     touchPoint.setPos(screenPos);
     touchPoint.setScreenPos(screenPos);
     touchPoint.setNormalizedPos(normalizedPos);
+    return touchPoint;
+}
+
+void TouchInjector::_postTouchEvent(const QEvent::Type eventType,
+                                    const Qt::TouchPointStates touchPointStates)
+{
+    QEvent* touchEvent =
+        new QTouchEvent(eventType, &_device, Qt::NoModifier, touchPointStates,
+                        _touchPointMap.values());
+    QCoreApplication::postEvent(&_target, touchEvent);
+}
+
+void TouchInjector::_handleEvent(const int id, const QPointF& normalizedPos,
+                                 const QEvent::Type eventType)
+{
+    // Deliver the pending updates first to preserve the order of the events
+    _flushUpdates();
+
+    auto touchPoint = _makeTouchPoint(id, normalizedPos);
 
     switch (eventType)
     {
@@ -168,10 +209,7 @@ void TouchInjector::_handleEvent(const int id, const QPointF& normalizedPos,
         touchEventType =
             _touchPointMap.isEmpty() ? QEvent::TouchEnd : QEvent::TouchUpdate;
 
-    QEvent* touchEvent =
-        new QTouchEvent(touchEventType, &_device, Qt::NoModifier,
-                        touchPointState, _touchPointMap.values());
-    QCoreApplication::postEvent(&_target, touchEvent);
+    _postTouchEvent(touchEventType, touchPointState);
 
     // Prepare state for next call to handle event
     if (eventType == QEvent::TouchEnd)
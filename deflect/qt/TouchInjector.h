@@ -54,6 +54,11 @@ namespace qt
 {
 /**
  * Inject complete QTouchEvent from separate touch added/updated/removed events.
+ *
+ * Successive updates are coalesced: the moved points are delivered with their
+ * latest position in a single event, once the event loop processes them.
+ * Points added or removed in the meantime flush the pending updates first to
+ * preserve the order of the events.
  */
 class TouchInjector : public QObject
 {
@@ -89,7 +94,8 @@ public:
     /**
      * Update an existing touch point.
      *
-     * Does nothing if the given point has not been added or was removed.
+     * Does nothing if the given point has not been added or was removed. The
+     * update is delivered asynchronously, merged with the other updates.
      * @param id the identifier for the point
      * @param position the new normalized position of the point
      */
@@ -107,14 +113,22 @@ public:
     /** Remove all touch points. */
     void removeAllTouchPoints();
 
+private slots:
+    void _flushUpdates();
+
 private:
     void _handleEvent(const int id, const QPointF& normalizedPos,
                       const QEvent::Type eventType);
+    QTouchEvent::TouchPoint _makeTouchPoint(int id,
+                                            const QPointF& normalizedPos) const;
+    void _postTouchEvent(QEvent::Type eventType,
+                         Qt::TouchPointStates touchPointStates);
 
     QObject& _target;
     MapToSceneFunc _mapToSceneFunction;
     QTouchDevice _device;
     QMap<int, QTouchEvent::TouchPoint> _touchPointMap;
+    QMap<int, QPointF> _pendingUpdates;
 };
 }
 }
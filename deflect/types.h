@@ -66,6 +66,38 @@ enum class ChromaSubsampling
     YUV420  /**< 50% vertical + horizontal sub-sampling */
 };
 
+/** Decoding of JPEG segments performed by the Server upon reception. */
+enum class SegmentDecoding
+{
+    none, /**< Dispatch segments as they were received */
+    rgba, /**< Decode JPEG segments to DataType::rgba */
+    yuv   /**< Decode JPEG segments to DataType::yuv4**, skipping RGB step */
+};
+
+/**
+ * Synchronization of the frames of the multiple sources of a stream.
+ * @version 1.8
+ */
+enum class SourceSynchronization
+{
+    strict,     /**< Wait for all the sources to finish each frame */
+    deadline,   /**< Complete frames after a deadline, reusing the previous
+                     segments of the late sources */
+    independent /**< Combine the latest frame of each source */
+};
+
+/**
+ * Relation of a frame sent by a Stream to its previous frames.
+ * @version 1.8
+ */
+enum class FrameUpdate : std::uint32_t
+{
+    full,     /**< The frame replaces the previous one */
+    keyframe, /**< A full frame, retained to be updated by partial frames */
+    partial   /**< Only the regions which changed since the previous keyframe
+                   or partial frame, the others are retained by the receiver */
+};
+
 /** Cast an enum class value to its underlying type. */
 template <typename E>
 constexpr typename std::underlying_type<E>::type as_underlying_type(E e)
@@ -97,10 +129,12 @@ std::future<T> make_exception_future(Exception&& e)
 class EventReceiver;
 class Frame;
 class FrameDispatcher;
+class FramePool;
 class SegmentDecoder;
 class Server;
 class Stream;
 
+struct Cursor;
 struct Event;
 struct ImageWrapper;
 struct MessageHeader;
@@ -111,6 +145,7 @@ struct SizeHints;
 using BoolPromisePtr = std::shared_ptr<std::promise<bool>>;
 using FramePtr = std::shared_ptr<Frame>;
 using Segments = std::vector<Segment>;
+using SegmentsPtr = std::shared_ptr<Segments>;
 using SegmentParametersList = std::vector<SegmentParameters>;
 
 namespace qt
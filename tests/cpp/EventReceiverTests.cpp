@@ -0,0 +1,183 @@
+/*********************************************************************/
+/* Copyright (c) 2017, EPFL/Blue Brain Project                       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+
+#define BOOST_TEST_MODULE EventReceiverTests
+#include <boost/test/unit_test.hpp>
+namespace ut = boost::unit_test;
+
+#include "DeflectServer.h"
+#include "MinimalGlobalQtApp.h"
+
+#include <deflect/Stream.h>
+#include <deflect/qt/EventReceiver.h>
+
+#include <QElapsedTimer>
+#include <QThread>
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace
+{
+const QString testStreamId("teststream");
+
+deflect::Event makeEvent(const deflect::Event::EventType type,
+                         const double x, const int key = 0)
+{
+    deflect::Event event;
+    event.type = type;
+    event.mouseX = x;
+    event.key = key;
+    return event;
+}
+
+// Record the signals of an EventReceiver as "signal(id,x)" strings
+struct SignalRecorder
+{
+    explicit SignalRecorder(deflect::qt::EventReceiver& receiver)
+    {
+        using deflect::qt::EventReceiver;
+        QObject::connect(&receiver, &EventReceiver::pressed,
+                         [this](QPointF pos) { add("pressed", 0, pos); });
+        QObject::connect(&receiver, &EventReceiver::released,
+                         [this](QPointF pos) { add("released", 0, pos); });
+        QObject::connect(&receiver, &EventReceiver::moved,
+                         [this](QPointF pos) { add("moved", 0, pos); });
+        QObject::connect(&receiver, &EventReceiver::touchPointAdded,
+                         [this](int id, QPointF pos) {
+                             add("added", id, pos);
+                         });
+        QObject::connect(&receiver, &EventReceiver::touchPointUpdated,
+                         [this](int id, QPointF pos) {
+                             add("updated", id, pos);
+                         });
+        QObject::connect(&receiver, &EventReceiver::touchPointRemoved,
+                         [this](int id, QPointF pos) {
+                             add("removed", id, pos);
+                         });
+    }
+
+    void add(const std::string& name, const int id, const QPointF& pos)
+    {
+        received.push_back(name + "(" + std::to_string(id) + "," +
+                           std::to_string(std::lround(pos.x() * 10)) + ")");
+    }
+
+    std::vector<std::string> received;
+};
+
+void processEventsUntil(const SignalRecorder& recorder, const size_t count)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (recorder.received.size() < count && timer.elapsed() < 5000)
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+}
+}
+
+BOOST_GLOBAL_FIXTURE(MinimalGlobalQtApp);
+
+BOOST_FIXTURE_TEST_SUITE(eventReceiver, DeflectServer)
+
+BOOST_AUTO_TEST_CASE(testBurstsOfMovesAreCoalescedInOrder)
+{
+    deflect::Stream stream(testStreamId.toStdString(), "localhost",
+                           serverPort());
+    BOOST_REQUIRE(stream.isConnected());
+    BOOST_REQUIRE(stream.registerForEvents());
+
+    deflect::qt::EventReceiver receiver(stream);
+    SignalRecorder recorder(receiver);
+
+    using deflect::Event;
+    processEvent(makeEvent(Event::EVT_PRESS, 0.1));
+    for (int i = 2; i <= 5; ++i)
+        processEvent(makeEvent(Event::EVT_MOVE, 0.1 * i));
+    processEvent(makeEvent(Event::EVT_RELEASE, 0.6));
+    processEvent(makeEvent(Event::EVT_MOVE, 0.7));
+    processEvent(makeEvent(Event::EVT_MOVE, 0.8));
+
+    // the whole burst is received before the event loop processes it
+    QThread::msleep(200);
+    processEventsUntil(recorder, 4);
+
+    const std::vector<std::string> expected{"pressed(0,1)", "moved(0,5)",
+                                            "released(0,6)", "moved(0,8)"};
+    BOOST_CHECK_EQUAL_COLLECTIONS(recorder.received.begin(),
+                                  recorder.received.end(), expected.begin(),
+                                  expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(testBurstsOfTouchUpdatesAreCoalescedInOrder)
+{
+    deflect::Stream stream(testStreamId.toStdString(), "localhost",
+                           serverPort());
+    BOOST_REQUIRE(stream.isConnected());
+    BOOST_REQUIRE(stream.registerForEvents());
+
+    deflect::qt::EventReceiver receiver(stream);
+    SignalRecorder recorder(receiver);
+
+    using deflect::Event;
+    processEvent(makeEvent(Event::EVT_TOUCH_ADD, 0.1, 1));
+    processEvent(makeEvent(Event::EVT_TOUCH_ADD, 0.2, 2));
+    processEvent(makeEvent(Event::EVT_TOUCH_UPDATE, 0.3, 2));
+    processEvent(makeEvent(Event::EVT_TOUCH_UPDATE, 0.4, 1));
+    processEvent(makeEvent(Event::EVT_TOUCH_UPDATE, 0.5, 2));
+    processEvent(makeEvent(Event::EVT_TOUCH_UPDATE, 0.6, 1));
+    processEvent(makeEvent(Event::EVT_TOUCH_REMOVE, 0.7, 1));
+    processEvent(makeEvent(Event::EVT_TOUCH_UPDATE, 0.8, 2));
+    processEvent(makeEvent(Event::EVT_TOUCH_UPDATE, 0.9, 2));
+
+    // the whole burst is received before the event loop processes it
+    QThread::msleep(200);
+    processEventsUntil(recorder, 6);
+
+    // updates are flushed before the removal, in the order of arrival of
+    // the points
+    const std::vector<std::string> expected{"added(1,1)",   "added(2,2)",
+                                            "updated(2,5)", "updated(1,6)",
+                                            "removed(1,7)", "updated(2,9)"};
+    BOOST_CHECK_EQUAL_COLLECTIONS(recorder.received.begin(),
+                                  recorder.received.end(), expected.begin(),
+                                  expected.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
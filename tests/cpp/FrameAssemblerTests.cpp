@@ -0,0 +1,169 @@
+/*********************************************************************/
+/* Copyright (c) 2017, EPFL/Blue Brain Project                       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#define BOOST_TEST_MODULE FrameAssemblerTests
+#include <boost/test/unit_test.hpp>
+namespace ut = boost::unit_test;
+
+#include <deflect/Frame.h>
+#include <deflect/FrameAssembler.h>
+#include <deflect/ImageSegmenter.h>
+#include <deflect/ImageWrapper.h>
+#include <deflect/Segment.h>
+
+namespace
+{
+const unsigned int segmentSize = 8;
+
+std::vector<char> makeTestImage(const unsigned int width,
+                                const unsigned int height)
+{
+    std::vector<char> data;
+    data.reserve(width * height * 4);
+    for (size_t i = 0; i < width * height; ++i)
+    {
+        data.push_back(92); // R
+        data.push_back(28); // G
+        data.push_back(0);  // B
+        data.push_back(-1); // A
+    }
+    return data;
+}
+
+deflect::Frame makeFrame(const deflect::ImageWrapper& image)
+{
+    deflect::ImageSegmenter segmenter;
+    segmenter.setNominalSegmentDimensions(segmentSize, segmentSize);
+
+    deflect::Frame frame;
+    segmenter.generate(image, [&frame](const deflect::Segment& segment) {
+        frame.segments.push_back(segment);
+        return true;
+    });
+    return frame;
+}
+}
+
+BOOST_AUTO_TEST_CASE(testAssembleCompressedFrame)
+{
+    const auto data = makeTestImage(24, 16);
+    deflect::ImageWrapper image(data.data(), 24, 16, deflect::RGBA);
+    image.compressionQuality = 100;
+
+    const auto frame = makeFrame(image);
+    BOOST_REQUIRE_EQUAL(frame.segments.size(), 6);
+    BOOST_REQUIRE(frame.segments[0].parameters.dataType ==
+                  deflect::DataType::jpeg);
+
+    deflect::FrameAssembler assembler;
+    const auto assembled = assembler.assemble(frame);
+    BOOST_REQUIRE_EQUAL(assembled.width, 24);
+    BOOST_REQUIRE_EQUAL(assembled.height, 16);
+
+    const auto dataOut = static_cast<const char*>(assembled.data);
+    BOOST_CHECK_EQUAL_COLLECTIONS(data.data(), data.data() + data.size(),
+                                  dataOut, dataOut + data.size());
+}
+
+BOOST_AUTO_TEST_CASE(testAssembleIntoBufferWithPitch)
+{
+    const auto data = makeTestImage(16, 16);
+    deflect::ImageWrapper image(data.data(), 16, 16, deflect::RGBA);
+    image.compressionPolicy = deflect::COMPRESSION_OFF;
+
+    const auto frame = makeFrame(image);
+    BOOST_REQUIRE_EQUAL(frame.segments.size(), 4);
+
+    const size_t pitch = 20 * 4;
+    std::vector<char> buffer(pitch * 16, 0);
+
+    deflect::FrameAssembler assembler;
+    assembler.assemble(frame, buffer.data(), pitch);
+
+    for (size_t y = 0; y < 16; ++y)
+    {
+        const auto line = buffer.data() + y * pitch;
+        const auto expected = data.data() + y * 16 * 4;
+        BOOST_CHECK_EQUAL_COLLECTIONS(expected, expected + 16 * 4, line,
+                                      line + 16 * 4);
+        BOOST_CHECK_EQUAL(line[16 * 4], 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(testAssembleSideBySideViews)
+{
+    const auto data = makeTestImage(32, 8);
+    deflect::ImageWrapper image(data.data(), 32, 8, deflect::RGBA);
+    image.compressionPolicy = deflect::COMPRESSION_OFF;
+    image.view = deflect::View::side_by_side;
+
+    const auto frame = makeFrame(image);
+    BOOST_REQUIRE_EQUAL(frame.segments.size(), 4);
+
+    const auto left =
+        deflect::FrameAssembler::getDimensions(frame, deflect::View::left_eye);
+    BOOST_CHECK(left == QSize(16, 8));
+    const auto mono = deflect::FrameAssembler::getDimensions(frame);
+    BOOST_CHECK(mono.isEmpty());
+
+    deflect::FrameAssembler assembler;
+    const auto assembled =
+        assembler.assemble(frame, deflect::View::side_by_side);
+    BOOST_REQUIRE_EQUAL(assembled.width, 32);
+    BOOST_REQUIRE_EQUAL(assembled.height, 8);
+
+    const auto dataOut = static_cast<const char*>(assembled.data);
+    BOOST_CHECK_EQUAL_COLLECTIONS(data.data(), data.data() + data.size(),
+                                  dataOut, dataOut + data.size());
+}
+
+BOOST_AUTO_TEST_CASE(testAssembleRejectsInvalidFormats)
+{
+    const auto data = makeTestImage(8, 8);
+    deflect::ImageWrapper image(data.data(), 8, 8, deflect::RGBA);
+    image.compressionPolicy = deflect::COMPRESSION_OFF;
+
+    auto frame = makeFrame(image);
+    deflect::FrameAssembler assembler;
+    BOOST_CHECK_THROW(assembler.assemble(frame, deflect::View::mono,
+                                         deflect::BGRA),
+                      std::invalid_argument);
+
+    frame.segments[0].parameters.dataType = deflect::DataType::yuv420;
+    BOOST_CHECK_THROW(assembler.assemble(frame), std::invalid_argument);
+}
@@ -0,0 +1,175 @@
+/*********************************************************************/
+/* Copyright (c) 2017, EPFL/Blue Brain Project                       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#define BOOST_TEST_MODULE FramePoolTests
+#include <boost/test/unit_test.hpp>
+namespace ut = boost::unit_test;
+
+#include <deflect/Frame.h>
+#include <deflect/FramePool.h>
+#include <deflect/Segment.h>
+
+namespace
+{
+const int bufferSize = 1024;
+
+deflect::Segments makeSegments(deflect::FramePool& pool, const size_t count)
+{
+    deflect::Segments segments(count);
+    for (auto& segment : segments)
+        segment.imageData = pool.takeBuffer(bufferSize);
+    return segments;
+}
+}
+
+BOOST_AUTO_TEST_CASE(testBuffersAreReused)
+{
+    auto pool = deflect::FramePool::create();
+    BOOST_CHECK_EQUAL(pool->getBufferCount(), 0u);
+
+    auto segments = makeSegments(*pool, 2);
+    const auto data = segments[0].imageData.constData();
+    BOOST_CHECK_EQUAL(segments[0].imageData.size(), bufferSize);
+
+    pool->recycle(segments);
+    BOOST_CHECK(segments.empty());
+    BOOST_CHECK_EQUAL(pool->getBufferCount(), 2u);
+
+    // Buffers are reused even if a smaller size is requested
+    const auto buffer = pool->takeBuffer(bufferSize / 2);
+    BOOST_CHECK_EQUAL(buffer.size(), bufferSize / 2);
+    BOOST_CHECK_EQUAL(pool->getBufferCount(), 1u);
+    const auto otherBuffer = pool->takeBuffer(bufferSize);
+    BOOST_CHECK_EQUAL(pool->getBufferCount(), 0u);
+    BOOST_CHECK(buffer.constData() == data ||
+                otherBuffer.constData() == data);
+}
+
+BOOST_AUTO_TEST_CASE(testSmallestFittingBufferIsReused)
+{
+    auto pool = deflect::FramePool::create();
+
+    deflect::Segments segments(3);
+    segments[0].imageData = pool->takeBuffer(bufferSize / 4);
+    segments[1].imageData = pool->takeBuffer(bufferSize);
+    segments[2].imageData = pool->takeBuffer(bufferSize * 4);
+    const auto small = segments[0].imageData.constData();
+    const auto medium = segments[1].imageData.constData();
+    const auto large = segments[2].imageData.constData();
+    pool->recycle(segments);
+    BOOST_CHECK_EQUAL(pool->getBufferedBytes(), size_t(bufferSize * 21 / 4));
+
+    const auto buffer = pool->takeBuffer(bufferSize / 2);
+    BOOST_CHECK(buffer.constData() == medium);
+    const auto otherBuffer = pool->takeBuffer(bufferSize / 2);
+    BOOST_CHECK(otherBuffer.constData() == large);
+    BOOST_CHECK_EQUAL(pool->getBufferCount(), 1u);
+
+    // The remaining buffer is too small, a new one is allocated
+    const auto newBuffer = pool->takeBuffer(bufferSize);
+    BOOST_CHECK(newBuffer.constData() != small);
+    BOOST_CHECK_EQUAL(newBuffer.size(), bufferSize);
+    BOOST_CHECK_EQUAL(pool->getBufferCount(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(testBufferedBytesAreBounded)
+{
+    auto pool = deflect::FramePool::create();
+    pool->setMaxBufferedBytes(bufferSize * 5 / 2);
+
+    auto segments = makeSegments(*pool, 3);
+    pool->recycle(segments);
+    BOOST_CHECK_EQUAL(pool->getBufferCount(), 2u);
+    BOOST_CHECK_EQUAL(pool->getBufferedBytes(), 2u * bufferSize);
+
+    pool->setMaxBufferedBytes(bufferSize);
+    BOOST_CHECK_EQUAL(pool->getBufferCount(), 1u);
+    BOOST_CHECK_EQUAL(pool->getBufferedBytes(), size_t(bufferSize));
+}
+
+BOOST_AUTO_TEST_CASE(testSharedBuffersAreNotReused)
+{
+    auto pool = deflect::FramePool::create();
+
+    auto segments = makeSegments(*pool, 1);
+    const auto copy = segments[0].imageData;
+
+    pool->recycle(segments);
+    BOOST_CHECK_EQUAL(pool->getBufferCount(), 0u);
+    BOOST_CHECK_EQUAL(copy.size(), bufferSize);
+}
+
+BOOST_AUTO_TEST_CASE(testReleasedFramesAreRecycled)
+{
+    auto pool = deflect::FramePool::create();
+
+    auto frame = pool->makeFrame();
+    const auto address = frame.get();
+    frame->uri = "test";
+    frame->id = 42;
+    frame->timestamps.captured = 1;
+    frame->timestamps.dispatched = 2;
+    frame->cursor.visible = true;
+    frame->cursor.position = QPoint(3, 4);
+    frame->segments = makeSegments(*pool, 4);
+
+    frame.reset();
+    BOOST_CHECK_EQUAL(pool->getBufferCount(), 4u);
+
+    frame = pool->makeFrame();
+    BOOST_CHECK_EQUAL(frame.get(), address);
+    BOOST_CHECK(frame->uri.isEmpty());
+    BOOST_CHECK_EQUAL(frame->id, 0u);
+    BOOST_CHECK_EQUAL(frame->timestamps.captured, 0);
+    BOOST_CHECK_EQUAL(frame->timestamps.dispatched, 0);
+    BOOST_CHECK(!frame->cursor.visible);
+    BOOST_CHECK(frame->cursor.position.isNull());
+    BOOST_CHECK(frame->segments.empty());
+    BOOST_CHECK_GE(frame->segments.capacity(), 4u);
+}
+
+BOOST_AUTO_TEST_CASE(testFramesOutliveThePool)
+{
+    auto pool = deflect::FramePool::create();
+    auto frame = pool->makeFrame();
+    frame->segments = makeSegments(*pool, 1);
+
+    pool.reset();
+    BOOST_CHECK_EQUAL(frame->segments[0].imageData.size(), bufferSize);
+    frame.reset();
+}
@@ -0,0 +1,155 @@
+/*********************************************************************/
+/* Copyright (c) 2017, EPFL/Blue Brain Project                       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#define BOOST_TEST_MODULE FrameTests
+#include <boost/test/unit_test.hpp>
+namespace ut = boost::unit_test;
+
+#include <deflect/Frame.h>
+#include <deflect/Segment.h>
+
+namespace
+{
+const unsigned int segmentSize = 64;
+const unsigned int countX = 8;
+const unsigned int countY = 4;
+
+deflect::FramePtr makeTiledFrame()
+{
+    auto frame = std::make_shared<deflect::Frame>();
+    for (unsigned int y = 0; y < countY; ++y)
+    {
+        for (unsigned int x = 0; x < countX; ++x)
+        {
+            deflect::Segment segment;
+            segment.parameters.x = x * segmentSize;
+            segment.parameters.y = y * segmentSize;
+            segment.parameters.width = segmentSize;
+            segment.parameters.height = segmentSize;
+            frame->segments.push_back(segment);
+        }
+    }
+    return frame;
+}
+}
+
+BOOST_AUTO_TEST_CASE(testSegmentsIntersectingRegion)
+{
+    auto frame = makeTiledFrame();
+    const deflect::Frame& constFrame = *frame;
+
+    // Region covering two segments on the first row
+    auto segments = constFrame.segmentsIntersecting(QRect(10, 10, 100, 20));
+    BOOST_REQUIRE_EQUAL(segments.size(), 2);
+    BOOST_CHECK_EQUAL(segments[0], &frame->segments[0]);
+    BOOST_CHECK_EQUAL(segments[1], &frame->segments[1]);
+
+    // Region in the middle touching four segments
+    segments = constFrame.segmentsIntersecting(QRect(127, 63, 2, 2));
+    BOOST_REQUIRE_EQUAL(segments.size(), 4);
+    BOOST_CHECK_EQUAL(segments[0], &frame->segments[1]);
+    BOOST_CHECK_EQUAL(segments[1], &frame->segments[2]);
+    BOOST_CHECK_EQUAL(segments[2], &frame->segments[countX + 1]);
+    BOOST_CHECK_EQUAL(segments[3], &frame->segments[countX + 2]);
+
+    // Whole frame, partially outside
+    segments = constFrame.segmentsIntersecting(QRect(-10, -10, 2000, 2000));
+    BOOST_CHECK_EQUAL(segments.size(), countX * countY);
+
+    // Outside of the frame
+    segments = constFrame.segmentsIntersecting(QRect(600, 0, 100, 100));
+    BOOST_CHECK(segments.empty());
+    BOOST_CHECK(constFrame.segmentsIntersecting(QRect()).empty());
+}
+
+BOOST_AUTO_TEST_CASE(testSegmentIndexIsUpdated)
+{
+    auto frame = makeTiledFrame();
+    const QRect region(520, 0, 100, 100);
+    BOOST_CHECK(frame->segmentsIntersecting(region).empty());
+
+    deflect::Segment segment;
+    segment.parameters.x = countX * segmentSize;
+    segment.parameters.width = segmentSize;
+    segment.parameters.height = segmentSize;
+    frame->segments.push_back(segment);
+    BOOST_CHECK_EQUAL(frame->segmentsIntersecting(region).size(), 1);
+
+    frame->segments.back().parameters.y = 200;
+    frame->invalidateIndex();
+    BOOST_CHECK(frame->segmentsIntersecting(region).empty());
+}
+
+BOOST_AUTO_TEST_CASE(testSegmentIndexAfterClearAndRefill)
+{
+    auto frame = makeTiledFrame();
+    const QRect region(0, 0, 10, 10);
+    BOOST_REQUIRE_EQUAL(frame->segmentsIntersecting(region).size(), 1);
+
+    // Same number of segments in the same storage, shifted by one column
+    const auto count = frame->segments.size();
+    frame->segments.clear();
+    for (size_t i = 0; i < count; ++i)
+    {
+        deflect::Segment segment;
+        segment.parameters.x = (i % countX + 1) * segmentSize;
+        segment.parameters.y = (i / countX) * segmentSize;
+        segment.parameters.width = segmentSize;
+        segment.parameters.height = segmentSize;
+        frame->segments.push_back(segment);
+    }
+    frame->invalidateIndex();
+
+    BOOST_CHECK(frame->segmentsIntersecting(region).empty());
+    const auto segments =
+        frame->segmentsIntersecting(QRect(countX * segmentSize, 0, 10, 10));
+    BOOST_REQUIRE_EQUAL(segments.size(), 1);
+    BOOST_CHECK_EQUAL(segments[0], &frame->segments[countX - 1]);
+}
+
+BOOST_AUTO_TEST_CASE(testSubFrameReferencesSegments)
+{
+    auto frame = makeTiledFrame();
+    const QRect region(0, 64, 64, 64);
+
+    const deflect::SubFrame subFrame(frame, region);
+    BOOST_CHECK_EQUAL(subFrame.frame, frame);
+    BOOST_CHECK(subFrame.region == region);
+    BOOST_REQUIRE_EQUAL(subFrame.segments.size(), 1);
+    BOOST_CHECK_EQUAL(subFrame.segments[0], &frame->segments[countX]);
+}
@@ -0,0 +1,151 @@
+/*********************************************************************/
+/* Copyright (c) 2017, EPFL/Blue Brain Project                       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+
+#define BOOST_TEST_MODULE ImageHandoffTests
+#include <boost/test/unit_test.hpp>
+namespace ut = boost::unit_test;
+
+#include "MinimalGlobalQtApp.h"
+
+#include <deflect/qt/ImageHandoff.h>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+
+#include <future>
+#include <vector>
+
+namespace
+{
+using deflect::qt::ImageHandoff;
+
+ImageHandoff::Image makeImage(const char value)
+{
+    return {QByteArray(4 * 4 * 4, value), QSize(4, 4), deflect::RGBA};
+}
+
+// Record the images to send and let the test decide when they are sent
+struct Sender
+{
+    ImageHandoff::Futures send(const ImageHandoff::Image& image,
+                               const ImageHandoff::Image& previous)
+    {
+        sent.push_back(image.pixels[0]);
+        previousSent.push_back(previous.pixels.isEmpty() ? 0
+                                                         : previous.pixels[0]);
+        promises.emplace_back();
+        return {promises.back().get_future().share()};
+    }
+
+    std::vector<char> sent;
+    std::vector<char> previousSent;
+    std::vector<std::promise<bool>> promises;
+};
+
+void processEventsUntil(const Sender& sender, const size_t count)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (sender.sent.size() < count && timer.elapsed() < 5000)
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+}
+}
+
+BOOST_GLOBAL_FIXTURE(MinimalGlobalQtApp);
+
+BOOST_AUTO_TEST_CASE(testIntermediateImagesAreDroppedWhileSending)
+{
+    Sender sender;
+    ImageHandoff handoff([&](const ImageHandoff::Image& image,
+                             const ImageHandoff::Image& previous) {
+        return sender.send(image, previous);
+    });
+
+    handoff.push(makeImage(1));
+    BOOST_REQUIRE_EQUAL(sender.sent.size(), 1);
+
+    // pushing does not wait for the image being sent
+    handoff.push(makeImage(2));
+    handoff.push(makeImage(3));
+    handoff.push(makeImage(4));
+    BOOST_CHECK_EQUAL(sender.sent.size(), 1);
+
+    // only the newest image is sent next, along with the last one sent
+    sender.promises[0].set_value(true);
+    processEventsUntil(sender, 2);
+    BOOST_REQUIRE_EQUAL(sender.sent.size(), 2);
+    BOOST_CHECK_EQUAL(int(sender.sent[1]), 4);
+    BOOST_CHECK_EQUAL(int(sender.previousSent[0]), 0);
+    BOOST_CHECK_EQUAL(int(sender.previousSent[1]), 1);
+
+    // nothing is left to send
+    sender.promises[1].set_value(true);
+    handoff.waitForFinished();
+    QCoreApplication::processEvents();
+    BOOST_CHECK_EQUAL(sender.sent.size(), 2);
+
+    // the next image is sent immediately
+    handoff.push(makeImage(5));
+    BOOST_REQUIRE_EQUAL(sender.sent.size(), 3);
+    BOOST_CHECK_EQUAL(int(sender.previousSent[2]), 4);
+    sender.promises[2].set_value(true);
+}
+
+BOOST_AUTO_TEST_CASE(testNoImageIsSentAfterAFailure)
+{
+    Sender sender;
+    ImageHandoff handoff([&](const ImageHandoff::Image& image,
+                             const ImageHandoff::Image& previous) {
+        return sender.send(image, previous);
+    });
+
+    handoff.push(makeImage(1));
+    handoff.push(makeImage(2));
+    sender.promises[0].set_value(false);
+    handoff.waitForFinished();
+
+    QElapsedTimer timer;
+    timer.start();
+    while (!handoff.hasFailed() && timer.elapsed() < 5000)
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+
+    BOOST_CHECK(handoff.hasFailed());
+    handoff.push(makeImage(3));
+    BOOST_CHECK_EQUAL(sender.sent.size(), 1);
+}
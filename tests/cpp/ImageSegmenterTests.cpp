@@ -323,3 +323,66 @@ BOOST_AUTO_TEST_CASE(testImageSegmenterNonUniformSegmentationData)
                                       dataOut + segment.imageData.size());
     }
 }
+
+BOOST_AUTO_TEST_CASE(testImageSegmenterBottomUpSegmentationData)
+{
+    // clang-format off
+    char dataIn[] =
+    {
+        5,5,5, 6,6,6, 7,7,7, 8,8,8,
+        1,1,1, 2,2,2, 3,3,3, 4,4,4
+    };
+    char dataFlipped[] =
+    {
+        1,1,1, 2,2,2, 3,3,3, 4,4,4,
+        5,5,5, 6,6,6, 7,7,7, 8,8,8
+    };
+    char dataSegmented[2][12] =
+    {
+        {
+        1,1,1, 2,2,2,
+        5,5,5, 6,6,6
+        },
+        {
+        3,3,3, 4,4,4,
+        7,7,7, 8,8,8
+        }
+    };
+    // clang-format on
+
+    deflect::ImageWrapper imageWrapper(dataIn, 4, 2, deflect::RGB);
+    imageWrapper.compressionPolicy = deflect::COMPRESSION_OFF;
+    imageWrapper.rowOrder = deflect::RowOrder::bottom_up;
+
+    deflect::Segments segments;
+    const auto appendFunc =
+        std::bind(&append, std::ref(segments), std::placeholders::_1);
+
+    {
+        deflect::ImageSegmenter segmenter;
+        segmenter.generate(imageWrapper, appendFunc);
+        BOOST_REQUIRE_EQUAL(segments.size(), 1);
+
+        const char* dataOut = segments[0].imageData.constData();
+        BOOST_CHECK_EQUAL_COLLECTIONS(dataFlipped, dataFlipped + 24, dataOut,
+                                      dataOut + segments[0].imageData.size());
+    }
+
+    segments.clear();
+
+    {
+        deflect::ImageSegmenter segmenter;
+        segmenter.setNominalSegmentDimensions(2, 2);
+        segmenter.generate(imageWrapper, appendFunc);
+        BOOST_REQUIRE_EQUAL(segments.size(), 2);
+
+        for (size_t i = 0; i < segments.size(); ++i)
+        {
+            const char* dataOut = segments[i].imageData.constData();
+            BOOST_CHECK_EQUAL_COLLECTIONS(dataSegmented[i],
+                                          dataSegmented[i] + 12, dataOut,
+                                          dataOut +
+                                              segments[i].imageData.size());
+        }
+    }
+}
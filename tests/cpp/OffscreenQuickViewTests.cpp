@@ -0,0 +1,281 @@
+/*********************************************************************/
+/* Copyright (c) 2017, EPFL/Blue Brain Project                       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#define BOOST_TEST_MODULE OffscreenQuickViewTests
+#include <boost/test/unit_test.hpp>
+namespace ut = boost::unit_test;
+
+#include <deflect/qt/OffscreenQuickView.h>
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QGuiApplication>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QQuickRenderControl>
+#include <QTemporaryDir>
+
+#include <stdexcept>
+
+namespace
+{
+const char* redRectangle =
+    "import QtQuick 2.0\n"
+    "Rectangle { width: 4; height: 4; color: \"#ff0000\" }\n";
+const char* rotatingRectangle =
+    "import QtQuick 2.0\n"
+    "Rectangle { width: 4; height: 4; color: \"#ff0000\"\n"
+    "    RotationAnimation on rotation {\n"
+    "        from: 0; to: 360; duration: 1000; loops: Animation.Infinite }\n"
+    "}\n";
+const int timeoutMs = 5000;
+
+// The readback needs an OpenGL context, but no display (e.g. Mesa llvmpipe)
+struct GlobalGuiApp
+{
+    GlobalGuiApp()
+    {
+        if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+
+        ut::master_test_suite_t& testSuite = ut::framework::master_test_suite();
+        app = new QGuiApplication(testSuite.argc, testSuite.argv);
+    }
+    ~GlobalGuiApp() { delete app; }
+    QGuiApplication* app = nullptr;
+};
+
+bool hasOpenGL()
+{
+    QOpenGLContext context;
+    if (!context.create())
+        return false;
+
+    QOffscreenSurface surface;
+    surface.setFormat(context.format());
+    surface.create();
+    return context.makeCurrent(&surface);
+}
+
+QString writeQml(const QTemporaryDir& dir, const char* qml)
+{
+    const auto path = dir.path() + "/test.qml";
+    QFile file(path);
+    file.open(QIODevice::WriteOnly);
+    file.write(qml);
+    return path;
+}
+
+void processEventsFor(const int ms)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < ms)
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+}
+
+using deflect::qt::OffscreenQuickView;
+
+std::unique_ptr<OffscreenQuickView> makeView()
+{
+    return std::unique_ptr<OffscreenQuickView>(new OffscreenQuickView{
+        std::unique_ptr<QQuickRenderControl>(new QQuickRenderControl),
+        deflect::qt::RenderMode::SINGLETHREADED});
+}
+
+// Count the frames rendered by a view
+struct FrameCounter
+{
+    explicit FrameCounter(OffscreenQuickView& view)
+    {
+        QObject::connect(&view, &OffscreenQuickView::afterRender,
+                         [this](const QImage) { ++frames; });
+    }
+    size_t frames = 0;
+};
+}
+
+BOOST_GLOBAL_FIXTURE(GlobalGuiApp);
+
+BOOST_AUTO_TEST_CASE(testAsyncReadbackDeliversLastFrameWhenRenderingStops)
+{
+    if (!hasOpenGL())
+    {
+        BOOST_TEST_MESSAGE("No OpenGL context available, skipping test");
+        return;
+    }
+
+    QTemporaryDir dir;
+    const auto qmlFile = writeQml(dir, redRectangle);
+
+    using deflect::qt::OffscreenQuickView;
+    OffscreenQuickView view{std::unique_ptr<QQuickRenderControl>(
+                                new QQuickRenderControl),
+                            deflect::qt::RenderMode::SINGLETHREADED};
+    view.setAsyncReadback(true);
+
+    // the scene is rendered once, its frame is only read back by the flush
+    view.setIdleTimeout(0);
+
+    std::vector<QByteArray> frames;
+    QSize frameSize;
+    deflect::PixelFormat frameFormat = deflect::RGBA;
+    QObject::connect(&view, &OffscreenQuickView::afterRenderPixels,
+                     [&](const QByteArray pixels, const QSize size,
+                         const deflect::PixelFormat format) {
+                         frames.push_back(pixels);
+                         frameSize = size;
+                         frameFormat = format;
+                     });
+
+    BOOST_REQUIRE(view.load(QUrl::fromLocalFile(qmlFile)).get());
+
+    QElapsedTimer timer;
+    timer.start();
+    while (frames.empty() && timer.elapsed() < timeoutMs)
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+
+    BOOST_REQUIRE(!frames.empty());
+    BOOST_CHECK(frameSize == QSize(4, 4));
+    BOOST_REQUIRE_EQUAL(frames.back().size(), 4 * 4 * 4);
+
+    const auto red = frameFormat == deflect::BGRA
+                         ? QByteArray("\x00\x00\xff\xff", 4)
+                         : QByteArray("\xff\x00\x00\xff", 4);
+    for (int i = 0; i < 4 * 4; ++i)
+        BOOST_CHECK(frames.back().mid(i * 4, 4) == red);
+}
+
+BOOST_AUTO_TEST_CASE(testRenderingSettings)
+{
+    auto view = makeView();
+    BOOST_CHECK_EQUAL(view->getMaxFrameRate(), 200u);
+    BOOST_CHECK_EQUAL(view->getIdleTimeout(), 5000);
+    BOOST_CHECK(!view->isRenderingSuspended());
+
+    view->setMaxFrameRate(30);
+    BOOST_CHECK_EQUAL(view->getMaxFrameRate(), 30u);
+    BOOST_CHECK_THROW(view->setMaxFrameRate(0), std::invalid_argument);
+    BOOST_CHECK_EQUAL(view->getMaxFrameRate(), 30u);
+
+    view->setIdleTimeout(100);
+    BOOST_CHECK_EQUAL(view->getIdleTimeout(), 100);
+    view->setIdleTimeout(-1);
+    BOOST_CHECK_EQUAL(view->getIdleTimeout(), 0);
+
+    view->setRenderingSuspended(true);
+    BOOST_CHECK(view->isRenderingSuspended());
+    view->setRenderingSuspended(false);
+    BOOST_CHECK(!view->isRenderingSuspended());
+}
+
+BOOST_AUTO_TEST_CASE(testMaxFrameRateLimitsRendering)
+{
+    if (!hasOpenGL())
+    {
+        BOOST_TEST_MESSAGE("No OpenGL context available, skipping test");
+        return;
+    }
+
+    QTemporaryDir dir;
+    const auto qmlFile = writeQml(dir, rotatingRectangle);
+
+    auto view = makeView();
+    view->setMaxFrameRate(10);
+    FrameCounter counter(*view);
+    BOOST_REQUIRE(view->load(QUrl::fromLocalFile(qmlFile)).get());
+
+    // the animation changes the scene continuously
+    processEventsFor(1000);
+    BOOST_CHECK_GT(counter.frames, 0u);
+    BOOST_CHECK_LE(counter.frames, 12u);
+}
+
+BOOST_AUTO_TEST_CASE(testRenderingStopsAfterIdleTimeout)
+{
+    if (!hasOpenGL())
+    {
+        BOOST_TEST_MESSAGE("No OpenGL context available, skipping test");
+        return;
+    }
+
+    QTemporaryDir dir;
+    const auto qmlFile = writeQml(dir, redRectangle);
+
+    auto view = makeView();
+    view->setIdleTimeout(100);
+    FrameCounter counter(*view);
+    BOOST_REQUIRE(view->load(QUrl::fromLocalFile(qmlFile)).get());
+
+    processEventsFor(500);
+    const auto frames = counter.frames;
+    BOOST_CHECK_GT(frames, 0u);
+
+    // the static scene is no longer rendered once the timeout has elapsed
+    processEventsFor(500);
+    BOOST_CHECK_EQUAL(counter.frames, frames);
+}
+
+BOOST_AUTO_TEST_CASE(testSuspendedRenderingIsResumed)
+{
+    if (!hasOpenGL())
+    {
+        BOOST_TEST_MESSAGE("No OpenGL context available, skipping test");
+        return;
+    }
+
+    QTemporaryDir dir;
+    const auto qmlFile = writeQml(dir, rotatingRectangle);
+
+    auto view = makeView();
+    FrameCounter counter(*view);
+    BOOST_REQUIRE(view->load(QUrl::fromLocalFile(qmlFile)).get());
+
+    processEventsFor(200);
+    BOOST_CHECK_GT(counter.frames, 0u);
+
+    // the animation keeps changing the scene, but it is not rendered
+    view->setRenderingSuspended(true);
+    const auto frames = counter.frames;
+    processEventsFor(300);
+    BOOST_CHECK_EQUAL(counter.frames, frames);
+
+    view->setRenderingSuspended(false);
+    processEventsFor(300);
+    BOOST_CHECK_GT(counter.frames, frames);
+}
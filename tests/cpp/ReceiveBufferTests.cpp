@@ -75,6 +75,29 @@ BOOST_AUTO_TEST_CASE(TestAddAndRemoveSources)
     BOOST_CHECK_EQUAL(buffer.getSourceCount(), 0);
 }
 
+BOOST_AUTO_TEST_CASE(TestSegmentDataIsMovedNotCopied)
+{
+    const size_t sourceIndex = 46;
+
+    deflect::ReceiveBuffer buffer;
+    buffer.addSource(sourceIndex);
+
+    deflect::Segment segment;
+    segment.parameters.width = 64;
+    segment.parameters.height = 64;
+    segment.imageData = QByteArray(1024, 'x');
+    const auto data = segment.imageData.constData();
+
+    buffer.insert(std::move(segment), sourceIndex);
+    BOOST_CHECK_EQUAL(buffer.getBufferedBytes(), 1024);
+    buffer.finishFrameForSource(sourceIndex);
+
+    const auto segments = buffer.popFrame();
+    BOOST_REQUIRE_EQUAL(segments.size(), 1);
+    BOOST_CHECK(segments[0].imageData.constData() == data);
+    BOOST_CHECK(segments[0].imageData.isDetached());
+}
+
 BOOST_AUTO_TEST_CASE(TestAllowedToSend)
 {
     deflect::ReceiveBuffer buffer;
@@ -310,6 +333,299 @@ BOOST_AUTO_TEST_CASE(TestOneOfTwoSourceStopsSendingSegments)
                       std::runtime_error);
 }
 
+BOOST_AUTO_TEST_CASE(TestStaleFramesAreDropped)
+{
+    const size_t sourceIndex = 46;
+
+    deflect::ReceiveBuffer buffer;
+    buffer.addSource(sourceIndex);
+
+    deflect::Segments testSegments = generateTestSegments();
+    testSegments[0].imageData = QByteArray(1000, 'x');
+
+    // The consumer does not pop frames, only the latest one is kept
+    for (int i = 0; i < 200; ++i)
+    {
+        buffer.insert(testSegments[0], sourceIndex);
+        BOOST_REQUIRE_NO_THROW(buffer.finishFrameForSource(sourceIndex));
+        BOOST_REQUIRE(buffer.hasCompleteFrame());
+        BOOST_REQUIRE_EQUAL(buffer.getBufferedBytes(), 1000);
+    }
+    BOOST_CHECK_EQUAL(buffer.getDroppedFrameCount(), 199);
+
+    // The next incomplete frame is buffered in addition to the complete one
+    buffer.insert(testSegments[0], sourceIndex);
+    BOOST_CHECK_EQUAL(buffer.getBufferedBytes(), 2000);
+
+    const auto segments = buffer.popFrame();
+    BOOST_CHECK_EQUAL(segments.size(), 1);
+    BOOST_CHECK(!buffer.hasCompleteFrame());
+    BOOST_CHECK_EQUAL(buffer.getBufferedBytes(), 1000);
+
+    buffer.removeSource(sourceIndex);
+    BOOST_CHECK_EQUAL(buffer.getBufferedBytes(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(TestMetrics)
+{
+    const size_t sourceIndex1 = 46;
+    const size_t sourceIndex2 = 819;
+
+    deflect::ReceiveBuffer buffer;
+    buffer.addSource(sourceIndex1);
+    buffer.addSource(sourceIndex2);
+
+    deflect::Segments testSegments = generateTestSegments();
+    for (auto& segment : testSegments)
+        segment.imageData = QByteArray(100, 'x');
+
+    for (int i = 0; i < 3; ++i)
+    {
+        buffer.insert(testSegments[0], sourceIndex1);
+        buffer.insert(testSegments[1], sourceIndex1);
+        buffer.insert(testSegments[2], sourceIndex2);
+        buffer.finishFrameForSource(sourceIndex1);
+        buffer.finishFrameForSource(sourceIndex2);
+    }
+    buffer.insert(testSegments[3], sourceIndex2);
+    buffer.finishFrameForSource(sourceIndex2);
+
+    buffer.popFrame();
+    buffer.setAllowedToSend(false);
+    buffer.setAllowedToSend(true);
+
+    const auto metrics = buffer.getMetrics();
+    BOOST_CHECK_EQUAL(metrics.framesReceived, 4);
+    BOOST_CHECK_EQUAL(metrics.framesCompleted, 3);
+    BOOST_CHECK_EQUAL(metrics.framesDropped, 2);
+    BOOST_CHECK_EQUAL(metrics.framesDispatched, 1);
+    BOOST_CHECK_EQUAL(metrics.bytesReceived, 1000);
+    BOOST_CHECK_EQUAL(metrics.bufferedBytes, 100);
+    BOOST_CHECK_EQUAL(metrics.segmentsPerFrame, 3.0);
+    BOOST_CHECK_GE(metrics.completionTimeMs, 0.0);
+    BOOST_CHECK_GE(metrics.requestTimeMs, 0.0);
+
+    BOOST_REQUIRE_EQUAL(metrics.sources.size(), 2);
+    const auto& source1 = metrics.sources[0];
+    BOOST_CHECK_EQUAL(source1.sourceIndex, sourceIndex1);
+    BOOST_CHECK_EQUAL(source1.framesReceived, 3);
+    BOOST_CHECK_EQUAL(source1.segmentsReceived, 6);
+    BOOST_CHECK_EQUAL(source1.bytesReceived, 600);
+    BOOST_CHECK_EQUAL(source1.queueSize, 1);
+    BOOST_CHECK_EQUAL(source1.bufferedBytes, 0);
+    const auto& source2 = metrics.sources[1];
+    BOOST_CHECK_EQUAL(source2.sourceIndex, sourceIndex2);
+    BOOST_CHECK_EQUAL(source2.framesReceived, 4);
+    BOOST_CHECK_EQUAL(source2.queueSize, 2);
+    BOOST_CHECK_EQUAL(source2.bufferedBytes, 100);
+    BOOST_CHECK_EQUAL(metrics.queueSize, 2);
+}
+
+BOOST_AUTO_TEST_CASE(TestMetricsIgnoreDroppedFrames)
+{
+    const size_t sourceIndex = 46;
+
+    deflect::ReceiveBuffer buffer;
+    buffer.addSource(sourceIndex);
+
+    const deflect::Segments testSegments = generateTestSegments();
+
+    // Two frames of one segment are dropped in favour of one of four segments
+    for (int i = 0; i < 2; ++i)
+    {
+        buffer.insert(testSegments[0], sourceIndex);
+        buffer.finishFrameForSource(sourceIndex);
+    }
+    for (const auto& segment : testSegments)
+        buffer.insert(segment, sourceIndex);
+    buffer.finishFrameForSource(sourceIndex);
+
+    BOOST_REQUIRE_EQUAL(buffer.popFrame().size(), 4);
+
+    const auto metrics = buffer.getMetrics();
+    BOOST_CHECK_EQUAL(metrics.framesCompleted, 3);
+    BOOST_CHECK_EQUAL(metrics.framesDropped, 2);
+    BOOST_CHECK_EQUAL(metrics.segmentsPerFrame, 4.0);
+}
+
+BOOST_AUTO_TEST_CASE(TestFrameIdAndTimestamps)
+{
+    const size_t sourceIndex1 = 46;
+    const size_t sourceIndex2 = 819;
+
+    deflect::ReceiveBuffer buffer;
+    buffer.addSource(sourceIndex1);
+    buffer.addSource(sourceIndex2);
+
+    const deflect::Segments testSegments = generateTestSegments();
+
+    deflect::FrameTimestamps timestamps1;
+    timestamps1.captured = 100;
+    timestamps1.sent = 250;
+    deflect::FrameTimestamps timestamps2;
+    timestamps2.captured = 150;
+    timestamps2.sent = 200;
+    timestamps2.received = 300;
+
+    buffer.insert(testSegments[0], sourceIndex1);
+    buffer.insert(testSegments[1], sourceIndex2);
+    buffer.finishFrameForSource(sourceIndex1, 7, timestamps1);
+    buffer.finishFrameForSource(sourceIndex2, 7, timestamps2);
+    BOOST_REQUIRE(buffer.hasCompleteFrame());
+
+    deflect::Frame frame;
+    buffer.popFrame(frame);
+    BOOST_CHECK_EQUAL(frame.segments.size(), 2);
+    BOOST_CHECK_EQUAL(frame.id, 7);
+
+    // The earliest capture and send times of all the sources are kept
+    BOOST_CHECK_EQUAL(frame.timestamps.captured, 100);
+    BOOST_CHECK_EQUAL(frame.timestamps.sent, 200);
+    // The first segment was received by the server before the buffer got it
+    BOOST_CHECK_EQUAL(frame.timestamps.received, 300);
+    BOOST_CHECK(frame.timestamps.completed >= frame.timestamps.received);
+    BOOST_CHECK_EQUAL(frame.timestamps.dispatched, 0);
+}
+
+BOOST_AUTO_TEST_CASE(TestDeadlineSynchronizationReusesLateSegments)
+{
+    const size_t sourceIndex1 = 46;
+    const size_t sourceIndex2 = 819;
+
+    deflect::ReceiveBuffer buffer;
+    buffer.setSynchronization(deflect::SourceSynchronization::deadline);
+    buffer.setDeadline(0);
+    buffer.addSource(sourceIndex1);
+    buffer.addSource(sourceIndex2);
+
+    const deflect::Segments testSegments = generateTestSegments();
+
+    buffer.insert(testSegments[0], sourceIndex1);
+    buffer.insert(testSegments[1], sourceIndex2);
+    buffer.finishFrameForSource(sourceIndex1);
+    buffer.finishFrameForSource(sourceIndex2);
+    BOOST_REQUIRE(buffer.hasCompleteFrame());
+    BOOST_CHECK_EQUAL(buffer.popFrame().size(), 2);
+
+    // The second source is late, its previous segment completes the frame
+    buffer.insert(testSegments[2], sourceIndex1);
+    buffer.finishFrameForSource(sourceIndex1);
+    BOOST_REQUIRE(buffer.hasCompleteFrame());
+    BOOST_REQUIRE_EQUAL(buffer.getLateSources().size(), 1);
+    BOOST_CHECK_EQUAL(buffer.getLateSources()[0], sourceIndex2);
+
+    auto segments = buffer.popFrame();
+    BOOST_REQUIRE_EQUAL(segments.size(), 2);
+    BOOST_CHECK_EQUAL(segments[0].parameters.y, 256);
+    BOOST_CHECK_EQUAL(segments[1].parameters.y, 0);
+
+    // The late frame does not complete a new frame, but catches up
+    buffer.insert(testSegments[3], sourceIndex2);
+    buffer.finishFrameForSource(sourceIndex2);
+    BOOST_CHECK(!buffer.hasCompleteFrame());
+    BOOST_CHECK(buffer.getLateSources().empty());
+
+    buffer.insert(testSegments[2], sourceIndex1);
+    buffer.insert(testSegments[3], sourceIndex2);
+    buffer.finishFrameForSource(sourceIndex1);
+    buffer.finishFrameForSource(sourceIndex2);
+    BOOST_REQUIRE(buffer.hasCompleteFrame());
+    BOOST_CHECK(buffer.getLateSources().empty());
+    segments = buffer.popFrame();
+    BOOST_REQUIRE_EQUAL(segments.size(), 2);
+    BOOST_CHECK_EQUAL(segments[1].parameters.y, 256);
+
+    const auto metrics = buffer.getMetrics();
+    BOOST_REQUIRE_EQUAL(metrics.sources.size(), 2);
+    BOOST_CHECK_EQUAL(metrics.sources[0].framesLate, 0);
+    BOOST_CHECK_EQUAL(metrics.sources[1].framesLate, 1);
+}
+
+BOOST_AUTO_TEST_CASE(TestDeadlineSynchronizationWaitsForLateSources)
+{
+    const size_t sourceIndex1 = 46;
+    const size_t sourceIndex2 = 819;
+
+    deflect::ReceiveBuffer buffer;
+    buffer.setSynchronization(deflect::SourceSynchronization::deadline);
+    buffer.setDeadline(60000);
+    buffer.addSource(sourceIndex1);
+    buffer.addSource(sourceIndex2);
+
+    const deflect::Segments testSegments = generateTestSegments();
+
+    buffer.insert(testSegments[0], sourceIndex1);
+    buffer.finishFrameForSource(sourceIndex1);
+    BOOST_CHECK(!buffer.hasCompleteFrame());
+    BOOST_CHECK_EQUAL(buffer.getLateSources().size(), 1);
+
+    buffer.insert(testSegments[1], sourceIndex2);
+    buffer.finishFrameForSource(sourceIndex2);
+    BOOST_CHECK(buffer.hasCompleteFrame());
+}
+
+BOOST_AUTO_TEST_CASE(TestIndependentSynchronization)
+{
+    const size_t sourceIndex1 = 46;
+    const size_t sourceIndex2 = 819;
+
+    deflect::ReceiveBuffer buffer;
+    buffer.setSynchronization(deflect::SourceSynchronization::independent);
+    buffer.addSource(sourceIndex1);
+    buffer.addSource(sourceIndex2);
+
+    const deflect::Segments testSegments = generateTestSegments();
+
+    buffer.insert(testSegments[0], sourceIndex1);
+    buffer.finishFrameForSource(sourceIndex1);
+    BOOST_REQUIRE(buffer.hasCompleteFrame());
+    BOOST_CHECK_EQUAL(buffer.popFrame().size(), 1);
+    BOOST_CHECK(!buffer.hasCompleteFrame());
+
+    // The latest frame of the first source is combined with the new one
+    buffer.insert(testSegments[1], sourceIndex2);
+    buffer.finishFrameForSource(sourceIndex2);
+    BOOST_REQUIRE(buffer.hasCompleteFrame());
+    BOOST_CHECK_EQUAL(buffer.popFrame().size(), 2);
+
+    // Only the latest frame of each source is kept
+    buffer.insert(testSegments[0], sourceIndex1);
+    buffer.finishFrameForSource(sourceIndex1);
+    buffer.insert(testSegments[2], sourceIndex1);
+    buffer.finishFrameForSource(sourceIndex1);
+    BOOST_CHECK_EQUAL(buffer.getDroppedFrameCount(), 1);
+
+    const auto segments = buffer.popFrame();
+    BOOST_REQUIRE_EQUAL(segments.size(), 2);
+    BOOST_CHECK_EQUAL(segments[0].parameters.y, 256);
+    BOOST_CHECK_EQUAL(segments[1].parameters.x, 128);
+}
+
+BOOST_AUTO_TEST_CASE(TestBufferExceedsMaximumBytes)
+{
+    const size_t sourceIndex1 = 46;
+    const size_t sourceIndex2 = 819;
+
+    deflect::ReceiveBuffer buffer;
+    buffer.addSource(sourceIndex1);
+    buffer.addSource(sourceIndex2);
+    buffer.setMaxBufferedBytes(4500);
+
+    deflect::Segments testSegments = generateTestSegments();
+    testSegments[0].imageData = QByteArray(1000, 'x');
+
+    // One source stops sending segments
+    for (int i = 0; i < 4; ++i)
+    {
+        buffer.insert(testSegments[0], sourceIndex1);
+        BOOST_REQUIRE_NO_THROW(buffer.finishFrameForSource(sourceIndex1));
+        BOOST_REQUIRE(!buffer.hasCompleteFrame());
+    }
+    buffer.insert(testSegments[0], sourceIndex1);
+    BOOST_CHECK_THROW(buffer.finishFrameForSource(sourceIndex1),
+                      std::runtime_error);
+}
+
 void _insert(deflect::ReceiveBuffer& buffer, const size_t sourceIndex,
              const deflect::Segments& frame)
 {
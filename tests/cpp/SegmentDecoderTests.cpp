@@ -41,6 +41,7 @@
 #include <boost/test/unit_test.hpp>
 namespace ut = boost::unit_test;
 
+#include <deflect/Frame.h>
 #include <deflect/ImageJpegCompressor.h>
 #include <deflect/ImageJpegDecompressor.h>
 #include <deflect/ImageSegmenter.h>
@@ -232,6 +233,89 @@ BOOST_AUTO_TEST_CASE(testImageCompressionAndDecompressionYUV)
 
 #endif
 
+deflect::Segment makeJpegTestSegment(const deflect::ChromaSubsampling subsamp)
+{
+    const auto data = makeTestImage();
+    deflect::ImageWrapper imageWrapper(data.data(), 8, 8, deflect::RGBA);
+    imageWrapper.compressionQuality = 100;
+    imageWrapper.subsampling = subsamp;
+
+    deflect::Segment segment;
+    segment.parameters.width = 8;
+    segment.parameters.height = 8;
+    segment.parameters.dataType = deflect::DataType::jpeg;
+    deflect::ImageJpegCompressor compressor;
+    segment.imageData = compressor.computeJpeg(imageWrapper, QRect(0, 0, 8, 8));
+    return segment;
+}
+
+BOOST_AUTO_TEST_CASE(testDecompressionToBufferWithPitch)
+{
+    const auto segment =
+        makeJpegTestSegment(deflect::ChromaSubsampling::YUV444);
+
+    const size_t pitch = 8 * 3 + 5;
+    std::vector<char> buffer(pitch * 8, 7);
+
+    deflect::SegmentDecoder decoder;
+    decoder.decode(segment, buffer.data(), pitch, deflect::BGR);
+    BOOST_CHECK(segment.parameters.dataType == deflect::DataType::jpeg);
+
+    for (size_t y = 0; y < 8; ++y)
+    {
+        const char* line = buffer.data() + y * pitch;
+        for (size_t x = 0; x < 8; ++x)
+        {
+            BOOST_CHECK_EQUAL(line[x * 3 + 0], 0);  // B
+            BOOST_CHECK_EQUAL(line[x * 3 + 1], 28); // G
+            BOOST_CHECK_EQUAL(line[x * 3 + 2], 92); // R
+        }
+        // padding is untouched
+        for (size_t x = 8 * 3; x < pitch; ++x)
+            BOOST_CHECK_EQUAL(line[x], 7);
+    }
+
+    BOOST_CHECK_THROW(decoder.decode(segment, buffer.data(), 8,
+                                     deflect::BGR),
+                      std::invalid_argument);
+
+    auto wrongSize = segment;
+    wrongSize.parameters.width = 16;
+    BOOST_CHECK_THROW(decoder.decode(wrongSize, buffer.data(), 0,
+                                     deflect::BGR),
+                      std::runtime_error);
+}
+
+#ifndef DEFLECT_USE_LEGACY_LIBJPEGTURBO
+
+BOOST_AUTO_TEST_CASE(testDecompressionToYUVPlanes)
+{
+    const auto segment =
+        makeJpegTestSegment(deflect::ChromaSubsampling::YUV420);
+
+    std::vector<char> y(8 * 8);
+    std::vector<char> u(4 * 4);
+    std::vector<char> v(4 * 4);
+    unsigned char* planes[3] = {(unsigned char*)y.data(),
+                                (unsigned char*)u.data(),
+                                (unsigned char*)v.data()};
+    const int strides[3] = {0, 0, 0};
+
+    deflect::SegmentDecoder decoder;
+    BOOST_CHECK_EQUAL(decoder.decodeType(segment),
+                      deflect::ChromaSubsampling::YUV420);
+    decoder.decodeToYUV(segment, planes, strides);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(y.begin(), y.end(), expectedYData.begin(),
+                                  expectedYData.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(u.begin(), u.end(), expectedUData.begin(),
+                                  expectedUData.begin() + u.size());
+    BOOST_CHECK_EQUAL_COLLECTIONS(v.begin(), v.end(), expectedVData.begin(),
+                                  expectedVData.begin() + v.size());
+}
+
+#endif
+
 static bool append(deflect::Segments& segments, const deflect::Segment& segment)
 {
     static QMutex lock;
@@ -240,6 +324,157 @@ static bool append(deflect::Segments& segments, const deflect::Segment& segment)
     return true;
 }
 
+BOOST_AUTO_TEST_CASE(testScaledDecompression)
+{
+    auto segment = makeJpegTestSegment(deflect::ChromaSubsampling::YUV444);
+    segment.parameters.x = 16;
+    segment.parameters.y = 8;
+
+    deflect::SegmentDecoder decoder;
+    auto invalidScale = segment;
+    BOOST_CHECK_THROW(decoder.decode(invalidScale, 3), std::invalid_argument);
+    BOOST_CHECK_EQUAL(invalidScale.parameters.dataType,
+                      deflect::DataType::jpeg);
+
+    decoder.decode(segment, 2);
+    BOOST_CHECK_EQUAL(segment.parameters.dataType, deflect::DataType::rgba);
+    BOOST_CHECK_EQUAL(segment.parameters.x, 8);
+    BOOST_CHECK_EQUAL(segment.parameters.y, 4);
+    BOOST_CHECK_EQUAL(segment.parameters.width, 4);
+    BOOST_CHECK_EQUAL(segment.parameters.height, 4);
+    BOOST_REQUIRE_EQUAL(segment.imageData.size(), 4 * 4 * 4);
+
+    const auto expected = makeTestImage();
+    const char* dataOut = segment.imageData.constData();
+    BOOST_CHECK_EQUAL_COLLECTIONS(expected.data(),
+                                  expected.data() + segment.imageData.size(),
+                                  dataOut, dataOut + segment.imageData.size());
+}
+
+#ifndef DEFLECT_USE_LEGACY_LIBJPEGTURBO
+
+BOOST_AUTO_TEST_CASE(testScaledDecompressionToYUV)
+{
+    auto segment = makeJpegTestSegment(deflect::ChromaSubsampling::YUV420);
+
+    deflect::SegmentDecoder decoder;
+    decoder.decodeToYUV(segment, 8);
+    BOOST_CHECK_EQUAL(segment.parameters.dataType, deflect::DataType::yuv420);
+    BOOST_CHECK_EQUAL(segment.parameters.width, 1);
+    BOOST_CHECK_EQUAL(segment.parameters.height, 1);
+    BOOST_CHECK_EQUAL(segment.imageData.size(), 3);
+}
+
+#endif
+
+
+deflect::FramePtr makeJpegTestFrame(const deflect::ChromaSubsampling sub)
+{
+    // 30x30 image in 10x10 segments, not aligned on the scale factors
+    static const std::vector<char> data(30 * 30 * 4, 42);
+    deflect::ImageWrapper imageWrapper(data.data(), 30, 30, deflect::RGBA);
+    imageWrapper.compressionPolicy = deflect::COMPRESSION_ON;
+    imageWrapper.subsampling = sub;
+
+    auto frame = std::make_shared<deflect::Frame>();
+    deflect::ImageSegmenter segmenter;
+    segmenter.setNominalSegmentDimensions(10, 10);
+    segmenter.generate(imageWrapper, std::bind(&append,
+                                               std::ref(frame->segments),
+                                               std::placeholders::_1));
+    return frame;
+}
+
+QRect toRect(const deflect::SegmentParameters& params)
+{
+    return QRect(params.x, params.y, params.width, params.height);
+}
+
+void checkSegmentsTileTheFrame(const deflect::Frame& frame, const QSize size)
+{
+    BOOST_CHECK(frame.computeDimensions() == size);
+
+    int area = 0;
+    for (size_t i = 0; i < frame.segments.size(); ++i)
+    {
+        const auto rect = toRect(frame.segments[i].parameters);
+        area += rect.width() * rect.height();
+        for (size_t j = i + 1; j < frame.segments.size(); ++j)
+            BOOST_CHECK(!rect.intersects(toRect(frame.segments[j].parameters)));
+    }
+    BOOST_CHECK_EQUAL(area, size.width() * size.height());
+}
+
+BOOST_AUTO_TEST_CASE(testScaledFrameSegmentsTileTheScaledFrame)
+{
+    auto frame = makeJpegTestFrame(deflect::ChromaSubsampling::YUV444);
+    BOOST_REQUIRE_EQUAL(frame->segments.size(), 9);
+
+    deflect::SegmentDecoder decoder;
+    decoder.decode(*frame, 4);
+
+    checkSegmentsTileTheFrame(*frame, QSize(8, 8));
+    for (const auto& segment : frame->segments)
+    {
+        const auto& params = segment.parameters;
+        BOOST_CHECK_EQUAL(params.dataType, deflect::DataType::rgba);
+        BOOST_CHECK_EQUAL(segment.imageData.size(),
+                          int(params.width * params.height * 4));
+    }
+}
+
+#ifndef DEFLECT_USE_LEGACY_LIBJPEGTURBO
+
+BOOST_AUTO_TEST_CASE(testScaledFrameSegmentsTileTheScaledFrameInYUV)
+{
+    auto frame = makeJpegTestFrame(deflect::ChromaSubsampling::YUV420);
+    BOOST_REQUIRE_EQUAL(frame->segments.size(), 9);
+
+    deflect::SegmentDecoder decoder;
+    decoder.decodeToYUV(*frame, 4);
+
+    checkSegmentsTileTheFrame(*frame, QSize(8, 8));
+    for (const auto& segment : frame->segments)
+    {
+        const auto& params = segment.parameters;
+        const auto chromaSize =
+            ((params.width + 1) / 2) * ((params.height + 1) / 2);
+        BOOST_CHECK_EQUAL(params.dataType, deflect::DataType::yuv420);
+        BOOST_CHECK_EQUAL(segment.imageData.size(),
+                          int(params.width * params.height + 2 * chromaSize));
+    }
+}
+
+#endif
+
+BOOST_AUTO_TEST_CASE(testViewportDecodingOnlyDecodesVisibleSegments)
+{
+    auto frame = makeJpegTestFrame(deflect::ChromaSubsampling::YUV444);
+    BOOST_REQUIRE_EQUAL(frame->segments.size(), 9);
+
+    const QRect viewport(5, 5, 10, 10);
+    deflect::SegmentDecoder decoder;
+    decoder.decode(*frame, viewport);
+
+    for (const auto& segment : frame->segments)
+    {
+        const auto rect = toRect(segment.parameters);
+        BOOST_CHECK(rect.size() == QSize(10, 10));
+        if (rect.intersects(viewport))
+        {
+            BOOST_CHECK_EQUAL(segment.parameters.dataType,
+                              deflect::DataType::rgba);
+            BOOST_CHECK_EQUAL(segment.imageData.size(), 10 * 10 * 4);
+        }
+        else
+        {
+            BOOST_CHECK_EQUAL(segment.parameters.dataType,
+                              deflect::DataType::jpeg);
+        }
+    }
+    BOOST_CHECK(frame->computeDimensions() == QSize(30, 30));
+}
+
 BOOST_AUTO_TEST_CASE(testImageSegmentationWithCompressionAndDecompression)
 {
     // Vector of rgba data
@@ -294,3 +529,36 @@ BOOST_AUTO_TEST_CASE(testDecompressionOfInvalidData)
     BOOST_CHECK_NO_THROW(decoder.startDecoding(segment));
     BOOST_CHECK_THROW(decoder.waitDecoding(), std::runtime_error);
 }
+
+BOOST_AUTO_TEST_CASE(testFrameDecompression)
+{
+    const auto data = makeTestImage();
+
+    deflect::ImageWrapper imageWrapper(data.data(), 8, 8, deflect::RGBA);
+    imageWrapper.compressionPolicy = deflect::COMPRESSION_ON;
+
+    auto frame = std::make_shared<deflect::Frame>();
+    deflect::ImageSegmenter segmenter;
+    segmenter.setNominalSegmentDimensions(4, 4);
+    segmenter.generate(imageWrapper, std::bind(&append,
+                                               std::ref(frame->segments),
+                                               std::placeholders::_1));
+    BOOST_REQUIRE_EQUAL(frame->segments.size(), 4);
+
+    deflect::SegmentDecoder decoder;
+    decoder.decodeAsync(frame).get();
+
+    for (const auto& segment : frame->segments)
+    {
+        BOOST_CHECK_EQUAL(segment.parameters.dataType, deflect::DataType::rgba);
+        BOOST_CHECK_EQUAL(segment.imageData.size(), 4 * 4 * 4);
+    }
+    BOOST_CHECK(frame->computeDimensions() == QSize(8, 8));
+
+    // decoding an already decoded frame is a no-op
+    BOOST_CHECK_NO_THROW(decoder.decode(*frame));
+
+    frame->segments[2].parameters.dataType = deflect::DataType::jpeg;
+    BOOST_CHECK_THROW(decoder.decode(*frame), std::runtime_error);
+    BOOST_CHECK_THROW(decoder.decodeAsync(frame).get(), std::runtime_error);
+}
@@ -46,8 +46,13 @@ namespace ut = boost::unit_test;
 #include "boost_test_thread_safe.h"
 
 #include <deflect/Frame.h>
+#include <deflect/MessageHeader.h>
+#include <deflect/NetworkProtocol.h>
+#include <deflect/Socket.h>
 #include <deflect/Stream.h>
 
+#include <QThread>
+
 #include <cmath>
 
 namespace
@@ -135,10 +140,20 @@ BOOST_AUTO_TEST_CASE(testDataReceivedByServer)
 
 BOOST_AUTO_TEST_CASE(testOneObserverAndOneStream)
 {
+    uint64_t frameId = 0;
     setFrameReceivedCallback([&](deflect::FramePtr frame) {
         SAFE_BOOST_CHECK_EQUAL(frame->segments.size(), 1);
         SAFE_BOOST_CHECK_EQUAL(frame->uri.toStdString(),
                                testStreamId.toStdString());
+
+        SAFE_BOOST_CHECK_EQUAL(frame->id, ++frameId);
+        const auto& timestamps = frame->timestamps;
+        // Frames are only timestamped once the clock sync reply is processed
+        if (timestamps.captured > 0)
+            SAFE_BOOST_CHECK(timestamps.sent >= timestamps.captured);
+        SAFE_BOOST_CHECK(timestamps.received > 0);
+        SAFE_BOOST_CHECK(timestamps.completed >= timestamps.received);
+        SAFE_BOOST_CHECK(timestamps.dispatched >= timestamps.completed);
     });
 
     // handle received frames to test the stream's purpose
@@ -196,6 +211,156 @@ BOOST_AUTO_TEST_CASE(testOneObserverAndOneStream)
     SAFE_BOOST_CHECK_EQUAL(getReceivedFrames(), expectedFrames);
 }
 
+BOOST_AUTO_TEST_CASE(testObserverReceivesSubscribedFrames)
+{
+    const size_t expectedFrames = 2;
+
+    {
+        deflect::Stream stream(testStreamId.toStdString(), "localhost",
+                               serverPort());
+        SAFE_BOOST_REQUIRE(stream.isConnected());
+
+        deflect::Observer observer(testStreamId.toStdString(), "localhost",
+                                   serverPort());
+        SAFE_BOOST_REQUIRE(observer.isConnected());
+        SAFE_BOOST_REQUIRE(observer.subscribeToFrames());
+
+        // the bind reply guarantees that the subscription was processed
+        SAFE_BOOST_CHECK(observer.registerForEvents(true));
+
+        // handle connects first before sending and receiving frames
+        waitForMessage();
+
+        const unsigned int width = 4;
+        const unsigned int height = 4;
+        const std::vector<uint8_t> pixels(width * height * 4, 42);
+        deflect::ImageWrapper image(pixels.data(), width, height,
+                                    deflect::RGBA);
+        image.compressionPolicy = deflect::COMPRESSION_OFF;
+
+        for (size_t i = 0; i < expectedFrames; ++i)
+        {
+            stream.sendAndFinish(image).wait();
+            requestFrame(testStreamId);
+
+            // process frame receive
+            waitForMessage();
+
+            const auto frame = observer.getFrame();
+            SAFE_BOOST_REQUIRE(frame);
+            SAFE_BOOST_CHECK_EQUAL(frame->uri.toStdString(),
+                                   testStreamId.toStdString());
+            SAFE_BOOST_REQUIRE_EQUAL(frame->segments.size(), 1);
+            const auto& segment = frame->segments[0];
+            SAFE_BOOST_CHECK(segment.parameters.dataType ==
+                             deflect::DataType::rgba);
+            SAFE_BOOST_CHECK(segment.imageData ==
+                             QByteArray((const char*)pixels.data(),
+                                        int(pixels.size())));
+            SAFE_BOOST_CHECK(!observer.hasFrame());
+        }
+    }
+
+    // handle close of streamer and observer
+    waitForMessage();
+
+    SAFE_BOOST_CHECK_EQUAL(getOpenedStreams(), 0);
+    SAFE_BOOST_CHECK_EQUAL(getReceivedFrames(), expectedFrames);
+}
+
+BOOST_AUTO_TEST_CASE(testStreamIsSuspendedWhileFramesAreNotRequested)
+{
+    setViewHiddenTimeout(100);
+
+    {
+        deflect::Stream stream(testStreamId.toStdString(), "localhost",
+                               serverPort());
+        SAFE_BOOST_REQUIRE(stream.isConnected());
+        SAFE_BOOST_REQUIRE(stream.registerForEvents());
+
+        const std::vector<uint8_t> pixels(4 * 4 * 4, 0);
+        deflect::ImageWrapper image(pixels.data(), 4, 4, deflect::RGBA);
+
+        stream.sendAndFinish(image).wait();
+        requestFrame(testStreamId);
+        waitForMessage();
+
+        // the frame is not requested again, as if the view was hidden
+        while (!stream.hasEvent())
+            ;
+        SAFE_BOOST_CHECK_EQUAL(stream.getEvent().type,
+                               deflect::Event::EVT_VIEW_HIDDEN);
+
+        requestFrame(testStreamId);
+        while (!stream.hasEvent())
+            ;
+        SAFE_BOOST_CHECK_EQUAL(stream.getEvent().type,
+                               deflect::Event::EVT_VIEW_SHOWN);
+
+        // the view is hidden again once the next frame is no longer requested
+        stream.sendAndFinish(image).wait();
+        waitForMessage();
+        while (!stream.hasEvent())
+            ;
+        SAFE_BOOST_CHECK_EQUAL(stream.getEvent().type,
+                               deflect::Event::EVT_VIEW_HIDDEN);
+    }
+
+    // handle close of streamer
+    waitForMessage();
+
+    SAFE_BOOST_CHECK_EQUAL(getOpenedStreams(), 0);
+    SAFE_BOOST_CHECK_EQUAL(getReceivedFrames(), size_t(2));
+}
+
+BOOST_AUTO_TEST_CASE(testViewVisibilityIsNotSentToOlderClients)
+{
+    setViewHiddenTimeout(100);
+
+    const auto id = testStreamId.toStdString();
+    deflect::Socket socket("localhost", serverPort());
+    SAFE_BOOST_REQUIRE(socket.isConnected());
+
+    // Speak the oldest supported protocol, which has no visibility events
+    const auto version = QByteArray::number(MIN_NETWORK_PROTOCOL_VERSION);
+    socket.send({deflect::MESSAGE_TYPE_PIXELSTREAM_OPEN,
+                 uint32_t(version.size()), id},
+                version, true);
+    waitForMessage();
+
+    socket.send({deflect::MESSAGE_TYPE_BIND_EVENTS, 0, id}, {}, true);
+    for (int i = 0; i < 100 && !socket.hasMessage(); ++i)
+        QThread::msleep(10);
+    deflect::MessageHeader header;
+    QByteArray message;
+    SAFE_BOOST_REQUIRE(socket.receive(header, message));
+    SAFE_BOOST_REQUIRE_EQUAL(header.type,
+                             deflect::MESSAGE_TYPE_BIND_EVENTS_REPLY);
+
+    deflect::SegmentParameters params;
+    params.width = 4;
+    params.height = 4;
+    params.dataType = deflect::DataType::rgba;
+    const QByteArray pixels(4 * 4 * 4, 0);
+    socket.send({deflect::MESSAGE_TYPE_PIXELSTREAM,
+                 uint32_t(sizeof(params) + pixels.size()), id},
+                params, pixels, false);
+    socket.send({deflect::MESSAGE_TYPE_PIXELSTREAM_FINISH_FRAME, 0, id}, {},
+                true);
+    requestFrame(testStreamId);
+    waitForMessage();
+
+    // the frame is not requested again, but the client is not told so
+    QThread::msleep(500);
+    SAFE_BOOST_CHECK(!socket.hasMessage());
+
+    socket.send({deflect::MESSAGE_TYPE_QUIT, 0, id}, {}, true);
+    waitForMessage();
+
+    SAFE_BOOST_CHECK_EQUAL(getOpenedStreams(), 0);
+    SAFE_BOOST_CHECK_EQUAL(getReceivedFrames(), size_t(1));
+}
+
 BOOST_AUTO_TEST_CASE(testThreadedSmallSegmentStream)
 {
     const unsigned int segmentSize = 64;
@@ -278,6 +443,311 @@ BOOST_AUTO_TEST_CASE(testThreadedSmallSegmentStream)
     SAFE_BOOST_CHECK_EQUAL(getReceivedFrames(), expectedFrames);
 }
 
+BOOST_AUTO_TEST_CASE(testPartialFrameIsCompletedWithRetainedSegments)
+{
+    const unsigned int size = 8;
+
+    size_t receivedFrames = 0;
+    setFrameReceivedCallback([&](deflect::FramePtr frame) {
+        ++receivedFrames;
+        SAFE_BOOST_REQUIRE_EQUAL(frame->segments.size(), 2u);
+        for (const auto& segment : frame->segments)
+        {
+            // The left image is only sent in the keyframe
+            const char expected = segment.parameters.x == 0
+                                      ? 1
+                                      : (receivedFrames == 1 ? 2 : 3);
+            SAFE_BOOST_CHECK_EQUAL(segment.imageData.count(expected),
+                                   segment.imageData.size());
+        }
+        const auto dim = frame->computeDimensions();
+        SAFE_BOOST_CHECK_EQUAL(dim.width(), 2 * size);
+        SAFE_BOOST_CHECK_EQUAL(dim.height(), size);
+    });
+
+    const std::vector<uint8_t> left(size * size * 4, 1);
+    const std::vector<uint8_t> right(size * size * 4, 2);
+    const std::vector<uint8_t> changed(size * size * 4, 3);
+
+    {
+        deflect::Stream stream(testStreamId.toStdString(), "localhost",
+                               serverPort());
+        SAFE_BOOST_REQUIRE(stream.isConnected());
+
+        // handle connect of stream
+        waitForMessage();
+
+        deflect::ImageWrapper leftImage(left.data(), size, size, deflect::RGBA);
+        deflect::ImageWrapper rightImage(right.data(), size, size,
+                                         deflect::RGBA, size, 0);
+        deflect::ImageWrapper changedImage(changed.data(), size, size,
+                                           deflect::RGBA, size, 0);
+        for (auto image : {&leftImage, &rightImage, &changedImage})
+            image->compressionPolicy = deflect::COMPRESSION_OFF;
+
+        SAFE_BOOST_CHECK(stream.send(leftImage).get());
+        SAFE_BOOST_CHECK(stream.send(rightImage).get());
+        SAFE_BOOST_CHECK(
+            stream.finishFrame(deflect::FrameUpdate::keyframe).get());
+        requestFrame(testStreamId);
+        waitForMessage();
+
+        SAFE_BOOST_CHECK(stream.send(changedImage).get());
+        SAFE_BOOST_CHECK(
+            stream.finishFrame(deflect::FrameUpdate::partial).get());
+        requestFrame(testStreamId);
+        waitForMessage();
+    }
+
+    // handle close of streamer
+    waitForMessage();
+
+    SAFE_BOOST_CHECK_EQUAL(getOpenedStreams(), 0);
+    SAFE_BOOST_CHECK_EQUAL(getReceivedFrames(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(testUnfinishedFrameCountsTowardsBufferSize)
+{
+    const unsigned int size = 2048; // 16 MiB of raw pixels
+
+    setMaxStreamBufferSize(4 * 1024 * 1024);
+
+    const std::vector<uint8_t> pixels(size * size * 4, 1);
+
+    {
+        deflect::Stream stream(testStreamId.toStdString(), "localhost",
+                               serverPort());
+        SAFE_BOOST_REQUIRE(stream.isConnected());
+
+        // handle connect of stream
+        waitForMessage();
+
+        deflect::ImageWrapper image(pixels.data(), size, size, deflect::RGBA);
+        image.compressionPolicy = deflect::COMPRESSION_OFF;
+
+        // The frame is never finished, the server closes the stream anyway
+        stream.send(image).get();
+
+        // handle close of stream by the server
+        waitForMessage();
+        SAFE_BOOST_CHECK_EQUAL(getOpenedStreams(), 0);
+    }
+
+    SAFE_BOOST_CHECK_EQUAL(getReceivedFrames(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(testCursorIsAttachedToFrames)
+{
+    const unsigned int size = 8;
+    const unsigned int cursorSize = 2;
+
+    size_t receivedFrames = 0;
+    setFrameReceivedCallback([&](deflect::FramePtr frame) {
+        ++receivedFrames;
+        const auto& cursor = frame->cursor;
+        SAFE_BOOST_CHECK_EQUAL(cursor.size.width(), int(cursorSize));
+        SAFE_BOOST_CHECK_EQUAL(cursor.size.height(), int(cursorSize));
+        SAFE_BOOST_CHECK_EQUAL(cursor.image.count(char(7)),
+                               int(cursorSize * cursorSize * 4));
+        SAFE_BOOST_CHECK_EQUAL(cursor.hotspot.x(), 1);
+        SAFE_BOOST_CHECK_EQUAL(cursor.hotspot.y(), 0);
+        SAFE_BOOST_CHECK_EQUAL(cursor.position.x(), 3);
+        SAFE_BOOST_CHECK_EQUAL(cursor.position.y(), 5);
+        SAFE_BOOST_CHECK(cursor.visible);
+    });
+
+    const std::vector<uint8_t> pixels(size * size * 4, 1);
+    const std::vector<uint8_t> cursorPixels(cursorSize * cursorSize * 4, 7);
+
+    {
+        deflect::Stream stream(testStreamId.toStdString(), "localhost",
+                               serverPort());
+        SAFE_BOOST_REQUIRE(stream.isConnected());
+
+        // handle connect of stream
+        waitForMessage();
+
+        deflect::ImageWrapper cursor(cursorPixels.data(), cursorSize,
+                                     cursorSize, deflect::RGBA);
+        cursor.compressionPolicy = deflect::COMPRESSION_OFF;
+        SAFE_BOOST_CHECK(stream.sendCursorShape(cursor, 1, 0).get());
+        SAFE_BOOST_CHECK(stream.sendCursorPosition(3, 5).get());
+
+        deflect::ImageWrapper image(pixels.data(), size, size, deflect::RGBA);
+        image.compressionPolicy = deflect::COMPRESSION_OFF;
+        SAFE_BOOST_CHECK(stream.sendAndFinish(image).get());
+        requestFrame(testStreamId);
+        waitForMessage();
+    }
+
+    // handle close of streamer
+    waitForMessage();
+
+    SAFE_BOOST_CHECK_EQUAL(receivedFrames, 1u);
+}
+
+#ifdef DEFLECT_USE_LIBJPEGTURBO
+BOOST_AUTO_TEST_CASE(testServerDecodesSegmentsWhenRequested)
+{
+    const unsigned int width = 128;
+    const unsigned int height = 64;
+
+    setSegmentDecoding(deflect::SegmentDecoding::rgba);
+
+    setFrameReceivedCallback([&](deflect::FramePtr frame) {
+        SAFE_BOOST_CHECK_EQUAL(frame->segments.size(), 1);
+        for (const auto& segment : frame->segments)
+        {
+            SAFE_BOOST_CHECK(segment.parameters.dataType ==
+                             deflect::DataType::rgba);
+            SAFE_BOOST_CHECK_EQUAL(size_t(segment.imageData.size()),
+                                   segment.parameters.width *
+                                       segment.parameters.height * 4);
+        }
+        const auto dim = frame->computeDimensions();
+        SAFE_BOOST_CHECK_EQUAL(dim.width(), width);
+        SAFE_BOOST_CHECK_EQUAL(dim.height(), height);
+    });
+
+    const std::vector<uint8_t> pixels(width * height * 4, 42);
+    const size_t expectedFrames = 2;
+
+    {
+        deflect::Stream stream(testStreamId.toStdString(), "localhost",
+                               serverPort());
+        SAFE_BOOST_REQUIRE(stream.isConnected());
+
+        // handle connect of stream
+        waitForMessage();
+
+        deflect::ImageWrapper image(pixels.data(), width, height,
+                                    deflect::RGBA);
+        image.compressionPolicy = deflect::COMPRESSION_ON;
+
+        for (size_t i = 0; i < expectedFrames; ++i)
+        {
+            SAFE_BOOST_CHECK(stream.sendAndFinish(image).get());
+            requestFrame(testStreamId);
+
+            // process frame receive
+            waitForMessage();
+        }
+    }
+
+    // handle close of streamer
+    waitForMessage();
+
+    SAFE_BOOST_CHECK_EQUAL(getOpenedStreams(), 0);
+    SAFE_BOOST_CHECK_EQUAL(getReceivedFrames(), expectedFrames);
+}
+
+BOOST_AUTO_TEST_CASE(testSubscribersReceiveDecodedSegments)
+{
+    const unsigned int width = 128;
+    const unsigned int height = 64;
+
+    setSegmentDecoding(deflect::SegmentDecoding::rgba);
+
+    {
+        deflect::Stream stream(testStreamId.toStdString(), "localhost",
+                               serverPort());
+        SAFE_BOOST_REQUIRE(stream.isConnected());
+
+        deflect::Observer observer(testStreamId.toStdString(), "localhost",
+                                   serverPort());
+        SAFE_BOOST_REQUIRE(observer.isConnected());
+        SAFE_BOOST_REQUIRE(observer.subscribeToFrames());
+
+        // the bind reply guarantees that the subscription was processed
+        SAFE_BOOST_CHECK(observer.registerForEvents(true));
+
+        // handle connects first before sending and receiving frames
+        waitForMessage();
+
+        const std::vector<uint8_t> pixels(width * height * 4, 42);
+        deflect::ImageWrapper image(pixels.data(), width, height,
+                                    deflect::RGBA);
+        image.compressionPolicy = deflect::COMPRESSION_ON;
+
+        SAFE_BOOST_CHECK(stream.sendAndFinish(image).get());
+        requestFrame(testStreamId);
+
+        // process frame receive
+        waitForMessage();
+
+        // the compressed segments are not kept by the server
+        const auto frame = observer.getFrame();
+        SAFE_BOOST_REQUIRE(frame);
+        SAFE_BOOST_REQUIRE_EQUAL(frame->segments.size(), 1);
+        const auto& segment = frame->segments[0];
+        SAFE_BOOST_CHECK(segment.parameters.dataType ==
+                         deflect::DataType::rgba);
+        SAFE_BOOST_CHECK_EQUAL(size_t(segment.imageData.size()),
+                               width * height * 4);
+    }
+
+    // handle close of streamer and observer
+    waitForMessage();
+
+    SAFE_BOOST_CHECK_EQUAL(getOpenedStreams(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(testServerDecodesFramesSentWithoutWaiting)
+{
+    const unsigned int width = 1024;
+    const unsigned int height = 64;
+    const size_t sentFrames = 5;
+
+    setSegmentDecoding(deflect::SegmentDecoding::rgba);
+
+    // Frames are decoded while the next ones are received, but they must
+    // still be dispatched complete and in order
+    uint64_t lastFrameId = 0;
+    setFrameReceivedCallback([&](deflect::FramePtr frame) {
+        SAFE_BOOST_CHECK(frame->id > lastFrameId);
+        lastFrameId = frame->id;
+        SAFE_BOOST_CHECK_EQUAL(frame->segments.size(), 2u);
+        for (const auto& segment : frame->segments)
+        {
+            SAFE_BOOST_CHECK(segment.parameters.dataType ==
+                             deflect::DataType::rgba);
+        }
+        const auto dim = frame->computeDimensions();
+        SAFE_BOOST_CHECK_EQUAL(dim.width(), width);
+        SAFE_BOOST_CHECK_EQUAL(dim.height(), height);
+    });
+
+    const std::vector<uint8_t> pixels(width * height * 4, 42);
+
+    {
+        deflect::Stream stream(testStreamId.toStdString(), "localhost",
+                               serverPort());
+        SAFE_BOOST_REQUIRE(stream.isConnected());
+
+        // handle connect of stream
+        waitForMessage();
+
+        deflect::ImageWrapper image(pixels.data(), width, height,
+                                    deflect::RGBA);
+        image.compressionPolicy = deflect::COMPRESSION_ON;
+
+        for (size_t i = 0; i < sentFrames; ++i)
+            SAFE_BOOST_CHECK(stream.sendAndFinish(image).get());
+        requestFrame(testStreamId);
+
+        // process frame receive
+        waitForMessage();
+    }
+
+    // handle close of streamer
+    waitForMessage();
+
+    SAFE_BOOST_CHECK_EQUAL(getOpenedStreams(), 0);
+    SAFE_BOOST_CHECK_EQUAL(getReceivedFrames(), 1u);
+    SAFE_BOOST_CHECK(lastFrameId <= sentFrames);
+}
+#endif
+
 BOOST_AUTO_TEST_CASE(testCompressionErrorForBigNullImage)
 {
     deflect::Stream stream(testStreamId.toStdString(), "localhost",
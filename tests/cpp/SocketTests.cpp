@@ -44,10 +44,30 @@ namespace ut = boost::unit_test;
 #include "MinimalDeflectServer.h"
 #include "MinimalGlobalQtApp.h"
 
+#include <deflect/MessageHeader.h>
+#include <deflect/NetworkProtocol.h>
 #include <deflect/Socket.h>
 
+#include <QDataStream>
+#include <QThread>
+
 BOOST_GLOBAL_FIXTURE(MinimalGlobalQtApp);
 
+namespace
+{
+const QByteArray messageBody(64, 'x');
+
+QByteArray serializeHeader()
+{
+    const deflect::MessageHeader header(deflect::MESSAGE_TYPE_DATA,
+                                        messageBody.size());
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream << header;
+    return data;
+}
+}
+
 void testSocketConnect(const int32_t versionOffset)
 {
     MinimalDeflectServer server(versionOffset);
@@ -69,10 +89,22 @@ BOOST_AUTO_TEST_CASE(
     testSocketConnect(0);
 }
 
+BOOST_AUTO_TEST_CASE(
+    testSocketConnectionValidWhenReturnedOldestSupportedProtocolVersion)
+{
+    MinimalDeflectServer server(MIN_NETWORK_PROTOCOL_VERSION -
+                                NETWORK_PROTOCOL_VERSION);
+    deflect::Socket socket("localhost", server.serverPort());
+    BOOST_CHECK(socket.isConnected());
+    BOOST_CHECK_EQUAL(socket.getServerProtocolVersion(),
+                      MIN_NETWORK_PROTOCOL_VERSION);
+}
+
 BOOST_AUTO_TEST_CASE(
     testSocketConnectionInvalidWhenReturnedLowerNetworkProtocolVersion)
 {
-    testSocketConnect(-1);
+    testSocketConnect(MIN_NETWORK_PROTOCOL_VERSION - NETWORK_PROTOCOL_VERSION -
+                      1);
 }
 
 BOOST_AUTO_TEST_CASE(
@@ -80,3 +112,29 @@ BOOST_AUTO_TEST_CASE(
 {
     testSocketConnect(1);
 }
+
+BOOST_AUTO_TEST_CASE(testSocketHasNoMessageUntilItsBodyIsReceived)
+{
+    // Only the header of the message is sent by the server
+    MinimalDeflectServer server(0, serializeHeader());
+    deflect::Socket socket("localhost", server.serverPort());
+
+    QThread::msleep(100);
+    BOOST_CHECK(!socket.hasMessage());
+}
+
+BOOST_AUTO_TEST_CASE(testSocketHasMessageWhenItIsComplete)
+{
+    MinimalDeflectServer server(0, serializeHeader() + messageBody);
+    deflect::Socket socket("localhost", server.serverPort());
+
+    for (int i = 0; i < 100 && !socket.hasMessage(); ++i)
+        QThread::msleep(10);
+    BOOST_REQUIRE(socket.hasMessage());
+
+    deflect::MessageHeader header;
+    QByteArray message;
+    BOOST_REQUIRE(socket.receive(header, message));
+    BOOST_CHECK_EQUAL(header.type, deflect::MESSAGE_TYPE_DATA);
+    BOOST_CHECK(message == messageBody);
+}
@@ -44,6 +44,7 @@ namespace ut = boost::unit_test;
 #include "MinimalDeflectServer.h"
 #include "MinimalGlobalQtApp.h"
 
+#include <deflect/NetworkProtocol.h>
 #include <deflect/Stream.h>
 
 #include <QString>
@@ -205,4 +206,21 @@ BOOST_AUTO_TEST_CASE(testErrorOnInvalidJpegCompressionValues)
     BOOST_CHECK(stream.send(imageWrapper).get());
 }
 
+BOOST_AUTO_TEST_CASE(testServerSupportsFrameUpdates)
+{
+    deflect::Stream stream("id", "localhost", serverPort());
+    BOOST_CHECK(stream.supportsFrameUpdates());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_CASE(testOlderServerOnlySupportsFullFrames)
+{
+    MinimalDeflectServer server(MIN_NETWORK_PROTOCOL_VERSION -
+                                NETWORK_PROTOCOL_VERSION);
+    deflect::Stream stream("id", "localhost", server.serverPort());
+    BOOST_CHECK(!stream.supportsFrameUpdates());
+    BOOST_CHECK_THROW(stream.finishFrame(deflect::FrameUpdate::partial).get(),
+                      std::runtime_error);
+    BOOST_CHECK(!stream.sendCursorPosition(0, 0).get());
+}
@@ -0,0 +1,175 @@
+/*********************************************************************/
+/* Copyright (c) 2017, EPFL/Blue Brain Project                       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+
+#define BOOST_TEST_MODULE TouchInjectorTests
+#include <boost/test/unit_test.hpp>
+namespace ut = boost::unit_test;
+
+#include "MinimalGlobalQtApp.h"
+
+#include <deflect/qt/TouchInjector.h>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+
+#include <vector>
+
+namespace
+{
+struct TouchPoint
+{
+    int id;
+    Qt::TouchPointState state;
+    QPointF position;
+};
+
+struct TouchEvent
+{
+    QEvent::Type type;
+    std::vector<TouchPoint> points;
+};
+
+// Record the touch events posted by a TouchInjector
+class TouchTarget : public QObject
+{
+public:
+    bool event(QEvent* event) final
+    {
+        const auto touchEvent = dynamic_cast<QTouchEvent*>(event);
+        if (!touchEvent)
+            return QObject::event(event);
+
+        TouchEvent recorded{event->type(), {}};
+        for (const auto& point : touchEvent->touchPoints())
+        {
+            recorded.points.push_back(
+                {point.id(), point.state(), point.normalizedPos()});
+        }
+        events.push_back(recorded);
+        return true;
+    }
+
+    std::vector<TouchEvent> events;
+};
+
+void processEventsUntil(const TouchTarget& target, const size_t count)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (target.events.size() < count && timer.elapsed() < 5000)
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+}
+
+QPointF mapToScene(const QPointF& normalizedPos)
+{
+    return normalizedPos * 100;
+}
+
+void checkPoint(const TouchEvent& event, const size_t index, const int id,
+                const Qt::TouchPointState state, const double x)
+{
+    BOOST_REQUIRE_GT(event.points.size(), index);
+    const auto& point = event.points[index];
+    BOOST_CHECK_EQUAL(point.id, id);
+    BOOST_CHECK_EQUAL(point.state, state);
+    BOOST_CHECK_CLOSE(point.position.x(), x, 0.0001);
+}
+}
+
+BOOST_GLOBAL_FIXTURE(MinimalGlobalQtApp);
+
+BOOST_AUTO_TEST_CASE(testBurstsOfUpdatesAreCoalesced)
+{
+    TouchTarget target;
+    deflect::qt::TouchInjector injector(target, mapToScene);
+
+    injector.addTouchPoint(1, {0.1, 0.1});
+    for (int i = 2; i <= 5; ++i)
+        injector.updateTouchPoint(1, {0.1 * i, 0.1 * i});
+    processEventsUntil(target, 2);
+
+    BOOST_REQUIRE_EQUAL(target.events.size(), 2);
+    BOOST_CHECK_EQUAL(target.events[0].type, QEvent::TouchBegin);
+    checkPoint(target.events[0], 0, 1, Qt::TouchPointPressed, 0.1);
+
+    // a single update with the latest position
+    BOOST_CHECK_EQUAL(target.events[1].type, QEvent::TouchUpdate);
+    BOOST_CHECK_EQUAL(target.events[1].points.size(), 1);
+    checkPoint(target.events[1], 0, 1, Qt::TouchPointMoved, 0.5);
+}
+
+BOOST_AUTO_TEST_CASE(testAddAndRemoveAreOrderedWithPendingUpdates)
+{
+    TouchTarget target;
+    deflect::qt::TouchInjector injector(target, mapToScene);
+
+    injector.addTouchPoint(1, {0.1, 0.1});
+    injector.updateTouchPoint(1, {0.2, 0.2});
+    injector.updateTouchPoint(1, {0.3, 0.3});
+    injector.addTouchPoint(2, {0.4, 0.4});
+    injector.updateTouchPoint(1, {0.5, 0.5});
+    injector.updateTouchPoint(2, {0.6, 0.6});
+    injector.updateTouchPoint(2, {0.7, 0.7});
+    injector.removeTouchPoint(2, {0.8, 0.8});
+    injector.removeTouchPoint(1, {0.9, 0.9});
+    processEventsUntil(target, 6);
+
+    // the pending updates are flushed before each addition or removal
+    BOOST_REQUIRE_EQUAL(target.events.size(), 6);
+    const auto& events = target.events;
+
+    checkPoint(events[0], 0, 1, Qt::TouchPointPressed, 0.1);
+
+    BOOST_CHECK_EQUAL(events[1].type, QEvent::TouchUpdate);
+    checkPoint(events[1], 0, 1, Qt::TouchPointMoved, 0.3);
+
+    checkPoint(events[2], 0, 1, Qt::TouchPointStationary, 0.3);
+    checkPoint(events[2], 1, 2, Qt::TouchPointPressed, 0.4);
+
+    BOOST_CHECK_EQUAL(events[3].type, QEvent::TouchUpdate);
+    checkPoint(events[3], 0, 1, Qt::TouchPointMoved, 0.5);
+    checkPoint(events[3], 1, 2, Qt::TouchPointMoved, 0.7);
+
+    BOOST_CHECK_EQUAL(events[4].type, QEvent::TouchUpdate);
+    checkPoint(events[4], 0, 1, Qt::TouchPointStationary, 0.5);
+    checkPoint(events[4], 1, 2, Qt::TouchPointReleased, 0.8);
+
+    BOOST_CHECK_EQUAL(events[5].points.size(), 1);
+    checkPoint(events[5], 0, 1, Qt::TouchPointReleased, 0.9);
+}
@@ -0,0 +1,345 @@
+/*********************************************************************/
+/* Copyright (c) 2017, EPFL/Blue Brain Project                       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#define BOOST_TEST_MODULE Pipeline
+#include <boost/test/unit_test.hpp>
+namespace ut = boost::unit_test;
+
+#include "Timer.h"
+
+#include <deflect/Event.h>
+#include <deflect/ImageSegmenter.h>
+#include <deflect/ImageWrapper.h>
+#include <deflect/MTQueue.h>
+#include <deflect/MessageHeader.h>
+#include <deflect/Segment.h>
+
+#ifdef DEFLECT_USE_LIBJPEGTURBO
+#include <deflect/ImageJpegCompressor.h>
+#include <deflect/ImageJpegDecompressor.h>
+#endif
+
+#include <QDataStream>
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+// Measures the individual stages of the pixel pipeline on fixed synthetic
+// inputs, so that runs on different revisions or machines can be compared.
+// Each measurement is written as one CSV line to the file given with
+// "-- --output <file>", or to "pipeline.csv" in the working directory, so that
+// it is not mixed with the output of the test framework:
+// stage,parameters,iterations,seconds,us_per_iteration,MB_per_s
+
+#define WIDTH (1920u)
+#define HEIGHT (1080u)
+#define TILE_SIZE (512u)
+
+namespace
+{
+const unsigned int segmentSizes[] = {256u, 512u, 1024u};
+const char* defaultOutput = "pipeline.csv";
+
+std::ofstream csv;
+
+// A smooth gradient with a fixed amount of noise, which compresses about as
+// well as typical rendered content. The seed is constant across runs.
+QByteArray makeImage(const unsigned int width, const unsigned int height)
+{
+    std::minstd_rand rng(0);
+    std::uniform_int_distribution<int> noise(0, 15);
+
+    QByteArray image(width * height * 4, 0);
+    auto pixel = reinterpret_cast<uint8_t*>(image.data());
+    for (unsigned int y = 0; y < height; ++y)
+    {
+        for (unsigned int x = 0; x < width; ++x)
+        {
+            *pixel++ = (x * 255 / width + noise(rng)) & 0xff;
+            *pixel++ = (y * 255 / height + noise(rng)) & 0xff;
+            *pixel++ = ((x + y) & 0xff);
+            *pixel++ = 0xff;
+        }
+    }
+    return image;
+}
+
+void report(const std::string& stage, const std::string& parameters,
+            const size_t iterations, const float seconds,
+            const size_t bytesPerIteration)
+{
+    const double megabytes = double(bytesPerIteration) * iterations / 1e6;
+    csv << stage << "," << parameters << "," << iterations << ","
+              << seconds << "," << seconds / iterations * 1e6 << ","
+              << (seconds > 0.f ? megabytes / seconds : 0.0) << std::endl;
+}
+
+std::string sizeParameters(const unsigned int width, const unsigned int height)
+{
+    return std::to_string(width) + "x" + std::to_string(height);
+}
+
+std::string outputFilename()
+{
+    const auto& suite = ut::framework::master_test_suite();
+    for (int i = 1; i < suite.argc - 1; ++i)
+    {
+        if (std::strcmp(suite.argv[i], "--output") == 0)
+            return suite.argv[i + 1];
+    }
+    return defaultOutput;
+}
+
+struct CsvOutput
+{
+    CsvOutput()
+    {
+        const auto filename = outputFilename();
+        csv.open(filename);
+        if (!csv)
+            throw std::runtime_error("could not open output: " + filename);
+        std::cout << "Writing results to: " << filename << std::endl;
+        csv << "stage,parameters,iterations,seconds,"
+               "us_per_iteration,MB_per_s"
+            << std::endl;
+    }
+    ~CsvOutput() { csv.close(); }
+};
+}
+
+BOOST_GLOBAL_FIXTURE(CsvOutput);
+
+BOOST_AUTO_TEST_CASE(benchmarkSwapYAxis)
+{
+    const size_t iterations = 50;
+    QByteArray image = makeImage(WIDTH, HEIGHT);
+
+    Timer timer;
+    timer.start();
+    for (size_t i = 0; i < iterations; ++i)
+        deflect::ImageWrapper::swapYAxis(image.data(), WIDTH, HEIGHT, 4);
+    report("swapYAxis", sizeParameters(WIDTH, HEIGHT), iterations,
+           timer.elapsed(), image.size());
+}
+
+BOOST_AUTO_TEST_CASE(benchmarkSegmenterRaw)
+{
+    const size_t iterations = 50;
+    const QByteArray image = makeImage(WIDTH, HEIGHT);
+    deflect::ImageWrapper wrapper(image.constData(), WIDTH, HEIGHT,
+                                  deflect::RGBA);
+    wrapper.compressionPolicy = deflect::COMPRESSION_OFF;
+
+    for (const auto size : segmentSizes)
+    {
+        deflect::ImageSegmenter segmenter;
+        segmenter.setNominalSegmentDimensions(size, size);
+        size_t count = 0;
+        const auto handler = [&count](const deflect::Segment&) {
+            ++count;
+            return true;
+        };
+
+        Timer timer;
+        timer.start();
+        for (size_t i = 0; i < iterations; ++i)
+            BOOST_REQUIRE(segmenter.generate(wrapper, handler));
+        report("segmenter_raw", "segment=" + std::to_string(size), iterations,
+               timer.elapsed(), image.size());
+        BOOST_CHECK_GT(count, 0u);
+    }
+}
+
+#ifdef DEFLECT_USE_LIBJPEGTURBO
+BOOST_AUTO_TEST_CASE(benchmarkSegmenterJpeg)
+{
+    const size_t iterations = 10;
+    const QByteArray image = makeImage(WIDTH, HEIGHT);
+    deflect::ImageWrapper wrapper(image.constData(), WIDTH, HEIGHT,
+                                  deflect::RGBA);
+    wrapper.compressionPolicy = deflect::COMPRESSION_ON;
+    wrapper.compressionQuality = 75;
+
+    for (const auto size : segmentSizes)
+    {
+        deflect::ImageSegmenter segmenter;
+        segmenter.setNominalSegmentDimensions(size, size);
+        size_t compressedBytes = 0;
+        const auto handler = [&compressedBytes](const deflect::Segment& s) {
+            compressedBytes += s.imageData.size();
+            return true;
+        };
+
+        Timer timer;
+        timer.start();
+        for (size_t i = 0; i < iterations; ++i)
+            BOOST_REQUIRE(segmenter.generate(wrapper, handler));
+        report("segmenter_jpeg", "segment=" + std::to_string(size), iterations,
+               timer.elapsed(), image.size());
+        BOOST_CHECK_GT(compressedBytes, 0u);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(benchmarkJpegCompressAndDecompress)
+{
+    const size_t iterations = 100;
+    const QByteArray image = makeImage(TILE_SIZE, TILE_SIZE);
+    deflect::ImageWrapper wrapper(image.constData(), TILE_SIZE, TILE_SIZE,
+                                  deflect::RGBA);
+    wrapper.compressionQuality = 75;
+    const QRect region(0, 0, TILE_SIZE, TILE_SIZE);
+    const auto parameters = sizeParameters(TILE_SIZE, TILE_SIZE);
+
+    deflect::ImageJpegCompressor compressor;
+    QByteArray jpeg;
+    Timer timer;
+    timer.start();
+    for (size_t i = 0; i < iterations; ++i)
+        jpeg = compressor.computeJpeg(wrapper, region);
+    report("jpeg_compress", parameters, iterations, timer.elapsed(),
+           image.size());
+    BOOST_REQUIRE(!jpeg.isEmpty());
+
+    deflect::ImageJpegDecompressor decompressor;
+    QByteArray decoded;
+    timer.start();
+    for (size_t i = 0; i < iterations; ++i)
+        decoded = decompressor.decompress(jpeg);
+    report("jpeg_decompress", parameters, iterations, timer.elapsed(),
+           image.size());
+    BOOST_CHECK_EQUAL(decoded.size(), image.size());
+
+#ifndef DEFLECT_USE_LEGACY_LIBJPEGTURBO
+    deflect::ImageJpegDecompressor::YUVData yuv;
+    timer.start();
+    for (size_t i = 0; i < iterations; ++i)
+        yuv = decompressor.decompressToYUV(jpeg);
+    report("jpeg_decompress_yuv", parameters, iterations, timer.elapsed(),
+           image.size());
+    BOOST_CHECK(!yuv.first.isEmpty());
+#endif
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(benchmarkMessageHeaderSerialization)
+{
+    const size_t iterations = 100000;
+    const deflect::MessageHeader header(deflect::MESSAGE_TYPE_PIXELSTREAM,
+                                        TILE_SIZE * TILE_SIZE, "benchmark");
+    QByteArray buffer;
+    buffer.reserve(iterations * deflect::MessageHeader::serializedSize);
+
+    Timer timer;
+    timer.start();
+    {
+        QDataStream out(&buffer, QIODevice::WriteOnly);
+        for (size_t i = 0; i < iterations; ++i)
+            out << header;
+    }
+    report("header_serialize", "", iterations, timer.elapsed(),
+           deflect::MessageHeader::serializedSize);
+
+    deflect::MessageHeader result;
+    timer.start();
+    {
+        QDataStream in(buffer);
+        for (size_t i = 0; i < iterations; ++i)
+            in >> result;
+    }
+    report("header_deserialize", "", iterations, timer.elapsed(),
+           deflect::MessageHeader::serializedSize);
+    BOOST_CHECK_EQUAL(result.size, header.size);
+}
+
+BOOST_AUTO_TEST_CASE(benchmarkEventSerialization)
+{
+    const size_t iterations = 100000;
+    deflect::Event event;
+    event.type = deflect::Event::EVT_MOVE;
+    event.mouseX = 0.25;
+    event.mouseY = 0.75;
+
+    QByteArray buffer;
+    Timer timer;
+    timer.start();
+    {
+        QDataStream out(&buffer, QIODevice::WriteOnly);
+        for (size_t i = 0; i < iterations; ++i)
+            out << event;
+    }
+    const float writeTime = timer.elapsed();
+    const size_t eventSize = buffer.size() / iterations;
+    report("event_serialize", "", iterations, writeTime, eventSize);
+
+    deflect::Event result;
+    timer.start();
+    {
+        QDataStream in(buffer);
+        for (size_t i = 0; i < iterations; ++i)
+            in >> result;
+    }
+    report("event_deserialize", "", iterations, timer.elapsed(), eventSize);
+    BOOST_CHECK_EQUAL(result.mouseX, event.mouseX);
+}
+
+BOOST_AUTO_TEST_CASE(benchmarkMTQueue)
+{
+    const size_t iterations = 100000;
+    for (const size_t maxSize : {size_t(1), size_t(64), size_t(iterations)})
+    {
+        deflect::MTQueue<size_t> queue(maxSize);
+        size_t sum = 0;
+
+        Timer timer;
+        timer.start();
+        std::thread consumer([&queue, &sum] {
+            for (size_t i = 0; i < iterations; ++i)
+                sum += queue.dequeue();
+        });
+        for (size_t i = 0; i < iterations; ++i)
+            queue.enqueue(i);
+        consumer.join();
+        report("mtqueue", "max_size=" + std::to_string(maxSize), iterations,
+               timer.elapsed(), sizeof(size_t));
+        BOOST_CHECK_EQUAL(sum, iterations * (iterations - 1) / 2);
+    }
+}
@@ -0,0 +1,105 @@
+/*********************************************************************/
+/* Copyright (c) 2017, EPFL/Blue Brain Project                       */
+/* All rights reserved.                                              */
+/*                                                                   */
+/* Redistribution and use in source and binary forms, with or        */
+/* without modification, are permitted provided that the following   */
+/* conditions are met:                                               */
+/*                                                                   */
+/*   1. Redistributions of source code must retain the above         */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer.                                                  */
+/*                                                                   */
+/*   2. Redistributions in binary form must reproduce the above      */
+/*      copyright notice, this list of conditions and the following  */
+/*      disclaimer in the documentation and/or other materials       */
+/*      provided with the distribution.                              */
+/*                                                                   */
+/*    THIS  SOFTWARE IS PROVIDED  BY THE  UNIVERSITY OF  TEXAS AT    */
+/*    AUSTIN  ``AS IS''  AND ANY  EXPRESS OR  IMPLIED WARRANTIES,    */
+/*    INCLUDING, BUT  NOT LIMITED  TO, THE IMPLIED  WARRANTIES OF    */
+/*    MERCHANTABILITY  AND FITNESS FOR  A PARTICULAR  PURPOSE ARE    */
+/*    DISCLAIMED.  IN  NO EVENT SHALL THE UNIVERSITY  OF TEXAS AT    */
+/*    AUSTIN OR CONTRIBUTORS BE  LIABLE FOR ANY DIRECT, INDIRECT,    */
+/*    INCIDENTAL,  SPECIAL, EXEMPLARY,  OR  CONSEQUENTIAL DAMAGES    */
+/*    (INCLUDING, BUT  NOT LIMITED TO,  PROCUREMENT OF SUBSTITUTE    */
+/*    GOODS  OR  SERVICES; LOSS  OF  USE,  DATA,  OR PROFITS;  OR    */
+/*    BUSINESS INTERRUPTION) HOWEVER CAUSED  AND ON ANY THEORY OF    */
+/*    LIABILITY, WHETHER  IN CONTRACT, STRICT  LIABILITY, OR TORT    */
+/*    (INCLUDING NEGLIGENCE OR OTHERWISE)  ARISING IN ANY WAY OUT    */
+/*    OF  THE  USE OF  THIS  SOFTWARE,  EVEN  IF ADVISED  OF  THE    */
+/*    POSSIBILITY OF SUCH DAMAGE.                                    */
+/*                                                                   */
+/* The views and conclusions contained in the software and           */
+/* documentation are those of the authors and should not be          */
+/* interpreted as representing official policies, either expressed   */
+/* or implied, of The University of Texas at Austin.                 */
+/*********************************************************************/
+
+#define BOOST_TEST_MODULE ReceiveBuffer
+#include <boost/test/unit_test.hpp>
+namespace ut = boost::unit_test;
+
+#include "Timer.h"
+
+#include <deflect/ReceiveBuffer.h>
+#include <deflect/Segment.h>
+
+#include <iostream>
+
+// Measures the cost of assembling frames in the ReceiveBuffer for an increasing
+// number of sources, each contributing one segment per frame as in sort-first
+// parallel rendering. The time per frame should grow linearly with the number
+// of sources.
+
+#define NFRAMES (100u)
+#define MAX_SOURCES (1024u)
+#define SEGMENT_SIZE (64u)
+
+namespace
+{
+deflect::Segment makeSegment(const size_t sourceIndex)
+{
+    deflect::Segment segment;
+    segment.parameters.x = (sourceIndex % 32) * SEGMENT_SIZE;
+    segment.parameters.y = (sourceIndex / 32) * SEGMENT_SIZE;
+    segment.parameters.width = SEGMENT_SIZE;
+    segment.parameters.height = SEGMENT_SIZE;
+    segment.imageData = QByteArray(SEGMENT_SIZE * SEGMENT_SIZE, 'x');
+    return segment;
+}
+}
+
+BOOST_AUTO_TEST_CASE(receiveBufferScalesWithSources)
+{
+    for (size_t sources = 1; sources <= MAX_SOURCES; sources *= 2)
+    {
+        deflect::ReceiveBuffer buffer;
+        std::vector<deflect::Segment> segments;
+        for (size_t i = 0; i < sources; ++i)
+        {
+            buffer.addSource(i);
+            segments.push_back(makeSegment(i));
+        }
+
+        Timer timer;
+        timer.start();
+        for (size_t frame = 0; frame < NFRAMES; ++frame)
+        {
+            for (size_t i = 0; i < sources; ++i)
+            {
+                buffer.insert(segments[i], i);
+                buffer.finishFrameForSource(i);
+                // the dispatcher checks for a complete frame after each source
+                if (buffer.hasCompleteFrame())
+                    BOOST_REQUIRE_EQUAL(buffer.popFrame().size(), sources);
+            }
+        }
+        const float time = timer.elapsed();
+
+        std::cout << "Sources: " << sources << ", time per frame: "
+                  << time / NFRAMES * 1000.f << " ms, per source: "
+                  << time / NFRAMES / sources * 1000000.f << " us"
+                  << std::endl;
+    }
+}
@@ -41,20 +41,72 @@
 
 #include <deflect/ImageSegmenter.h>
 #include <deflect/Segment.h>
+#include <deflect/Server.h>
 #include <deflect/Stream.h>
-#include <deflect/StreamPrivate.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <random>
 #include <string>
+#include <thread>
 
+#include <QCoreApplication>
 #include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QMutexLocker>
+#include <QRegion>
 
 #include <boost/program_options.hpp>
 
+// Load generator for a Deflect server: launches several concurrent streams,
+// each made of several sources sending synthetic content from their own
+// thread, and reports the throughput and frame latency percentiles of each
+// stream. With --server, the frames are received by a Server running in this
+// process, which also gives the end-to-end latency of the dispatched frames.
+
 #define MEGABYTE 1000000
 #define MICROSEC 1000000
+#define TILE_SIZE 512
+#define SCROLL_SPEED 4 // pixels per frame for the text content
+#define SQUARE_SIZE 128
+#define SQUARE_SPEED 16 // pixels per frame for the partial content
+
+/** The synthetic content sent by each source. */
+enum class Content
+{
+    noise,   /**< Random pixels, identical for every frame */
+    still,   /**< A smooth gradient, identical for every frame */
+    text,    /**< Lines of glyph-like blocks scrolling up */
+    partial, /**< A square moving over a still background, sent as tiles */
+    video    /**< Moving patterns and noise, changing every pixel */
+};
+
+namespace
+{
+bool parseContent(const std::string& name, Content& content)
+{
+    static const std::map<std::string, Content> contents = {
+        {"noise", Content::noise},
+        {"static", Content::still},
+        {"text", Content::text},
+        {"partial", Content::partial},
+        {"video", Content::video}};
+
+    const auto it = contents.find(name);
+    if (it == contents.end())
+        return false;
+    content = it->second;
+    return true;
+}
+}
 
 struct BenchmarkOptions
 {
@@ -65,6 +117,12 @@ struct BenchmarkOptions
         , height(0)
         , nframes(0)
         , framerate(0)
+        , port(deflect::Stream::defaultPortNumber)
+        , streams(1)
+        , sources(1)
+        , content(Content::noise)
+        , server(false)
+        , json(false)
         , compress(false)
         , precompute(false)
         , quality(0)
@@ -81,19 +139,34 @@ struct BenchmarkOptions
         desc.add_options()
             ("help", "produce help message")
             ("id", value<std::string>()->default_value("BenchmarkStreamer"),
-                     "identifier for the stream")
-            ("width", value<unsigned int>()->default_value(0),
-                     "width of the stream in pixel")
-            ("height", value<unsigned int>()->default_value(0),
-                     "height of the stream in pixel")
+                     "identifier for the stream, suffixed by its index if "
+                     "there are several streams")
+            ("width", value<unsigned int>()->default_value(1920),
+                     "width of each source in pixel")
+            ("height", value<unsigned int>()->default_value(1080),
+                     "height of each source in pixel")
             ("nframes", value<unsigned int>()->default_value(0),
                      "number of frames")
             ("framerate", value<unsigned int>()->default_value(0),
                      "framerate at which to send frames (default: unlimited)")
             ("host", value<std::string>()->default_value("localhost"),
                      "Target Deflect server host")
+            ("port", value<unsigned short>()->default_value(
+                         deflect::Stream::defaultPortNumber),
+                     "Target Deflect server port")
+            ("streams", value<unsigned int>()->default_value(1),
+                     "number of concurrent streams")
+            ("sources", value<unsigned int>()->default_value(1),
+                     "number of sources per stream, placed side by side")
+            ("content", value<std::string>()->default_value("noise"),
+                     "content of the images: noise, static, text, partial or "
+                     "video")
+            ("server", "receive the frames with a Server in this process "
+                       "instead of the one on --host")
+            ("json", "print the report in JSON")
             ("compress", "compress segments using jpeg")
-            ("precompute", "send precomputed segments (no encoding time)")
+            ("precompute", "send precomputed segments (no encoding time). "
+                           "Only for noise or static content")
             ("quality", value<unsigned int>()->default_value(80),
                      "quality of the jpeg compression. Only used if combined"
                      "with --compress")
@@ -126,9 +199,28 @@ struct BenchmarkOptions
         nframes = vm["nframes"].as<unsigned int>();
         framerate = vm["framerate"].as<unsigned int>();
         host = vm["host"].as<std::string>();
+        port = vm["port"].as<unsigned short>();
+        streams = std::max(vm["streams"].as<unsigned int>(), 1u);
+        sources = std::max(vm["sources"].as<unsigned int>(), 1u);
+        server = vm.count("server");
+        json = vm.count("json");
         compress = vm.count("compress");
         precompute = vm.count("precompute");
         quality = vm["quality"].as<unsigned int>();
+
+        if (!parseContent(vm["content"].as<std::string>(), content))
+        {
+            std::cerr << "unknown content: " << vm["content"].as<std::string>()
+                      << std::endl;
+            getHelp = true;
+        }
+        if (precompute && content != Content::noise &&
+            content != Content::still)
+        {
+            std::cerr << "--precompute requires noise or static content"
+                      << std::endl;
+            getHelp = true;
+        }
     }
 
     boost::program_options::options_description desc;
@@ -139,77 +231,327 @@ struct BenchmarkOptions
     unsigned int nframes;
     unsigned int framerate;
     std::string host;
+    unsigned short port;
+    unsigned int streams;
+    unsigned int sources;
+    Content content;
+    bool server;
+    bool json;
     bool compress;
     bool precompute;
     unsigned int quality;
 };
 
-namespace deflect
+namespace
 {
-namespace test
+/** The latencies in milliseconds of the frames of a stream. */
+using Latencies = std::vector<float>;
+
+float percentile(Latencies latencies, const float p)
 {
+    if (latencies.empty())
+        return 0.f;
+    std::sort(latencies.begin(), latencies.end());
+    const size_t rank = std::ceil(p / 100.f * latencies.size());
+    return latencies[std::max<size_t>(rank, 1) - 1];
+}
+
+QJsonObject toJson(const Latencies& latencies)
+{
+    QJsonObject object;
+    object["frames"] = int(latencies.size());
+    object["p50"] = percentile(latencies, 50.f);
+    object["p95"] = percentile(latencies, 95.f);
+    object["p99"] = percentile(latencies, 99.f);
+    object["max"] = percentile(latencies, 100.f);
+    return object;
+}
+
 /**
- * Stream image segments for benchmarking purposes.
+ * Generate the images of a Content, deterministic for a given seed.
  */
-class Application
+class ContentGenerator
 {
 public:
-    explicit Application(const BenchmarkOptions& options)
-        : _options(options)
-        , _stream(new deflect::Stream(options.id, options.host))
+    ContentGenerator(const Content content, const unsigned int width,
+                     const unsigned int height, const unsigned int seed)
+        : _content(content)
+        , _image(width, height, QImage::Format_RGBA8888)
+        , _rng(seed)
     {
-        generateNoiseImage(_options.width, _options.height);
-        generateJpegSegments();
-
-        std::cout << "Image dimensions :        " << _noiseImage.width()
-                  << " x " << _noiseImage.height() << std::endl;
-        std::cout << "Raw image size [Mbytes]:  "
-                  << (float)imageDataSize() / MEGABYTE << std::endl;
-        std::cout << "Jpeg image size [Mbytes]: "
-                  << (float)jpegSegmentsSize() / MEGABYTE << std::endl;
-        std::cout << "#segments per image :     " << _jpegSegments.size()
-                  << std::endl;
+        _image.fill(Qt::white);
+        if (_content == Content::text)
+            _generatePage();
     }
 
-    size_t imageDataSize() const
+    const QImage& image() const { return _image; }
+
+    /** Update the image for a frame. @return the region which changed. */
+    QRegion update(const size_t frame)
     {
-        return 4 * _noiseImage.width() * _noiseImage.height();
+        switch (_content)
+        {
+        case Content::noise:
+            if (frame == 0)
+                _fillNoise();
+            break;
+        case Content::still:
+            if (frame == 0)
+                _fillGradient(_image.rect());
+            break;
+        case Content::text:
+            _scrollPage(frame);
+            break;
+        case Content::partial:
+            return _moveSquare(frame);
+        case Content::video:
+            _fillMotion(frame);
+            break;
+        }
+        return QRegion(_image.rect());
     }
 
-    size_t jpegSegmentsSize() const
+private:
+    const Content _content;
+    QImage _image;
+    QImage _page;
+    std::minstd_rand _rng;
+    QRect _square;
+
+    void _fillNoise()
     {
-        size_t size = 0;
+        uchar* data = _image.bits();
+        for (int i = 0; i < _image.byteCount(); ++i)
+            data[i] = _rng();
+    }
 
-        for (deflect::Segments::const_iterator it = _jpegSegments.begin();
-             it != _jpegSegments.end(); ++it)
+    void _fillGradient(const QRect& rect)
+    {
+        const int width = _image.width();
+        const int height = _image.height();
+        for (int y = rect.top(); y <= rect.bottom(); ++y)
         {
-            size += it->imageData.size();
+            uchar* pixel = _image.scanLine(y) + rect.left() * 4;
+            for (int x = rect.left(); x <= rect.right(); ++x)
+            {
+                *pixel++ = x * 255 / width;
+                *pixel++ = y * 255 / height;
+                *pixel++ = 128;
+                *pixel++ = 255;
+            }
         }
+    }
 
-        return size;
+    // Rows of dark blocks of varying widths on white, like lines of text, on
+    // a page a few times higher than the image.
+    void _generatePage()
+    {
+        const int lineHeight = 16;
+        const int glyphHeight = 10;
+        std::uniform_int_distribution<int> glyphWidth(4, 10);
+        std::uniform_int_distribution<int> wordLength(2, 9);
+
+        _page = QImage(_image.width(), _image.height() * 4,
+                       QImage::Format_RGBA8888);
+        _page.fill(Qt::white);
+        for (int line = 0; line + lineHeight <= _page.height();
+             line += lineHeight)
+        {
+            int x = 8;
+            while (x < _page.width() - 8)
+            {
+                const int glyphs = wordLength(_rng);
+                for (int i = 0; i < glyphs && x < _page.width() - 8; ++i)
+                {
+                    const int w = std::min(glyphWidth(_rng), _page.width() - x);
+                    const QRect glyph(x, line + 3, w - 1, glyphHeight);
+                    for (int y = glyph.top(); y <= glyph.bottom(); ++y)
+                        std::fill_n(_page.scanLine(y) + glyph.left() * 4,
+                                    glyph.width() * 4, uchar(32));
+                    x += w;
+                }
+                x += 8;
+            }
+        }
     }
 
-    void generateNoiseImage(const int width, const int height)
+    void _scrollPage(const size_t frame)
     {
-        _noiseImage = QImage(width, height, QImage::Format_RGB32);
+        const size_t rowSize = _image.width() * 4;
+        const size_t offset = frame * SCROLL_SPEED;
+        for (int y = 0; y < _image.height(); ++y)
+        {
+            const int row = (offset + y) % _page.height();
+            std::copy_n(_page.constScanLine(row), rowSize, _image.scanLine(y));
+        }
+    }
+
+    QRegion _moveSquare(const size_t frame)
+    {
+        if (frame == 0)
+            _fillGradient(_image.rect());
 
-        uchar* data = _noiseImage.bits();
-        const size_t dataSize = imageDataSize();
+        const int range = std::max(_image.width() - SQUARE_SIZE, 1);
+        const int x = (frame * SQUARE_SPEED) % range;
+        const int y = (_image.height() - SQUARE_SIZE) / 2;
+        const QRect square = QRect(x, y, SQUARE_SIZE, SQUARE_SIZE) &
+                             _image.rect();
 
-        for (size_t i = 0; i < dataSize; ++i)
-            data[i] = rand();
+        QRegion changed(square);
+        if (_square.isValid())
+        {
+            _fillGradient(_square);
+            changed += _square;
+        }
+        for (int row = square.top(); row <= square.bottom(); ++row)
+            std::fill_n(_image.scanLine(row) + square.left() * 4,
+                        square.width() * 4, uchar(200));
+        _square = square;
+        return frame == 0 ? QRegion(_image.rect()) : changed;
     }
 
-    bool generateJpegSegments()
+    void _fillMotion(const size_t frame)
     {
-        deflect::ImageSegmenter segmenter;
-        segmenter.setNominalSegmentDimensions(512, 512);
-        deflect::ImageWrapper deflectImage((const void*)_noiseImage.bits(),
-                                           _noiseImage.width(),
-                                           _noiseImage.height(), deflect::RGBA);
+        std::uniform_int_distribution<int> noise(0, 15);
+        for (int y = 0; y < _image.height(); ++y)
+        {
+            uchar* pixel = _image.scanLine(y);
+            for (int x = 0; x < _image.width(); ++x)
+            {
+                *pixel++ = (x + 4 * frame + noise(_rng)) & 0xff;
+                *pixel++ = (y + 2 * frame + noise(_rng)) & 0xff;
+                *pixel++ = ((x + y) / 2 + 8 * frame) & 0xff;
+                *pixel++ = 255;
+            }
+        }
+    }
+};
 
-        deflectImage.compressionPolicy = deflect::COMPRESSION_ON;
+/** Lets the sources wait for each other before sending. */
+class Barrier
+{
+public:
+    explicit Barrier(const size_t count)
+        : _count(count)
+    {
+    }
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (--_count == 0)
+            _condition.notify_all();
+        else
+            _condition.wait(lock, [this] { return _count == 0; });
+    }
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    size_t _count;
+};
+
+/**
+ * One source of a stream, sending its part of the image from its own thread.
+ */
+class Source
+{
+public:
+    Source(const BenchmarkOptions& options, const std::string& id,
+           const unsigned int index)
+        : _options(options)
+        , _id(id)
+        , _x(index * options.width)
+        , _content(options.content, options.width, options.height,
+                   index + 1)
+    {
+    }
+
+    const std::string& id() const { return _id; }
+    size_t frames() const { return _frames; }
+    size_t pixels() const { return _pixels; }
+    const Latencies& latencies() const { return _latencies; }
+
+    /** Connect to the server; all sources must do so before sending. */
+    bool connect()
+    {
+        try
+        {
+            _stream.reset(
+                new deflect::Stream(_id, _options.host, _options.port));
+        }
+        catch (const std::runtime_error& e)
+        {
+            std::cerr << "Could not connect " << _id << ": " << e.what()
+                      << std::endl;
+            return false;
+        }
+        if (_options.precompute)
+            _precompute();
+        return _stream->isConnected();
+    }
+
+    void disconnect() { _stream.reset(); }
+
+    /** Send a frame. @return false if the stream was closed. */
+    bool send(const size_t frame)
+    {
+        const QRegion changed = _content.update(frame);
+
+        Timer timer;
+        timer.start();
+        size_t pixels = 0;
+        bool success = false;
+        if (_options.precompute)
+            success = _sendPrecomputed(pixels);
+        else if (_options.content == Content::partial && frame > 0)
+            success = _sendTiles(changed, pixels);
+        else if (_options.content == Content::partial)
+            success = _sendImage(deflect::FrameUpdate::keyframe, pixels);
+        else
+            success = _sendImage(deflect::FrameUpdate::full, pixels);
+
+        if (!success)
+            return false;
+        _latencies.push_back(timer.elapsed() * 1000.f);
+        _pixels += pixels;
+        ++_frames;
+        return true;
+    }
+
+private:
+    const BenchmarkOptions& _options;
+    const std::string _id;
+    const unsigned int _x;
+    ContentGenerator _content;
+    std::unique_ptr<deflect::Stream> _stream;
+    deflect::Segments _jpegSegments;
+    std::vector<QImage> _tiles;
+
+    size_t _frames = 0;
+    size_t _pixels = 0;
+    Latencies _latencies;
+
+    deflect::ImageWrapper _wrap(const QImage& image, const QPoint& pos) const
+    {
+        deflect::ImageWrapper deflectImage((const void*)image.constBits(),
+                                           image.width(), image.height(),
+                                           deflect::RGBA, _x + pos.x(),
+                                           pos.y());
+        deflectImage.compressionPolicy = _options.compress
+                                             ? deflect::COMPRESSION_ON
+                                             : deflect::COMPRESSION_OFF;
         deflectImage.compressionQuality = _options.quality;
+        return deflectImage;
+    }
+
+    void _precompute()
+    {
+        _content.update(0);
+        deflect::ImageSegmenter segmenter;
+        segmenter.setNominalSegmentDimensions(TILE_SIZE, TILE_SIZE);
+        auto deflectImage = _wrap(_content.image(), QPoint());
+        deflectImage.compressionPolicy = deflect::COMPRESSION_ON;
 
         static QMutex lock;
         const auto appendHandler = [&](const deflect::Segment& segment) {
@@ -217,62 +559,196 @@ public:
             _jpegSegments.push_back(segment);
             return true;
         };
+        segmenter.generate(deflectImage, appendHandler);
+    }
 
-        return segmenter.generate(deflectImage, appendHandler);
+    bool _sendPrecomputed(size_t& pixels)
+    {
+        pixels = _content.image().width() * _content.image().height();
+        auto sent = _stream->send(_jpegSegments);
+        return _stream->finishFrame().get() && sent.get();
+    }
+
+    bool _sendImage(const deflect::FrameUpdate update, size_t& pixels)
+    {
+        const QImage& image = _content.image();
+        pixels = image.width() * image.height();
+        const auto deflectImage = _wrap(image, QPoint());
+        if (update == deflect::FrameUpdate::full)
+            return _stream->sendAndFinish(deflectImage).get();
+
+        auto sent = _stream->send(deflectImage);
+        return _stream->finishFrame(update).get() && sent.get();
     }
 
-    bool send()
+    // Send the tiles of the keyframe's segment grid which changed; the server
+    // keeps the others.
+    bool _sendTiles(const QRegion& changed, size_t& pixels)
     {
-        if (_options.compress)
+        const QImage& image = _content.image();
+        std::vector<deflect::Stream::Future> futures;
+        _tiles.clear();
+        _tiles.reserve((image.width() / TILE_SIZE + 1) *
+                       (image.height() / TILE_SIZE + 1));
+        for (int y = 0; y < image.height(); y += TILE_SIZE)
         {
-            if (_options.precompute)
-                return sendPrecompressedJpeg();
-            else
-                return sendJpeg();
+            for (int x = 0; x < image.width(); x += TILE_SIZE)
+            {
+                const QRect tile =
+                    QRect(x, y, TILE_SIZE, TILE_SIZE) & image.rect();
+                if (!changed.intersects(tile))
+                    continue;
+
+                _tiles.push_back(image.copy(tile));
+                futures.push_back(
+                    _stream->send(_wrap(_tiles.back(), tile.topLeft())));
+                pixels += tile.width() * tile.height();
+            }
         }
-
-        return sendRaw();
+        bool success =
+            _stream->finishFrame(deflect::FrameUpdate::partial).get();
+        for (auto& future : futures)
+            success = future.get() && success;
+        return success;
     }
+};
 
-    bool sendRaw()
-    {
-        deflect::ImageWrapper deflectImage((const void*)_noiseImage.bits(),
-                                           _noiseImage.width(),
-                                           _noiseImage.height(), deflect::RGBA);
-        deflectImage.compressionPolicy = deflect::COMPRESSION_OFF;
+using SourcePtr = std::unique_ptr<Source>;
 
-        return _stream->sendAndFinish(deflectImage).get();
-    }
+/** The frames dispatched by the in-process server, per stream. */
+struct ReceivedFrames
+{
+    size_t count = 0;
+    Latencies latencies;
+};
+using ReceivedFramesMap = std::map<std::string, ReceivedFrames>;
 
-    bool sendJpeg()
-    {
-        deflect::ImageWrapper deflectImage((const void*)_noiseImage.bits(),
-                                           _noiseImage.width(),
-                                           _noiseImage.height(), deflect::RGBA);
-        deflectImage.compressionPolicy = deflect::COMPRESSION_ON;
-        deflectImage.compressionQuality = _options.quality;
+void receiveFrames(deflect::Server& server, ReceivedFramesMap& received)
+{
+    QObject::connect(&server, &deflect::Server::pixelStreamOpened, &server,
+                     [&server](const QString uri) {
+                         server.requestFrame(uri);
+                     });
+    QObject::connect(&server, &deflect::Server::receivedFrame, &server,
+                     [&server, &received](deflect::FramePtr frame) {
+                         auto& frames = received[frame->uri.toStdString()];
+                         ++frames.count;
+                         const auto captured = frame->timestamps.captured;
+                         if (captured > 0)
+                         {
+                             const auto now = deflect::currentTimestamp();
+                             frames.latencies.push_back((now - captured) /
+                                                        1000.f);
+                         }
+                         server.requestFrame(frame->uri);
+                     });
+}
+
+void sendFrames(const BenchmarkOptions& options, Source& source,
+                Barrier& barrier)
+{
+    const bool connected = source.connect();
+    barrier.wait();
+    if (!connected)
+        return;
 
-        return _stream->sendAndFinish(deflectImage).get();
+    size_t counter = 0;
+    bool streamOpen = true;
+    while (streamOpen && (options.nframes == 0 || counter < options.nframes))
+    {
+        if (options.framerate)
+            std::this_thread::sleep_for(
+                std::chrono::microseconds(MICROSEC / options.framerate));
+        streamOpen = source.send(counter);
+        ++counter;
     }
+    source.disconnect();
+}
 
-    bool sendPrecompressedJpeg()
+QJsonObject makeReport(const BenchmarkOptions& options,
+                       const std::vector<SourcePtr>& sources,
+                       const ReceivedFramesMap& received, const float time)
+{
+    QJsonArray streams;
+    size_t totalPixels = 0;
+    for (size_t i = 0; i < sources.size(); i += options.sources)
     {
-        for (deflect::Segments::const_iterator it = _jpegSegments.begin();
-             it != _jpegSegments.end(); ++it)
+        const std::string& id = sources[i]->id();
+        size_t frames = sources[i]->frames();
+        size_t pixels = 0;
+        Latencies latencies;
+        for (size_t j = i; j < i + options.sources; ++j)
         {
-            if (!_stream->_impl->sendWorker._sendSegment(*it))
-                return false;
+            const Source& source = *sources[j];
+            frames = std::min(frames, source.frames());
+            pixels += source.pixels();
+            latencies.insert(latencies.end(), source.latencies().begin(),
+                             source.latencies().end());
         }
-
-        return _stream->finishFrame().get();
+        totalPixels += pixels;
+
+        QJsonObject stream;
+        stream["id"] = QString::fromStdString(id);
+        stream["frames"] = int(frames);
+        stream["fps"] = frames / time;
+        stream["megapixels_per_s"] = pixels / time / MEGABYTE;
+        stream["mbytes_per_s"] = 4 * pixels / time / MEGABYTE;
+        stream["send_latency_ms"] = toJson(latencies);
+        const auto it = received.find(id);
+        if (it != received.end())
+        {
+            stream["frames_received"] = int(it->second.count);
+            stream["latency_ms"] = toJson(it->second.latencies);
+        }
+        streams.append(stream);
     }
 
-private:
-    const BenchmarkOptions& _options;
-    QImage _noiseImage;
-    std::unique_ptr<deflect::Stream> _stream;
-    deflect::Segments _jpegSegments;
-};
+    static const char* contents[] = {"noise", "static", "text", "partial",
+                                     "video"};
+    QJsonObject report;
+    report["content"] = contents[int(options.content)];
+    report["compress"] = options.compress;
+    report["precompute"] = options.precompute;
+    report["width"] = int(options.width);
+    report["height"] = int(options.height);
+    report["sources_per_stream"] = int(options.sources);
+    report["framerate"] = int(options.framerate);
+    report["time"] = time;
+    report["megapixels_per_s"] = totalPixels / time / MEGABYTE;
+    report["mbytes_per_s"] = 4 * totalPixels / time / MEGABYTE;
+    report["streams"] = streams;
+    return report;
+}
+
+void printReport(const QJsonObject& report)
+{
+    std::cout << "Target framerate: " << report["framerate"].toInt()
+              << std::endl;
+    std::cout << "Time: " << report["time"].toDouble() << std::endl;
+    std::cout << "Input throughput [Mbytes/sec]: "
+              << report["mbytes_per_s"].toDouble() << std::endl;
+
+    for (const auto value : report["streams"].toArray())
+    {
+        const auto stream = value.toObject();
+        const auto send = stream["send_latency_ms"].toObject();
+        std::cout << stream["id"].toString().toStdString() << ": "
+                  << stream["frames"].toInt() << " frames, "
+                  << stream["fps"].toDouble() << " FPS, send latency [ms] "
+                  << "p50 " << send["p50"].toDouble() << " p95 "
+                  << send["p95"].toDouble() << " p99 "
+                  << send["p99"].toDouble();
+        if (stream.contains("latency_ms"))
+        {
+            const auto latency = stream["latency_ms"].toObject();
+            std::cout << ", " << stream["frames_received"].toInt()
+                      << " received, latency [ms] p50 "
+                      << latency["p50"].toDouble() << " p95 "
+                      << latency["p95"].toDouble() << " p99 "
+                      << latency["p99"].toDouble();
+        }
+        std::cout << std::endl;
+    }
 }
 }
 
@@ -286,34 +762,53 @@ int main(int argc, char** argv)
         return 0;
     }
 
-    deflect::test::Application benchmarkStreamer(options);
+    std::unique_ptr<QCoreApplication> app;
+    std::unique_ptr<deflect::Server> server;
+    ReceivedFramesMap received;
+    if (options.server)
+    {
+        app.reset(new QCoreApplication(argc, argv));
+        server.reset(new deflect::Server(options.port));
+        receiveFrames(*server, received);
+    }
 
-    Timer timer;
-    timer.start();
+    std::vector<SourcePtr> sources;
+    for (unsigned int i = 0; i < options.streams; ++i)
+    {
+        const std::string id = options.streams > 1
+                                   ? options.id + "_" + std::to_string(i)
+                                   : options.id;
+        for (unsigned int j = 0; j < options.sources; ++j)
+            sources.emplace_back(new Source(options, id, j));
+    }
 
-    size_t counter = 0;
+    Barrier barrier(sources.size());
+    std::atomic<size_t> running(sources.size());
+    std::vector<std::thread> threads;
 
-    bool streamOpen = true;
-    while (streamOpen && (options.nframes == 0 || counter < options.nframes))
+    Timer timer;
+    timer.start();
+    for (auto& source : sources)
     {
-        if (options.framerate)
-            std::this_thread::sleep_for(
-                std::chrono::microseconds(MICROSEC / options.framerate));
-        streamOpen = benchmarkStreamer.send();
-        ++counter;
+        Source* sourcePtr = source.get();
+        threads.emplace_back([&, sourcePtr] {
+            sendFrames(options, *sourcePtr, barrier);
+            if (--running == 0 && app)
+                QMetaObject::invokeMethod(app.get(), "quit",
+                                          Qt::QueuedConnection);
+        });
     }
-
+    if (app)
+        app->exec();
+    for (auto& thread : threads)
+        thread.join();
     const float time = timer.elapsed();
 
-    const size_t frameSize = options.compress
-                                 ? benchmarkStreamer.jpegSegmentsSize()
-                                 : benchmarkStreamer.imageDataSize();
-
-    std::cout << "Target framerate: " << options.framerate << std::endl;
-    std::cout << "Time to send " << counter << " frames: " << time << std::endl;
-    std::cout << "Time per frame: " << time / counter << std::endl;
-    std::cout << "Throughput [Mbytes/sec]: "
-              << counter * frameSize / time / MEGABYTE << std::endl;
+    const auto report = makeReport(options, sources, received, time);
+    if (options.json)
+        std::cout << QJsonDocument(report).toJson().toStdString();
+    else
+        printReport(report);
 
     return 0;
 }
@@ -138,5 +138,9 @@ void DeflectServer::waitForMessage()
 void DeflectServer::processEvent(const deflect::Event& event)
 {
     BOOST_REQUIRE(_eventReceiver);
-    _eventReceiver->processEvent(event);
+
+    // the receiver lives in the server thread, queue the events in order
+    QMetaObject::invokeMethod(_eventReceiver, "processEvent",
+                              Qt::QueuedConnection,
+                              Q_ARG(deflect::Event, event));
 }
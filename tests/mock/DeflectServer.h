@@ -58,8 +58,25 @@ public:
     ~DeflectServer();
 
     quint16 serverPort() const { return _server->serverPort(); }
-    void requestFrame(QString uri) { _server->requestFrame(uri); }
+    void requestFrame(QString uri)
+    {
+        // process the request in the server thread like the other requests
+        QMetaObject::invokeMethod(_server, "requestFrame", Q_ARG(QString, uri));
+    }
     void waitForMessage();
+    void setSegmentDecoding(const deflect::SegmentDecoding decoding)
+    {
+        _server->setSegmentDecoding(decoding);
+    }
+    void setMaxStreamBufferSize(const size_t bytes)
+    {
+        _server->setMaxStreamBufferSize(bytes);
+    }
+
+    void setViewHiddenTimeout(const int ms)
+    {
+        _server->setViewHiddenTimeout(ms);
+    }
 
     size_t getReceivedFrames() const { return _receivedFrames; }
     size_t getOpenedStreams() const { return _openedStreams; }
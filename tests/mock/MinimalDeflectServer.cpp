@@ -41,9 +41,10 @@
 
 #include <deflect/NetworkProtocol.h>
 
-MinimalDeflectServer::MinimalDeflectServer(const int32_t versionOffset)
+MinimalDeflectServer::MinimalDeflectServer(const int32_t versionOffset,
+                                           const QByteArray& data)
 {
-    _server = new MockServer(NETWORK_PROTOCOL_VERSION + versionOffset);
+    _server = new MockServer(NETWORK_PROTOCOL_VERSION + versionOffset, data);
     _server->moveToThread(&_thread);
     _server->connect(&_thread, &QThread::finished, _server,
                      &QObject::deleteLater);
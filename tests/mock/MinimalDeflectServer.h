@@ -47,7 +47,8 @@
 class MinimalDeflectServer
 {
 public:
-    explicit MinimalDeflectServer(int32_t versionOffset = 0);
+    explicit MinimalDeflectServer(int32_t versionOffset = 0,
+                                  const QByteArray& data = QByteArray());
     ~MinimalDeflectServer();
 
     quint16 serverPort() const { return _server->serverPort(); }
@@ -41,8 +41,9 @@
 
 #include <QTcpSocket>
 
-MockServer::MockServer(const int32_t protocolVersion)
+MockServer::MockServer(const int32_t protocolVersion, const QByteArray& data)
     : _protocolVersion(protocolVersion)
+    , _data(data)
 {
     if (!listen())
         qDebug("MockServer could not start listening!!");
@@ -59,5 +60,6 @@ void MockServer::incomingConnection(const qintptr handle)
 
     // Handshake -> send network protocol version
     tcpSocket.write((char*)&_protocolVersion, sizeof(int32_t));
+    tcpSocket.write(_data);
     tcpSocket.flush();
 }
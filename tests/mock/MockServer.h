@@ -47,6 +47,7 @@ typedef __int32 int32_t;
 #include <deflect/config.h>
 #include <deflect/mock/api.h>
 
+#include <QByteArray>
 #include <QtNetwork/QTcpServer>
 
 class MockServer : public QTcpServer
@@ -54,7 +55,12 @@ class MockServer : public QTcpServer
     Q_OBJECT
 
 public:
-    DEFLECT_API explicit MockServer(int32_t protocolVersion);
+    /**
+     * @param protocolVersion sent to the clients upon connection
+     * @param data optional bytes sent to the clients after the version
+     */
+    DEFLECT_API explicit MockServer(int32_t protocolVersion,
+                                    const QByteArray& data = QByteArray());
     DEFLECT_API virtual ~MockServer();
 
 protected:
@@ -62,6 +68,7 @@ protected:
 
 private:
     int32_t _protocolVersion;
+    QByteArray _data;
 };
 
 #endif